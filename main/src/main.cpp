@@ -14,8 +14,13 @@
 #include <boost/beast/http.hpp>
 #include <boost/dll.hpp>
 #include <boost/filesystem.hpp>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
 #include <cstdint>
 #include <iostream>
+#include <string_view>
+#include <system_error>
 #include <thread>
 #include <vector>
 
@@ -29,6 +34,7 @@ using Server = STNL::Server;
 using Request = STNL::Request;
 using Middleware = STNL::Middleware;
 using DB = STNL::DB;
+using PoolOptions = STNL::PoolOptions;
 using Blueprint = STNL::Blueprint;
 using SrBlueprint = STNL::SrBlueprint;
 
@@ -42,7 +48,8 @@ class BasicMiddleware : public Middleware {
     void Setup() override { Logger::Inf() << ("BasicMiddleware::Setup()"); }
 };
 
-auto main(int /*argc*/, char ** /*argv*/) -> int {
+auto main(int argc, char **argv) -> int {
+    Logger::Start(STNL::LoggerOptions::FromConfig("logger"));
     asio::io_context ioc;
 
     static constexpr int DEFAULT_SERVER_PORT = 8080;
@@ -66,14 +73,40 @@ auto main(int /*argc*/, char ** /*argv*/) -> int {
     if (serverPort) { endpoint.port(serverPort.value()); }
     Logger::Inf() << ("::main:: Server listening on " + endpoint.address().to_string() + ":" + std::to_string(endpoint.port()));
 
-    Server server{ioc, endpoint, Config::GetRootDirPath()};
+    Server server{ioc, endpoint, Config::GetRootDirPath(), STNL::ListenerOptions::FromConfig("server")};
 
     server.Use<BasicMiddleware>();
     std::string connStr = DB::GetConnectionString(*dbName, *dbUser, *dbPassword, *dbHost, *dbPort, *dbSchema);
-    server.AddDatabase("default", connStr);
+    // read replicas are listed as "host" or "host:port" and share the primary's credentials
+    std::vector<std::string> replicas = Config::Value<std::vector<std::string>>("database.replicas", std::vector<std::string>{}).value_or(std::vector<std::string>{});
+    std::vector<std::string> replicaConnStrs;
+    for (std::string const &replica : replicas) {
+        size_t colon = replica.rfind(':');
+        std::string host = colon == std::string::npos ? replica : replica.substr(0, colon);
+        int port = *dbPort;
+        if (colon != std::string::npos) {
+            std::string_view const portText = std::string_view(replica).substr(colon + 1);
+            auto [end, ec] = std::from_chars(portText.data(), portText.data() + portText.size(), port);
+            if (ec != std::errc{} || end != portText.data() + portText.size() || port <= 0 || port > 65535 || host.empty()) {
+                Logger::Err() << "::main:: database.replicas: \"" << replica << "\" is not \"host\" or \"host:port\"";
+                return 1;
+            }
+        }
+        replicaConnStrs.emplace_back(DB::GetConnectionString(*dbName, *dbUser, *dbPassword, host, port, *dbSchema));
+    }
+    server.AddDatabase("default", connStr, replicaConnStrs, PoolOptions::FromConfig("database.pool"));
 
     // add migration to the database that will later run when the server starts
     auto pDB = server.GetDatabase();
+    pDB->GetQueryCache().SetMaxEntries(static_cast<size_t>(Config::Value<int>("database.queryCache.maxEntries", 1024).value_or(1024)));
+    auto cacheChannel = Config::Value<std::string>("database.queryCache.invalidationChannel", std::string(""));
+    if (cacheChannel && !cacheChannel->empty()) { pDB->InvalidateCacheOnNotify(*cacheChannel); }
+    pDB->SetStickyAfterWrite(std::chrono::milliseconds(Config::Value<int>("database.stickyAfterWriteMs", 1000).value_or(1000)));
+    // pool limits and timeouts follow config reloads; connection settings need a restart
+    Config::OnChange([pDB](STNL::ConfigSnapshot const &snapshot) {
+        pDB->ReconfigurePools(PoolOptions::FromConfig("database.pool"));
+        pDB->SetStickyAfterWrite(std::chrono::milliseconds(snapshot.Get<int>("database.stickyAfterWriteMs").value_or(1000)));
+    });
     pDB->GetMigration().Table("asset", [](Blueprint &bp) {
         bp.BigInt("id").Identity().Index();
         bp.UUID("uuid").NotNull().Default().Unique();
@@ -91,20 +124,26 @@ auto main(int /*argc*/, char ** /*argv*/) -> int {
 
     server.AddModule<App>();
     server.AddModule<Ticker>();
+
+    // `app --migrate-plan` prints the pending schema changes and exits without applying them
+    if (argc > 1 && std::string_view(argv[1]) == "--migrate-plan") {
+        std::cout << server.PlanDatabaseMigrations();
+        return 0;
+    }
     server.Run();
 
-    // Get the max threads = the number of logical cores
+    // Get the max threads = the number of logical cores. With accept shards the sessions run
+    // on the shards' own threads and ioc only serves databases, timers and modules.
     unsigned int numThreads = std::thread::hardware_concurrency();
+    if (server.GetShardCount() > 0) { numThreads = static_cast<unsigned int>(std::max(Config::Value<int>("server.ioThreads", 2).value_or(2), 1)); }
     if (numThreads == 0) { numThreads = 1; }
 
-    // init Logger io context before starting threads
-    Logger::Init(ioc);
-
     std::vector<std::thread> threads;
     threads.reserve(numThreads);
     for (unsigned int i = 0; i < numThreads; ++i) {
         threads.emplace_back([&ioc] { ioc.run(); });
     }
-    /* Wait for threads **/
+    /* Wait for threads; they return once SIGINT or SIGTERM has drained the server (Server::Stop) **/
     for (std::thread &t : threads) { t.join(); }
+    Logger::Stop();
 }
\ No newline at end of file
@@ -60,11 +60,10 @@ auto App::ApiGetProduct(Request const &req) -> http::message_generator {
     std::shared_ptr<DB> pDB = server_.GetDatabase("default");
     boost::json::object reqData = req.data();
     boost::json::object queryData = req.query();
-    QResult r = pDB->Exec("SELECT * FROM product LIMIT 10");
-    boost::json::object resData;
-    resData["result"] = r.ok;
-    resData["data"] = pDB->ConvertPQXXResultToJson(r.data);
-    return Server::Response(req, resData);
+    // served from the query cache; the serialized JSON is reused until the TTL expires or product is written
+    std::shared_ptr<std::string const> data = pDB->ExecCachedJson("SELECT * FROM product LIMIT 10", {.ttl = std::chrono::milliseconds(500), .tables = {"product"}});
+    if (!data) { return Server::ResponseJson(req, R"({"result":false,"data":[]})"); }
+    return Server::ResponseJson(req, std::format(R"({{"result":true,"data":{}}})", *data));
 }
 
 void App::SetupMigrations() {
@@ -3,6 +3,7 @@
 #include "modules/ticker/ticker.hpp"
 #include "stnl/core/logger.hpp"
 #include "stnl/core/stnl_module.hpp"
+#include "stnl/db/db.hpp"
 #include "stnl/http/server.hpp"
 
 using Logger = STNL::Logger;
@@ -30,6 +31,12 @@ auto Ticker::GetValue() const -> int {
 
 void Ticker::Setup() {
     Logger::Dbg() << ("Ticker::Setup()");
+    // NOTIFY ticker_reset; from any database session resets the counter
+    auto pDB = server_.GetDatabase();
+    if (pDB) {
+        std::shared_ptr<Ticker> self = shared_from_this();
+        pDB->Listen("ticker_reset", [self](STNL::DBNotification const & /*notification*/) { self->Reset(); });
+    }
 }
 
 void Ticker::Launch() {
@@ -4,10 +4,12 @@
 #include "stnl/core/stnl_module.hpp"
 #include "stnl/http/server.hpp"
 
+#include <memory>
+
 using Server = STNL::Server;
 using STNLModule = STNL::STNLModule;
 
-class Ticker : public STNLModule {
+class Ticker : public STNLModule, public std::enable_shared_from_this<Ticker> {
   public:
     inline static volatile const char sType{};
     Ticker(Server &server);
@@ -36,7 +36,7 @@ int main(int argc, char argv[]) {
     std::string connStr = DB::GetConnectionString(dbName, dbUser, dbPassword, dbHost, dbPort, dbSchema);
 
     asio::io_context ioc;
-    Logger::Init(ioc);
+    Logger::Start();
     DB db(connStr, ioc, 24, 24);
     // STNL::ConnectionPool pool{connStr, 4};
     // auto pCon = std::make_shared<pqxx::connection>("dbname=stnl_db
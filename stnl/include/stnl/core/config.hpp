@@ -8,23 +8,96 @@
 #include <boost/json.hpp>
 #include <boost/optional.hpp>
 
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace json = boost::json;
 namespace fs = boost::filesystem;
 
 namespace STNL {
 
+/**
+ * @brief Immutable view of a loaded config file.
+ *
+ * Every key path ("database.pool.maxSize") is indexed when the snapshot is built,
+ * so a lookup is one hash probe and returns a pointer into the parsed document
+ * instead of copying JSON objects level by level.
+ */
+class ConfigSnapshot {
+  public:
+    explicit ConfigSnapshot(json::value data);
+    ConfigSnapshot(const ConfigSnapshot &) = delete;
+    ConfigSnapshot &operator=(const ConfigSnapshot &) = delete;
+
+    // The value at `keyPath`, nullptr when a segment is missing.
+    json::value const *Find(std::string_view keyPath) const;
+    json::value const &Data() const { return data_; }
+
+    // boost::none when the key is missing or does not convert to T.
+    template <typename T>
+    boost::optional<T> Get(std::string_view keyPath) const {
+        json::value const *value = Find(keyPath);
+        if (value == nullptr) { return boost::none; }
+        return Convert<T>(*value, keyPath);
+    }
+
+    template <typename T>
+    static boost::optional<T> Convert(json::value const &value, std::string_view keyPath) {
+        try {
+            return json::value_to<T>(value);
+        } catch (const std::exception &e) { Logger::Err() << "Config::GetValue (\"" << keyPath << "\") conversion error: " << e.what(); }
+        return boost::none;
+    }
+
+  private:
+    struct KeyHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view key) const noexcept { return std::hash<std::string_view>{}(key); }
+    };
+
+    void Index(json::value const &value, std::string const &keyPath);
+
+    json::value data_;
+    std::unordered_map<std::string, json::value const *, KeyHash, std::equal_to<>> index_;
+};
+
 class Config {
 
   public:
+    // Called after a new snapshot is published, on the thread that reloaded.
+    using ChangeHandler = std::function<void(ConfigSnapshot const &)>;
+
     static auto Instance() -> Config&;
 
     static auto GetRootDirPath() -> fs::path const&;
 
+    // The current configuration. Snapshots are immutable; a reload publishes a new one and
+    // the old one is freed once the last holder lets go of it.
+    static std::shared_ptr<ConfigSnapshot const> Snapshot();
+    // Bumped each time a reloaded snapshot is published.
+    static uint64_t Generation();
+
+    // Parses the config file again and publishes it when it is valid; the current
+    // snapshot stays in place otherwise.
+    static bool Reload();
+    // Reloads when the file's modification time or size changed since it was loaded.
+    static bool ReloadIfChanged();
+
+    // Returns an id for Unsubscribe.
+    static size_t OnChange(ChangeHandler handler);
+    static void Unsubscribe(size_t id);
+
     template <typename T>
     static boost::optional<T> Value(const std::string &keyPath, boost::optional<T> defaultValue = boost::none) {
         return  Config::Instance().GetValue<T>(keyPath, defaultValue);
@@ -39,29 +112,29 @@ class Config {
     static std::unique_ptr<Config> instance_;
     static std::mutex initMutex_;
 
-    json::value data_;
+    // readers load `current_` without taking reloadMutex_ and pin the snapshot they got
+    std::atomic<std::shared_ptr<ConfigSnapshot const>> current_;
+    std::atomic<uint64_t> generation_{0};
+    std::mutex reloadMutex_;
+    std::map<size_t, ChangeHandler> subscribers_;
+    size_t nextSubscriberId_ = 0;
     fs::path rootDirPath_;
+    fs::path configPath_;
+    std::time_t configModified_ = 0;
+    uintmax_t configSize_ = 0;
     
     Config();
     bool LoadFromFile(const fs::path &configPath);
+    // Makes `snapshot` current; reloadMutex_ must be held.
+    void PublishLocked(std::shared_ptr<ConfigSnapshot const> snapshot);
 
 
     template <typename T>
     boost::optional<T> GetValue(const std::string &keyPath, boost::optional<T> defaultValue = boost::none) {
-        std::istringstream ss(keyPath);
-        std::string token;
-        json::value current = data_;
-        while (std::getline(ss, token, '.')) {
-            if (!current.is_object()) { return defaultValue; }
-            json::object obj = current.as_object();
-            auto it = obj.find(token);
-            if (it == obj.end()) { return defaultValue; }
-            current = it->value();
-        }
-        try {
-            return json::value_to<T>(current);
-        } catch (const std::exception &e) { Logger::Err() << ("Config::GetValue (\"" + keyPath + "\") conversion error: " + e.what()); }
-        return boost::none;
+        std::shared_ptr<ConfigSnapshot const> const snapshot = current_.load(std::memory_order_acquire);
+        json::value const *value = snapshot->Find(keyPath);
+        if (value == nullptr) { return defaultValue; }
+        return ConfigSnapshot::Convert<T>(*value, keyPath);
     }
 
     template <typename T>
@@ -73,6 +146,62 @@ class Config {
     Config(const Config &) = delete;
     Config &operator=(const Config &) = delete;
 };
+
+/**
+ * @brief Typed config value for lookups on hot paths, following reloads.
+ *
+ *   static ConfigValue<int64_t> const maxBodySize("http.maxBodySize", 10 * 1024 * 1024);
+ *   parser.body_limit(maxBodySize.Get());
+ *
+ * Get() compares the config generation and returns a copy of the converted value; the
+ * key is only looked up again after a reload, and the value it replaces is freed once no
+ * reader holds it.
+ */
+template <typename T>
+class ConfigValue {
+  public:
+    ConfigValue(std::string keyPath, T defaultValue) : keyPath_(std::move(keyPath)), default_(std::move(defaultValue)) {
+        std::scoped_lock lock(mutex_);
+        current_.store(ResolveLocked(), std::memory_order_release);
+    }
+    ConfigValue(const ConfigValue &) = delete;
+    ConfigValue &operator=(const ConfigValue &) = delete;
+
+    T Get() const {
+        std::shared_ptr<Resolved const> resolved = current_.load(std::memory_order_acquire);
+        if (resolved->generation != Config::Generation()) { resolved = Refresh(); }
+        return resolved->value;
+    }
+    T operator*() const { return Get(); }
+    std::string const &KeyPath() const { return keyPath_; }
+
+  private:
+    struct Resolved {
+        uint64_t generation;
+        T value;
+    };
+
+    std::shared_ptr<Resolved const> Refresh() const {
+        std::scoped_lock lock(mutex_);
+        std::shared_ptr<Resolved const> resolved = current_.load(std::memory_order_acquire);
+        if (resolved->generation == Config::Generation()) { return resolved; }
+        resolved = ResolveLocked();
+        current_.store(resolved, std::memory_order_release);
+        return resolved;
+    }
+
+    std::shared_ptr<Resolved const> ResolveLocked() const {
+        // the generation is read first: a reload in between only causes another refresh
+        uint64_t const generation = Config::Generation();
+        return std::make_shared<Resolved const>(Resolved{generation, Config::Value<T>(keyPath_, default_).value_or(default_)});
+    }
+
+    std::string keyPath_;
+    T default_;
+    mutable std::mutex mutex_; // serializes refreshes, Get only loads current_
+    mutable std::atomic<std::shared_ptr<Resolved const>> current_;
+};
+
 } // namespace STNL
 
-#endif // STNL_CONFIG_HPP
\ No newline at end of file
+#endif // STNL_CONFIG_HPP
@@ -0,0 +1,59 @@
+#ifndef STNL_HISTOGRAM_HPP
+#define STNL_HISTOGRAM_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace STNL {
+
+/**
+ * @brief Lock-free latency histogram with HDR-style log-linear buckets.
+ *
+ * Values are recorded in microseconds. Every power of two is split into
+ * SUB_BUCKETS linear sub-buckets, which bounds the relative error of a
+ * percentile to 1/SUB_BUCKETS while keeping a fixed, small footprint.
+ * Recording is three relaxed atomic increments, so it can stay enabled in
+ * production.
+ */
+class LatencyHistogram {
+  public:
+    static constexpr size_t SUB_BUCKET_BITS = 3;
+    static constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BUCKET_BITS;
+    static constexpr size_t MAX_EXPONENT = 36; // ~19h, larger values land in the last bucket
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKETS + ((MAX_EXPONENT - SUB_BUCKET_BITS) * SUB_BUCKETS);
+
+    LatencyHistogram() = default;
+    LatencyHistogram(LatencyHistogram const &) = delete;
+    LatencyHistogram &operator=(LatencyHistogram const &) = delete;
+
+    void Record(std::chrono::nanoseconds duration);
+    void RecordMicros(uint64_t micros);
+    // Adds the counts of `other`, e.g. to sum per-thread shards before rendering.
+    void Merge(LatencyHistogram const &other);
+
+    uint64_t Count() const;
+    uint64_t SumMicros() const;
+    // Upper bound of the bucket holding the q-th quantile (q in [0, 1]).
+    std::chrono::microseconds Percentile(double q) const;
+
+    // Appends `<name>_bucket`, `<name>_sum` and `<name>_count` lines in Prometheus text format.
+    // Bucket boundaries are emitted per power of two and in seconds. `labels` is either
+    // empty or a comma separated list such as `db="default",statement="exec"`.
+    void RenderPrometheus(std::string &out, std::string_view name, std::string_view labels) const;
+
+    static size_t BucketIndex(uint64_t micros);
+    static uint64_t BucketUpperBound(size_t index);
+
+  private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sumMicros_{0};
+};
+
+} // namespace STNL
+
+#endif // STNL_HISTOGRAM_HPP
@@ -1,22 +1,43 @@
 #ifndef STNL_LOGGER_HPP
 #define STNL_LOGGER_HPP
 
-#include <boost/asio.hpp>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
 #include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
-namespace asio = boost::asio;
+// Lowest level compiled in: 0 debug, 1 info, 2 warning, 3 error, 4 off. Records below it
+// are removed by the compiler when logged through the STNL_LOG_* macros.
+#ifndef STNL_LOG_LEVEL
+#define STNL_LOG_LEVEL 0
+#endif
 
 namespace STNL {
 
+enum class LogLevel : uint8_t { Debug = 0, Info = 1, Warning = 2, Error = 3, Off = 4 };
+
+inline constexpr LogLevel COMPILED_LOG_LEVEL = static_cast<LogLevel>(STNL_LOG_LEVEL);
+
 /**
  * @brief Temporary class designed to accumulate stream data (using <<) and
  * execute the final Logger::Log call upon destruction.
  */
 class LogStream {
   public:
-    // Constructor takes the log type (e.g., "DBG", "INF") and a reference to
-    // the Logger.
-    LogStream(std::string logType);
+    // Writes the timestamp and level prefix; a disabled stream ignores everything
+    // streamed into it.
+    LogStream(LogLevel level);
 
     // Copying the stream is usually undesirable, so we delete it.
     LogStream(const LogStream &) = delete;
@@ -25,36 +46,106 @@ class LogStream {
     // The destructor is the key: it executes the final log write.
     ~LogStream();
 
-    // The overloaded stream insertion operator. It's a template function
-    // to accept any type (T) that supports operator<<.
+    // Strings and numbers are appended directly, anything else goes through
+    // its operator<<.
     template <typename T>
     LogStream &operator<<(const T &msg) {
-        // Write the message part into the internal stringstream
-        buffer_ << msg;
+        if (!enabled_) { return *this; }
+        if constexpr (std::is_convertible_v<T const &, std::string_view>) {
+            buffer_.append(std::string_view(msg));
+        } else if constexpr (std::is_same_v<T, char>) {
+            buffer_.push_back(msg);
+        } else if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) {
+            char digits[32];
+            auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), msg);
+            buffer_.append(digits, ec == std::errc{} ? end : digits);
+        } else {
+            std::ostringstream oss;
+            oss << msg;
+            buffer_ += oss.str();
+        }
         return *this;
     }
 
   private:
-    std::stringstream buffer_;
-    std::string logType_;
-    // We need a way to reference the static Logger methods without being static
-    // itself. In the final implementation, we'll make the Logger::Log static
-    // and accessible.
+    bool enabled_;
+    std::string buffer_;
 };
 
+// Where and how the logger thread writes. Records wait in a bounded ring until the
+// logger thread writes them in batches, one write(2) per batch; when the ring is
+// full new records are dropped and counted rather than blocking the caller.
+struct LoggerOptions {
+    std::string file;                            // empty: stdout
+    size_t capacity = 8192;                      // records in the ring, rounded up to a power of two
+    size_t batchSize = 256;                      // records per write
+    std::chrono::milliseconds flushInterval{50}; // longest the logger thread sleeps while records may be pending
+    size_t rotateBytes = 64 * 1024 * 1024;       // file sinks: rotate once this size is reached, 0 never rotates
+    size_t rotateKeep = 5;                       // rotated files kept as <file>.1 .. <file>.<rotateKeep>
+    LogLevel level = LogLevel::Debug;            // records below are discarded, see Logger::SetLevel
+
+    // Reads "<keyPath>.file", "<keyPath>.capacity", "<keyPath>.batchSize", "<keyPath>.flushIntervalMs",
+    // "<keyPath>.rotateBytes", "<keyPath>.rotateKeep", "<keyPath>.level". Keys that are missing keep their default value.
+    static LoggerOptions FromConfig(std::string const &keyPath);
+};
+
+namespace detail {
+
+class LogBackend;
+
+// Arguments of a deferred record are copied next to it in the ring, strings by value
+// since the caller's buffers are gone by the time the logger thread formats them.
+template <typename T>
+using LogArg = std::conditional_t<std::is_convertible_v<std::decay_t<T> const &, std::string_view>, std::string, std::decay_t<T>>;
+
+inline constexpr size_t LOG_ARGS_BYTES = 160;
+
+// Formats the stored arguments into `out` and destroys them.
+using LogFormatFn = void (*)(std::string &out, std::string_view fmt, void *args);
+// Constructs the arguments in the record's storage from `source`.
+using LogEmplaceFn = void (*)(void *storage, void *source);
+
+template <typename Stored>
+inline constexpr bool FITS_LOG_RECORD = sizeof(Stored) <= LOG_ARGS_BYTES && alignof(Stored) <= alignof(std::max_align_t);
+
+template <typename Stored>
+void FormatLogArgs(std::string &out, std::string_view fmt, void *args) {
+    Stored *stored = std::launder(static_cast<Stored *>(args));
+    try {
+        std::apply([&out, fmt](auto const &...values) { std::vformat_to(std::back_inserter(out), fmt, std::make_format_args(values...)); }, *stored);
+    } catch (std::exception const &e) {
+        out += "<format error: ";
+        out += e.what();
+        out += '>';
+    }
+    stored->~Stored();
+}
+
+} // namespace detail
+
 /**
  * @brief The main Logger class, adapted to return a temporary LogStream object.
  */
 class Logger {
   public:
-    static void Init(asio::io_context &ioc);
-    static void Log(std::string msg);
-    // --- New Stream Accessor Methods ---
-    // These methods return a temporary LogStream object.
+    // Starts the logger thread. Until then, and after Stop, records are written
+    // synchronously by the calling thread. Once stopped, the logger cannot be started again.
+    static void Start(LoggerOptions const &options = {});
+    // Writes what is still queued and joins the logger thread.
+    static void Stop();
+    static void Log(std::string_view msg);
+    // Records dropped because the ring was full, since start.
+    static uint64_t Dropped();
+    // ANSI colors are used when writing to a terminal only.
+    static bool Colored();
+
+    static void SetLevel(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    static LogLevel Level() { return level_.load(std::memory_order_relaxed); }
+    // Folds to false for levels below STNL_LOG_LEVEL, one relaxed load otherwise.
+    static bool Enabled(LogLevel level) { return level >= COMPILED_LOG_LEVEL && level >= level_.load(std::memory_order_relaxed); }
+    static LogLevel LevelFromName(std::string_view name, LogLevel fallback = LogLevel::Debug);
 
-    // Note: The methods must be defined to return something that can be
-    // streamed to. We define a static function that returns a temporary
-    // LogStream object.
+    // These methods return a temporary LogStream object.
     static LogStream Dbg();
     static LogStream Inf();
     static LogStream Err();
@@ -65,15 +156,64 @@ class Logger {
     static void Err(std::string_view msg);
     static void Wrn(std::string_view msg);
 
-    // Private members remain
+    // std::format-style record. The arguments are copied into the ring and formatted on
+    // the logger thread; records whose arguments do not fit are formatted here.
+    template <typename... Args>
+    static void Write(LogLevel level, std::format_string<Args...> fmt, Args &&...args) {
+        if (!Enabled(level)) { return; }
+        using Stored = std::tuple<detail::LogArg<Args>...>;
+        if constexpr (detail::FITS_LOG_RECORD<Stored>) {
+            auto source = std::forward_as_tuple(std::forward<Args>(args)...);
+            Defer(level, fmt.get(), &detail::FormatLogArgs<Stored>,
+                  [](void *storage, void *src) {
+                      std::apply([storage](auto &&...values) { ::new (storage) Stored(std::forward<decltype(values)>(values)...); },
+                                 std::move(*static_cast<decltype(source) *>(src)));
+                  },
+                  &source);
+        } else {
+            Emit(level, std::vformat(fmt.get(), std::make_format_args(args...)));
+        }
+    }
+
   private:
     Logger() = delete;
-    static std::unique_ptr<asio::strand<asio::io_context::executor_type>> strand_;
 
-    // Static instance of the Logger class (needed for LogStream constructor)
-    static Logger instance_;
+    static void Defer(LogLevel level, std::string_view fmt, detail::LogFormatFn format, detail::LogEmplaceFn emplace, void *source);
+    static void Emit(LogLevel level, std::string_view msg);
+
+    inline static std::atomic<LogLevel> level_{LogLevel::Debug};
+};
+
+// A ring and logger thread of its own that writes lines as given, without prefix or
+// indentation, e.g. the access log kept apart from the application log.
+class LogChannel {
+  public:
+    explicit LogChannel(LoggerOptions const &options);
+    LogChannel(LogChannel const &) = delete;
+    LogChannel &operator=(LogChannel const &) = delete;
+    // Writes what is still queued and joins the thread.
+    ~LogChannel();
+
+    // False when the ring is full and the line was dropped.
+    bool Write(std::string_view line);
+    uint64_t Dropped() const;
+
+  private:
+    std::unique_ptr<detail::LogBackend> backend_;
 };
 
 } // namespace STNL
 
-#endif // STNL_LOGGER_HPP
\ No newline at end of file
+// The arguments are only evaluated when the level is enabled, and levels below
+// STNL_LOG_LEVEL compile to nothing:
+//   STNL_LOG_DBG("Migrator: {} column(s) differ on {}", count, table);
+#define STNL_LOG(level, ...)                                                                                                                                   \
+    do {                                                                                                                                                       \
+        if (::STNL::Logger::Enabled(level)) { ::STNL::Logger::Write(level, __VA_ARGS__); }                                                                     \
+    } while (false)
+#define STNL_LOG_DBG(...) STNL_LOG(::STNL::LogLevel::Debug, __VA_ARGS__)
+#define STNL_LOG_INF(...) STNL_LOG(::STNL::LogLevel::Info, __VA_ARGS__)
+#define STNL_LOG_WRN(...) STNL_LOG(::STNL::LogLevel::Warning, __VA_ARGS__)
+#define STNL_LOG_ERR(...) STNL_LOG(::STNL::LogLevel::Error, __VA_ARGS__)
+
+#endif // STNL_LOGGER_HPP
@@ -0,0 +1,126 @@
+#ifndef STNL_METRICS_HPP
+#define STNL_METRICS_HPP
+
+#include "stnl/core/histogram.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace STNL {
+
+namespace detail {
+
+inline constexpr size_t METRIC_SHARDS = 16;
+
+// Threads are spread over the shards round-robin on their first update, so threads of
+// the io_context pool each write to a cache line of their own.
+inline auto MetricShard() -> size_t {
+    static std::atomic<size_t> next{0};
+    thread_local size_t const shard = next.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return shard;
+}
+
+struct alignas(64) MetricCell {
+    std::atomic<int64_t> value{0};
+};
+
+// Starts each shard's histogram on a cache line of its own, so the hot counters at the
+// end of one shard and the start of the next are not shared between threads.
+struct alignas(64) HistogramCell {
+    LatencyHistogram histogram;
+};
+
+} // namespace detail
+
+// Monotonic count, one relaxed add on the calling thread's shard.
+class Counter {
+  public:
+    void Inc(uint64_t n = 1) { cells_[detail::MetricShard()].value.fetch_add(static_cast<int64_t>(n), std::memory_order_relaxed); }
+    uint64_t Value() const;
+
+  private:
+    std::array<detail::MetricCell, detail::METRIC_SHARDS> cells_{};
+};
+
+// Value that goes up and down, e.g. open sessions. Add/Sub are sharded like Counter;
+// Set is meant for a single writer and is not atomic with concurrent Add/Sub.
+class Gauge {
+  public:
+    void Add(int64_t n = 1) { cells_[detail::MetricShard()].value.fetch_add(n, std::memory_order_relaxed); }
+    void Sub(int64_t n = 1) { Add(-n); }
+    void Set(int64_t value);
+    int64_t Value() const;
+
+  private:
+    std::array<detail::MetricCell, detail::METRIC_SHARDS> cells_{};
+};
+
+// Latency distribution, one LatencyHistogram per shard merged when rendered.
+class Histogram {
+  public:
+    void Record(std::chrono::nanoseconds duration) { shards_[detail::MetricShard()].histogram.Record(duration); }
+    void RecordMicros(uint64_t micros) { shards_[detail::MetricShard()].histogram.RecordMicros(micros); }
+    // Sums the shards into `out`.
+    void Snapshot(LatencyHistogram &out) const;
+
+  private:
+    std::array<detail::HistogramCell, detail::METRIC_SHARDS> shards_;
+};
+
+/**
+ * @brief Registry of the counters, gauges and histograms exposed on the metrics route.
+ *
+ * Registering takes a lock and returns a reference that stays valid for the life of the
+ * registry, so callers look a metric up once and keep the reference for the hot path.
+ * Registering the same name and labels again returns the existing metric. `labels` is
+ * either empty or a comma separated list such as `route="/api/users",status="2xx"`.
+ */
+class Metrics {
+  public:
+    Metrics() = default;
+    Metrics(Metrics const &) = delete;
+    Metrics &operator=(Metrics const &) = delete;
+
+    Counter &AddCounter(std::string const &name, std::string const &help, std::string const &labels = {});
+    Gauge &AddGauge(std::string const &name, std::string const &help, std::string const &labels = {});
+    // Recorded in microseconds, rendered in seconds; name it `<...>_seconds`.
+    Histogram &AddHistogram(std::string const &name, std::string const &help, std::string const &labels = {});
+
+    // Appends every metric in Prometheus text format, families in name order.
+    void RenderPrometheus(std::string &out) const;
+
+  private:
+    enum class Type { Counter, Gauge, Histogram };
+
+    struct Series {
+        std::string labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    struct Family {
+        Type type;
+        std::string help;
+        std::vector<std::unique_ptr<Series>> series;
+    };
+
+    Series &GetSeries(std::string const &name, std::string const &help, std::string const &labels, Type type);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family, std::less<>> families_;
+};
+
+} // namespace STNL
+
+#endif // STNL_METRICS_HPP
@@ -7,7 +7,8 @@
 
 namespace STNL {
 
-class Server; // forward declaration
+class Server;  // forward declaration
+class Metrics; // forward declaration
 
 class STNLModule {
   public:
@@ -15,8 +16,13 @@ class STNLModule {
     virtual ~STNLModule() = default;
     STNLModule(Server &server);
     virtual void SetupMigrations() {};
+    // Register the module's metrics (Metrics::AddCounter, ...) and keep the references.
+    virtual void SetupMetrics(Metrics & /*metrics*/) {};
     virtual void Setup() {};
     virtual void Launch() {};
+    // Called by Server::Stop once no request is in flight: cancel the module's timers and
+    // other work on the io_context, or its threads never return.
+    virtual void Stop() {};
 
   protected:
     Server &server_;
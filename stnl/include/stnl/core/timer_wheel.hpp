@@ -0,0 +1,93 @@
+#ifndef STNL_TIMER_WHEEL_HPP
+#define STNL_TIMER_WHEEL_HPP
+
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace asio = boost::asio;
+
+namespace STNL {
+
+/**
+ * @brief Hashed timer wheel for coarse timeouts shared by many owners.
+ *
+ * One asio timer ticks the wheel; arming, re-arming and cancelling an Entry is a few
+ * pointer updates under a mutex, so a hundred thousand idle connections cost no
+ * asio timer each. Timeouts never fire before `timeout` has passed since Arm, and at most
+ * two ticks after it (one when `timeout` is a multiple of the tick).
+ *
+ *   TimerWheel::Entry entry;
+ *   entry.callback = [](uint64_t sequence) { ... };
+ *   uint64_t sequence = wheel.Arm(entry, std::chrono::seconds(15));
+ *
+ * The callback runs on the wheel's executor, outside of the wheel's lock, with the
+ * sequence Arm returned. An entry re-armed in the meantime gets a callback for a sequence
+ * that is no longer current, which the owner ignores. An Entry must be cancelled before
+ * it is destroyed.
+ */
+class TimerWheel {
+  public:
+    static constexpr std::chrono::milliseconds DEFAULT_TICK{100};
+    static constexpr size_t DEFAULT_SLOTS = 512;
+
+    class Entry {
+      public:
+        Entry() = default;
+        Entry(Entry const &) = delete;
+        Entry &operator=(Entry const &) = delete;
+
+        std::function<void(uint64_t sequence)> callback;
+
+      private:
+        friend class TimerWheel;
+        Entry *prev_ = nullptr;
+        Entry *next_ = nullptr;
+        size_t slot_ = 0;
+        uint64_t rounds_ = 0; // full turns of the wheel left before it fires
+        uint64_t sequence_ = 0;
+        bool linked_ = false;
+    };
+
+    explicit TimerWheel(asio::any_io_executor executor, std::chrono::milliseconds tick = DEFAULT_TICK, size_t slots = DEFAULT_SLOTS);
+    ~TimerWheel();
+    TimerWheel(TimerWheel const &) = delete;
+    TimerWheel &operator=(TimerWheel const &) = delete;
+
+    // Starts ticking on the executor; Stop (or destruction) ends it.
+    void Start();
+    void Stop();
+
+    // (Re)arms `entry` to fire after `timeout`, replacing a pending expiry. Returns the
+    // sequence passed to the callback.
+    uint64_t Arm(Entry &entry, std::chrono::milliseconds timeout);
+    void Cancel(Entry &entry);
+    size_t Size() const;
+
+    // Advances the wheel by one tick and runs the callbacks that came due; returns how
+    // many. Start calls it every tick, tests may call it directly.
+    size_t Tick();
+
+  private:
+    void ScheduleTick();
+    void LinkLocked(Entry &entry);
+    void UnlinkLocked(Entry &entry);
+
+    asio::steady_timer timer_;
+    std::chrono::milliseconds tick_;
+    std::vector<Entry *> slots_; // head of each slot's list
+    uint64_t cursor_ = 0;        // ticks so far
+    uint64_t nextSequence_ = 0;
+    size_t size_ = 0;
+    bool stopped_ = true;
+    mutable std::mutex mutex_;
+};
+
+} // namespace STNL
+
+#endif // STNL_TIMER_WHEEL_HPP
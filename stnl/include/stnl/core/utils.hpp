@@ -2,6 +2,7 @@
 #define STNL_CORE_UTILS_HPP
 
 #include <boost/asio.hpp>
+#include <cstdint>
 #include <future>
 #include <string>
 #include <vector>
@@ -19,6 +20,10 @@ namespace STNL {
     static auto StringCaseCmp(const std::string_view a, std::string_view b) -> bool;
     static auto FixIndent(const std::string_view s) -> std::string;
     static auto Join(std::vector<std::string> const &parts, std::string const &separator = ";") -> std::string;
+    // FNV-1a, 64 bit: stable across processes and builds, unlike std::hash
+    static auto Fnv1a64(std::string_view s) -> uint64_t;
+    // Standard alphabet with padding (RFC 4648).
+    static auto Base64Encode(std::string_view bytes) -> std::string;
     template <typename ResultType>
     static auto AsFuture(asio::io_context &ioc, std::function<ResultType()> fn) -> std::future<ResultType> {
         using TaskType = std::packaged_task<ResultType()>;
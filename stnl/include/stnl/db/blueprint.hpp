@@ -2,26 +2,34 @@
 #define STNL_DB_BLUEPRINT_HPP
 
 #include "stnl/db/column.hpp"
+#include "stnl/db/index_def.hpp"
+#include "stnl/db/partition_def.hpp"
 
 #include <boost/optional.hpp>
 
+#include <deque>
 #include <map>
 #include <string>
 #include <vector>
 
 namespace STNL {
-class BigIntProxy;    // Forward declaration
-class IntegerProxy;   // Forward declaration
-class SmallIntProxy;  // Forward declaration
-class NumericProxy;   // Forward declaration
-class BitProxy;       // Forward declaration
-class CharProxy;      // Forward declaration
-class VarcharProxy;   // Forward declaration
-class BooleanProxy;   // Forward declaration
-class DateProxy;      // Forward declaration
-class TimestampProxy; // Forward declaration
-class UUIDProxy;      // Forward declaration
-class TextProxy;      // Forward declaration
+class BigIntProxy;          // Forward declaration
+class IntegerProxy;         // Forward declaration
+class SmallIntProxy;        // Forward declaration
+class NumericProxy;         // Forward declaration
+class BitProxy;             // Forward declaration
+class CharProxy;            // Forward declaration
+class VarcharProxy;         // Forward declaration
+class BooleanProxy;         // Forward declaration
+class DateProxy;            // Forward declaration
+class TimestampProxy;       // Forward declaration
+class UUIDProxy;            // Forward declaration
+class TextProxy;            // Forward declaration
+class RealProxy;            // Forward declaration
+class DoublePrecisionProxy; // Forward declaration
+class JsonProxy;            // Forward declaration
+class JsonbProxy;           // Forward declaration
+class ByteaProxy;           // Forward declaration
 
 class Blueprint {
   public:
@@ -42,13 +50,39 @@ class Blueprint {
     auto Timestamp(const std::string &name) -> TimestampProxy;
     auto UUID(const std::string &name) -> UUIDProxy;
     auto Text(const std::string &name) -> TextProxy;
+    auto Real(const std::string &name) -> RealProxy;
+    auto DoublePrecision(const std::string &name) -> DoublePrecisionProxy;
+    auto Json(const std::string &name) -> JsonProxy;
+    auto Jsonb(const std::string &name) -> JsonbProxy;
+    auto Bytea(const std::string &name) -> ByteaProxy;
+
+    // Table level index over `columns` (names or expressions), e.g.
+    // bp.Index({"customer_id", "created_at"}).Include({"total"}).Where("deleted_at IS NULL");
+    // bp.Index({"created_at"}).Using(IndexMethod::Brin);
+    auto Index(std::vector<std::string> columns) -> IndexProxy;
+    auto GetIndexes() const -> std::deque<IndexDef> const &;
+    // Table level indexes plus the single column ones declared with Index()/Unique() on a column.
+    auto GetEffectiveIndexes() const -> std::vector<IndexDef>;
+
+    // Declarative partitioning, e.g. rolling monthly partitions kept for a year:
+    // bp.PartitionByRange({"created_at"}).Every(PartitionInterval::Month).Retain(12, true);
+    // bp.PartitionByList("region").Values("eu", {"'de'", "'fr'"}).Default();
+    // bp.PartitionByHash({"tenant_id"}).Modulus(8);
+    // Unique indexes of a partitioned table must contain every partition column.
+    auto PartitionByRange(std::vector<std::string> columns) -> PartitionProxy;
+    auto PartitionByList(std::string const &column) -> PartitionProxy;
+    auto PartitionByHash(std::vector<std::string> columns) -> PartitionProxy;
+    auto GetPartition() const -> PartitionDef const &;
 
     void AddColumn(Column &&col);
+    void AddIndex(IndexDef &&index);
 
   private:
     std::string tableName_;
     std::unordered_map<std::string, Column> columns_;
     std::vector<std::string> columnNames_;
+    std::deque<IndexDef> indexes_; // deque: IndexProxy keeps a reference while more are added
+    PartitionDef partition_;
 
     Column &GetOrAddColumn(const std::string &realName);
 };
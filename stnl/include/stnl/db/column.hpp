@@ -17,8 +17,13 @@ struct Column {
     bool index;
     bool unique;
     bool nullable;
-    unsigned short precision;
+    bool array;               // one dimensional array of `type`
+    unsigned short precision; // numeric precision, fractional second digits of a timestamp
     unsigned short scale;
+    // Timestamps only: the blueprint called Precision(). Without it the migrator keeps the
+    // column's precision; lowering it needs `narrowPrecision` as well.
+    bool explicitPrecision;
+    bool narrowPrecision;
     std::string defaultValue;
     Column(std::string tableName, const std::string &colRealName, SQLDataType colType);
 };
@@ -45,6 +50,11 @@ class ColumnProxy {
         return static_cast<Derived &>(*this);
     }
 
+    Derived &Array(bool v = true) {
+        col.array = v;
+        return static_cast<Derived &>(*this);
+    }
+
     virtual Derived &Default(std::string const &v) {
         col.defaultValue = std::string{v};
         return static_cast<Derived &>(*this);
@@ -120,6 +130,9 @@ class TimestampProxy : public ColumnProxy<TimestampProxy> {
     TimestampProxy(Column &c);
     TimestampProxy &Default(std::string const &v = "CURRENT_TIMESTAMP") override;
     auto Index(bool v = true) -> TimestampProxy &;
+    // Fractional second digits, 0 (the default for new columns) to 6. An existing column is
+    // only altered to a lower precision, which truncates stored values, with `narrow`.
+    auto Precision(unsigned short v, bool narrow = false) -> TimestampProxy &;
 };
 
 class UUIDProxy : public ColumnProxy<UUIDProxy> {
@@ -135,6 +148,31 @@ class TextProxy : public ColumnProxy<TextProxy> {
     TextProxy(Column &c);
 };
 
+class RealProxy : public ColumnProxy<RealProxy> {
+  public:
+    RealProxy(Column &c);
+};
+
+class DoublePrecisionProxy : public ColumnProxy<DoublePrecisionProxy> {
+  public:
+    DoublePrecisionProxy(Column &c);
+};
+
+class JsonProxy : public ColumnProxy<JsonProxy> {
+  public:
+    JsonProxy(Column &c);
+};
+
+class JsonbProxy : public ColumnProxy<JsonbProxy> {
+  public:
+    JsonbProxy(Column &c);
+};
+
+class ByteaProxy : public ColumnProxy<ByteaProxy> {
+  public:
+    ByteaProxy(Column &c);
+};
+
 } // namespace STNL
 
 #endif // STNL_DB_COLUMN_HPP
@@ -2,28 +2,139 @@
 #ifndef STNL_CONNECTION_POOL
 #define STNL_CONNECTION_POOL
 
+#include <boost/asio.hpp>
 #include <pqxx/pqxx>
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
-#include <vector>
+#include <unordered_map>
+
+namespace asio = boost::asio;
 
 namespace STNL {
-class ConnectionPool {
+
+struct PoolOptions {
+    size_t minIdle = 1;                                    // idle connections kept open and ready
+    size_t maxSize = 4;                                    // hard cap on open connections
+    std::chrono::milliseconds acquireTimeout{5000};        // how long GetConnection may wait
+    std::chrono::milliseconds idleTimeout{std::chrono::minutes(10)};  // idle connections above minIdle are closed after this
+    std::chrono::milliseconds maxLifetime{std::chrono::hours(1)};     // connections are recycled after this (0 = never)
+    std::chrono::milliseconds maintenanceInterval{std::chrono::seconds(5)};
+
+    // Reads "<keyPath>.minIdle", "<keyPath>.maxSize", "<keyPath>.acquireTimeoutMs",
+    // "<keyPath>.idleTimeoutMs", "<keyPath>.maxLifetimeMs" from Config.
+    // Keys that are missing keep their default value.
+    static PoolOptions FromConfig(std::string const &keyPath);
+};
+
+/**
+ * @brief Bounded pool of libpqxx connections.
+ *
+ * Connections are opened outside of the pool lock, checked for liveness when
+ * they are handed back and discarded (then lazily replaced) when broken, so a
+ * database restart does not leave dead connections behind.
+ *
+ * Must be owned by a std::shared_ptr: connects for async waiters run on a shared
+ * connector thread pool and only hold a weak reference to the pool.
+ */
+class ConnectionPool : public std::enable_shared_from_this<ConnectionPool> {
   public:
+    // Completion handler for AsyncGetConnection. `pConn` is nullptr whenever `ec` is set.
+    using AcquireHandler = std::function<void(boost::system::error_code ec, pqxx::connection *pConn)>;
+
+    // Point-in-time occupancy, taken under the pool lock.
+    struct Stats {
+        size_t idle = 0;
+        size_t inUse = 0;
+        size_t opening = 0;
+        size_t waiting = 0; // blocked GetConnection callers plus queued async waiters
+        size_t maxSize = 0;
+    };
+
     ConnectionPool(std::string connStr, size_t maxSize);
+    ConnectionPool(std::string connStr, PoolOptions options);
+    ~ConnectionPool();
+
+    // Opens connections until minIdle are ready. Blocks; meant for startup.
+    void WarmUp();
+    // Starts the periodic refill / idle reaping / lifetime recycling task. Its timer runs on
+    // `executor`, the connects that refill the pool run on the connector threads.
+    void StartMaintenance(asio::any_io_executor executor);
+    void StopMaintenance();
+    // Applies new limits and timeouts, e.g. after a config reload. Idle connections above
+    // the new maxSize are closed now; leased ones are dropped as they are handed back.
+    void Reconfigure(PoolOptions options);
+
+    // Blocks until a connection is available or the acquire timeout expires (nullptr).
     pqxx::connection *GetConnection();
-    void ReturnConnection(pqxx::connection *pConn);
+    pqxx::connection *GetConnection(std::chrono::milliseconds timeout);
+
+    // Never blocks the caller: `handler` is invoked on `executor` with a connection
+    // or with asio::error::timed_out once `timeout` has elapsed.
+    void AsyncGetConnection(asio::any_io_executor executor, std::chrono::milliseconds timeout, AcquireHandler handler);
+
+    // Hands a connection back. Connections flagged `broken` or found closed are
+    // dropped and their slot is released for a fresh connection.
+    void ReturnConnection(pqxx::connection *pConn, bool broken = false);
+
+    Stats GetStats();
 
   private:
+    struct PooledConnection {
+        std::unique_ptr<pqxx::connection> conn;
+        std::chrono::steady_clock::time_point createdAt;
+        std::chrono::steady_clock::time_point lastUsedAt;
+    };
+
+    struct AsyncWaiter {
+        AsyncWaiter(asio::any_io_executor ex, AcquireHandler h) : executor(std::move(ex)), handler(std::move(h)), timer(executor) {}
+        asio::any_io_executor executor;
+        AcquireHandler handler;
+        asio::steady_timer timer;
+        std::chrono::steady_clock::time_point deadline;
+        bool done = false;
+    };
+
+    // Blocks, retrying with backoff until `deadline`; nullptr when no connection could be opened.
+    static std::unique_ptr<pqxx::connection> Connect(std::string const &connStr, std::chrono::steady_clock::time_point deadline);
+    bool IsAlive(PooledConnection const &pooled, std::chrono::steady_clock::time_point now) const;
+    bool IsExpired(PooledConnection const &pooled, std::chrono::steady_clock::time_point now) const;
+    pqxx::connection *LeaseLocked(PooledConnection pooled);
+    static PooledConnection NewPooled(std::unique_ptr<pqxx::connection> conn);
+    void ScheduleMaintenance();
+    void RunMaintenance();
+    // Opens one idle connection if below minIdle; false when nothing was opened.
+    bool RefillOne(std::chrono::steady_clock::time_point deadline);
+    // Runs on the connector; `pool` may be gone by the time the connection is open. An `idle`
+    // connection taken for the waiter is validated first and only replaced when it is dead.
+    static void OpenForWaiter(std::weak_ptr<ConnectionPool> const &pool, std::string const &connStr, std::shared_ptr<AsyncWaiter> const &waiter,
+                              std::shared_ptr<PooledConnection> const &idle = nullptr);
+    void CompleteWaiter(std::shared_ptr<AsyncWaiter> const &waiter, boost::system::error_code ec, pqxx::connection *pConn);
+    void OnWaiterTimeout(std::shared_ptr<AsyncWaiter> const &waiter);
+    // Hands idle connections (or free slots) to queued async waiters; poolMutex_ must be held.
+    void ServeWaitersLocked();
+    size_t TotalLocked() const;
+
     std::string connStr_;
-    std::vector<std::unique_ptr<pqxx::connection>> pool_;
+    std::deque<PooledConnection> idle_; // most recently used at the back
+    std::unordered_map<pqxx::connection *, PooledConnection> leased_;
+    std::deque<std::shared_ptr<AsyncWaiter>> waiters_;
     std::mutex poolMutex_;
     std::condition_variable poolCondition_;
-    size_t maxSize_;
-    size_t size_;
+    PoolOptions options_;
+    // options_.maxLifetime, read by IsExpired outside of the lock
+    std::atomic<int64_t> maxLifetimeMs_{0};
+    size_t opening_;
+    size_t blockedWaiters_ = 0;
+    std::unique_ptr<asio::steady_timer> maintenanceTimer_;
+    bool maintenanceStopped_ = false;
 };
 } // namespace STNL
 
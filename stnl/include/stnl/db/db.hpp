@@ -6,23 +6,32 @@
 #include "stnl/db/blueprint.hpp"
 #include "stnl/db/column.hpp"
 #include "stnl/db/connection_pool.hpp"
+#include "stnl/db/db_stats.hpp"
+#include "stnl/db/index_def.hpp"
 #include "stnl/db/inserter.hpp"
 #include "stnl/db/migration.hpp"
+#include "stnl/db/notification_listener.hpp"
+#include "stnl/db/query_cache.hpp"
 #include <boost/asio.hpp>
 #include <boost/json.hpp>
 #include <pqxx/pqxx>
 
+#include <atomic>
+#include <chrono>
 #include <functional>
 
 #include <future>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <thread>
 #include <type_traits> // Required for std::is_same_v
 #include <utility>     // for std::forward
+#include <vector>
 
 namespace asio = boost::asio;
 
@@ -34,17 +43,147 @@ struct QResult {
     std::string msg;
 };
 
+enum class IsolationLevel { ReadCommitted, RepeatableRead, Serializable };
+
+struct TxOptions {
+    IsolationLevel isolation = IsolationLevel::ReadCommitted;
+    bool readOnly = false;
+    bool deferrable = false; // only meaningful for read-only Serializable transactions
+    size_t maxRetries = 3;   // extra attempts after a serialization failure or deadlock
+    std::chrono::milliseconds retryBackoff{10}; // doubled on every retry, plus jitter
+    // SET LOCAL lock_timeout; 0 keeps the server's setting. When set, running into it
+    // (SQLSTATE 55P03) is retried like a serialization failure instead of waiting behind
+    // long transactions while queueing everyone else behind the pending lock.
+    std::chrono::milliseconds lockTimeout{0};
+};
+
+// Outcome of a transactional Work: `ok` is true only when the transaction committed.
+template <typename R>
+struct TxResult {
+    std::optional<R> value;
+    bool ok = false;
+    std::string msg;
+    size_t attempts = 0;
+};
+
+template <>
+struct TxResult<void> {
+    bool ok = false;
+    std::string msg;
+    size_t attempts = 0;
+};
+
+// Statements queued by a DB::Pipeline callback, sent together once it returns.
+class PipelineBatch {
+  public:
+    // Queues plain SQL; returns the index of its result in TxResult::value.
+    size_t Add(std::string sql) {
+        statements_.push_back(std::move(sql));
+        return statements_.size() - 1;
+    }
+
+  private:
+    friend class DB;
+    std::vector<std::string> statements_;
+};
+
 class DB {
 
   public:
+    // Where a statement may run. Auto runs on the primary and classifies the SQL (see
+    // IsReadOnlySQL) only to tell writes from reads; Read may go to a replica and has to be
+    // asked for explicitly. Write runs on the primary and makes the Consistency token it
+    // was passed sticky to it, Primary is a read that must not see replication lag.
+    enum class Intent { Auto, Read, Write, Primary };
+
+    // Read-your-writes token carried by the caller, e.g. one per user session. After a
+    // write made with it, reads made with it stay on the primary for the sticky window
+    // (SetStickyAfterWrite), whichever thread runs them. Thread-safe; statements made
+    // without a token are never held on the primary.
+    class Consistency {
+      public:
+        bool PrimaryRequired(std::chrono::steady_clock::time_point now) const {
+            return now.time_since_epoch().count() < primaryUntil_.load(std::memory_order_acquire);
+        }
+
+      private:
+        friend class DB;
+        std::atomic<std::chrono::steady_clock::rep> primaryUntil_{0};
+    };
+
     DB(std::string const &connStr, asio::io_context &ioc, size_t poolSize = 4, size_t numThreads = 4);
+    DB(std::string const &connStr, asio::io_context &ioc, PoolOptions const &poolOptions, size_t numThreads = 4);
+    // Primary plus read replicas, every node gets its own pool built from `poolOptions`.
+    DB(std::string const &primaryConnStr, std::vector<std::string> const &replicaConnStrs, asio::io_context &ioc, PoolOptions const &poolOptions,
+       size_t numThreads = 4);
     ~DB();
 
+    // Opens the pools' minIdle connections and starts their background maintenance.
+    void WarmUp();
+    // Stops the pools' maintenance and the notification listener and drops the work guard,
+    // so the threads running the io_context return once the queued queries are done.
+    // Called by Server::Stop; the destructor does it too, then joins the threads.
+    void Shutdown();
+    // Applies `poolOptions` to the primary's and every replica's pool (see ConnectionPool::Reconfigure).
+    void ReconfigurePools(PoolOptions const &poolOptions);
+
+    // After a write, reads made with the same Consistency token stay on the primary for
+    // this long so they observe their own writes despite replication lag. 0 disables it.
+    void SetStickyAfterWrite(std::chrono::milliseconds window);
+
     asio::io_context &GetIOC();
     QResult Exec(std::string_view qSQL, bool silent = true);
+    QResult Exec(std::string_view qSQL, Intent intent, bool silent = true);
+    QResult Exec(std::string_view qSQL, Intent intent, Consistency &consistency, bool silent = true);
     std::future<QResult> QExec(std::string_view qSQL, bool silent = true);
+    std::future<QResult> QExec(std::string_view qSQL, Intent intent, bool silent = true);
+    // `consistency` must outlive the returned future.
+    std::future<QResult> QExec(std::string_view qSQL, Intent intent, Consistency &consistency, bool silent = true);
 
     QResult ExecSQLCmd(std::string const &sqlCmdName, std::string const &sqlCmd, pqxx::params &params, bool silent = true);
+    QResult ExecSQLCmd(std::string const &sqlCmdName, std::string const &sqlCmd, pqxx::params &params, Intent intent, bool silent = true);
+    QResult ExecSQLCmd(std::string const &sqlCmdName, std::string const &sqlCmd, pqxx::params &params, Intent intent, Consistency &consistency,
+                       bool silent = true);
+
+    // True for statements that can safely run on a replica: SELECT/WITH/SHOW/VALUES/TABLE
+    // without data-modifying clauses (INSERT/UPDATE/DELETE/MERGE, FOR UPDATE/SHARE, SELECT INTO,
+    // nextval/setval) and without a second statement. Functions with side effects are not
+    // detected, which is why Auto does not send statements to replicas.
+    static bool IsReadOnlySQL(std::string_view qSQL);
+
+    // Opt-in result cache for read-only queries, see QueryCache. Results are served
+    // from memory until their TTL expires or a write through this DB touches one of their tables.
+    QResult ExecCached(std::string const &qSQL, CacheOptions const &options = {});
+    template <typename... Args>
+    QResult ExecCached(CacheOptions const &options, std::string const &qSQL, Args const &...args) {
+        return ExecCachedImpl(options, qSQL, pqxx::params{args...}, CacheKey(qSQL, {pqxx::to_string(args)...})).result;
+    }
+    // Same as ExecCached but returns ConvertPQXXResultToJson(data) already serialized;
+    // the JSON is built once per cache entry. nullptr when the query failed.
+    std::shared_ptr<std::string const> ExecCachedJson(std::string const &qSQL, CacheOptions const &options = {});
+    std::future<QResult> QExecCached(std::string qSQL, CacheOptions options = {});
+    QueryCache &GetQueryCache();
+
+    // Called once per fetched batch; return false to stop early.
+    using StreamBatchFn = std::function<bool(pqxx::result const &batch)>;
+    // Runs `qSQL` through a server-side cursor and hands the rows over in batches of
+    // `batchSize`, so memory stays bounded by one batch whatever the result size.
+    // The cursor lives in a read-only transaction on one pooled connection (a replica
+    // when available) for the whole stream. QResult::data is empty.
+    QResult Stream(std::string const &qSQL, size_t batchSize, StreamBatchFn const &onBatch);
+    QResult Stream(std::string const &qSQL, pqxx::params &params, size_t batchSize, StreamBatchFn const &onBatch);
+    // Same on a DB thread; `onBatch` runs there too.
+    std::future<QResult> QStream(std::string qSQL, size_t batchSize, StreamBatchFn onBatch);
+
+    // LISTEN on `channel` over a dedicated primary connection; `handler` runs on the
+    // io_context for every NOTIFY. Returns an id for Unlisten.
+    size_t Listen(std::string const &channel, NotificationHandler handler);
+    void Unlisten(size_t subscriptionId);
+    QResult Notify(std::string const &channel, std::string const &payload = "");
+    // Payloads received on `channel` name a table whose cached results are dropped
+    // (an empty payload or "*" clears the whole cache). Lets writers outside this
+    // process, e.g. triggers calling pg_notify, keep the query cache fresh.
+    size_t InvalidateCacheOnNotify(std::string const &channel);
 
     template <typename ResultType>
     std::future<ResultType> QFuture(std::function<ResultType()> fn) {
@@ -54,7 +193,14 @@ class DB {
     bool TableExists(std::string_view const tableName);
     std::vector<Column> GetTableColumns(std::string_view tableName = "");
     std::vector<std::string> GetTableIndexNames(std::string_view tableName);
+    // Indexes read from pg_index (not those backing a primary key or constraint), keyed by lower-case table name.
+    std::unordered_map<std::string, std::vector<IndexDef>> GetTableIndexes(std::string_view tableName = "");
+    // Partitions of every partitioned table (lower-case names), keyed by lower-case parent table name.
+    std::unordered_map<std::string, std::vector<std::string>> GetTablePartitions(std::string_view tableName = "");
     Blueprint QueryBlueprint(std::string_view tableName);
+    // Current blueprint of every table in the current schema, columns and indexes, keyed by
+    // lower-case name. Two catalog queries regardless of the number of tables.
+    std::unordered_map<std::string, Blueprint> QuerySchema();
     std::unordered_map<size_t /*oid*/, std::string /*typname*/> const &GetDataTypes();
     static boost::json::value RowToJson(pqxx::row const &row, std::unordered_map<size_t, std::string> const &dataTypes);
     boost::json::value ConvertPQXXResultToJson(pqxx::result const &result);
@@ -65,7 +211,7 @@ class DB {
         Inserter inserter;
         (inserter << ... << std::forward<Args>(columnValuePairs));
         auto [SQLCmd, params] = inserter.flush(tableName);
-        return ExecSQLCmd(std::format("sql_cmd_inert_{}", tableName), SQLCmd, params, S);
+        return ExecSQLCmd(std::format("sql_cmd_inert_{}", tableName), SQLCmd, params, Intent::Write, S);
     }
 
     template <bool S = true, typename... Args>
@@ -83,13 +229,126 @@ class DB {
     void Work(const std::function<void(pqxx::work &tx)> &doWorkFn);
     std::future<void> QWork(std::function<void(pqxx::work &tx)> doWork);
 
+    // Runs `doWorkFn` in a transaction configured by `options` and commits it. The whole
+    // transaction is re-run on serialization failures and deadlocks, so `doWorkFn` must
+    // not have side effects outside the database. Its return value ends up in TxResult::value.
+    template <typename R>
+    TxResult<R> Work(std::function<R(pqxx::work &tx)> const &doWorkFn, TxOptions const &options) {
+        if constexpr (std::is_void_v<R>) {
+            return RunTransaction("DB::Work", options, doWorkFn);
+        } else {
+            std::optional<R> value;
+            TxResult<void> r = RunTransaction("DB::Work", options, [&value, &doWorkFn](pqxx::work &tx) { value = doWorkFn(tx); });
+            return TxResult<R>{.value = r.ok ? std::move(value) : std::nullopt, .ok = r.ok, .msg = std::move(r.msg), .attempts = r.attempts};
+        }
+    }
+
+    // Like Work, on the DB threads; the back-off before a retry is waited on a timer, so no
+    // io thread sleeps through it.
+    template <typename R>
+    std::future<TxResult<R>> QWork(std::function<R(pqxx::work &tx)> doWorkFn, TxOptions options) {
+        auto promise = std::make_shared<std::promise<TxResult<R>>>();
+        std::future<TxResult<R>> future = promise->get_future();
+        if constexpr (std::is_void_v<R>) {
+            RunTransactionAsync("DB::QWork", options, std::move(doWorkFn), [promise](TxResult<void> r) { promise->set_value(std::move(r)); });
+        } else {
+            auto value = std::make_shared<std::optional<R>>();
+            RunTransactionAsync(
+                "DB::QWork", options, [value, doWorkFn = std::move(doWorkFn)](pqxx::work &tx) { *value = doWorkFn(tx); },
+                [promise, value](TxResult<void> r) {
+                    promise->set_value(TxResult<R>{.value = r.ok ? std::move(*value) : std::nullopt, .ok = r.ok, .msg = std::move(r.msg), .attempts = r.attempts});
+                });
+        }
+        return future;
+    }
+
+    /**
+     * Runs the statements `buildFn` adds to the batch in one transaction. They are queued
+     * while the callback runs and then written to the server in one go, their results
+     * read back as they arrive, so the batch costs about one round trip instead of one per
+     * statement. Plain SQL only; retried like Work, `buildFn` itself runs once.
+     *
+     *   auto r = db.Pipeline([](PipelineBatch &batch) {
+     *       batch.Add("UPDATE counters SET n = n + 1 WHERE id = 1");
+     *       batch.Add("SELECT n FROM counters WHERE id = 1");
+     *   });
+     */
+    TxResult<std::vector<pqxx::result>> Pipeline(std::function<void(PipelineBatch &batch)> const &buildFn, TxOptions const &options = {});
+    std::future<TxResult<std::vector<pqxx::result>>> QPipeline(std::function<void(PipelineBatch &batch)> const &buildFn, TxOptions options = {});
+
+    // Runs `qSQL` on the primary outside a transaction block, for statements that refuse
+    // to run inside one (CREATE/DROP INDEX CONCURRENTLY, batched backfills). Honors
+    // `options.lockTimeout`, `maxRetries` and `retryBackoff`; `beforeRetrySQL` runs ahead of
+    // every retry, e.g. to drop the invalid index a failed concurrent build leaves behind.
+    // Stats are recorded under "autocommit", not the statement text.
+    QResult ExecAutocommit(std::string_view qSQL, TxOptions const &options, std::string_view beforeRetrySQL = {});
+
     Migration &GetMigration();
+    // The primary's pool.
+    ConnectionPool &GetPool();
+    // Occupancy of every pool, named "primary", "replica0", "replica1", ...
+    std::vector<std::pair<std::string, ConnectionPool::Stats>> GetPoolStats();
+    size_t GetReplicaCount() const;
+    DBStats &GetStats();
 
     static std::string GetConnectionString(std::string_view dbName, std::string_view dbUser, std::string_view dbPassword, std::string_view dbHost = "localhost",
                                            size_t dbPort = 5432, std::string_view dbSchema = "public");
 
   private:
-    ConnectionPool pool_;
+    struct CachedQResult {
+        QResult result;
+        std::shared_ptr<QueryCache::Entry const> entry;
+    };
+    TxResult<void> RunTransaction(std::string_view caller, TxOptions const &options, std::function<void(pqxx::work &tx)> const &body);
+    // Runs the attempts of a transaction on ioc_ and waits out the back-offs between them on a timer.
+    void RunTransactionAsync(std::string caller, TxOptions options, std::function<void(pqxx::work &tx)> body, std::function<void(TxResult<void>)> done,
+                             size_t attempt = 0);
+    // One attempt; returns the back-off to wait before the next one, nullopt once the
+    // transaction committed or failed for good.
+    std::optional<std::chrono::milliseconds> AttemptTransaction(std::string_view caller, TxOptions const &options,
+                                                                std::function<void(pqxx::work &tx)> const &body, size_t attempt, TxResult<void> &txResult);
+
+    CachedQResult ExecCachedImpl(CacheOptions const &options, std::string const &qSQL, pqxx::params params, std::string const &key);
+    static std::string CacheKey(std::string const &qSQL, std::vector<std::string> const &params);
+    // Evicts cached results a write statement may have changed.
+    void InvalidateCacheFor(std::string_view qSQL);
+
+    struct Node {
+        Node(std::string n, std::string const &connStr, PoolOptions const &poolOptions)
+            : name(std::move(n)), pool(std::make_shared<ConnectionPool>(connStr, poolOptions)) {}
+        std::string name;
+        std::shared_ptr<ConnectionPool> pool;
+        std::atomic<size_t> inFlight{0}; // statements currently running on this node
+    };
+
+    // Resolves Auto, applies the read-your-writes stickiness of `consistency` and picks the
+    // replica with the fewest statements in flight. Returns the primary when there are no replicas.
+    Node &PickNode(Intent intent, std::string_view qSQL, Consistency *consistency = nullptr);
+    // Auto becomes Write, or Primary for statements IsReadOnlySQL accepts.
+    static Intent ResolveAuto(Intent intent, std::string_view qSQL);
+    QResult ExecOn(std::string_view qSQL, Intent intent, Consistency *consistency, bool silent);
+    QResult ExecSQLCmdOn(std::string const &sqlCmdName, std::string const &sqlCmd, pqxx::params &params, Intent intent, Consistency *consistency, bool silent);
+
+    // Leases a pooled connection, runs `fn` on it and maps any failure onto the
+    // returned QResult. Connections that broke mid-query are dropped by the pool.
+    // Acquire wait and run time are recorded in stats_ under `statement`, with the rows of
+    // qResult.data or, for results that never land there, the count `fn` leaves in `rows`.
+    // A replica that cannot hand out a connection within REPLICA_ACQUIRE_TIMEOUT falls
+    // back to the primary, which gets the pool's full acquire timeout.
+    QResult WithConnection(std::string_view caller, std::string_view statement, Node &node,
+                           const std::function<void(pqxx::connection &conn, QResult &qResult)> &fn, size_t const *rows = nullptr);
+
+    static constexpr std::chrono::milliseconds REPLICA_ACQUIRE_TIMEOUT{50};
+
+    std::vector<std::unique_ptr<Node>> nodes_; // [0] is the primary
+    std::string primaryConnStr_;
+    std::once_flag listenerOnce_;
+    std::shared_ptr<NotificationListener> listener_;
+    std::atomic<size_t> nextReplica_{0};
+    std::atomic<int64_t> stickyAfterWriteMs_{1000};
+    DBStats stats_;
+    // shared so notification handlers can hold it weakly, see InvalidateCacheOnNotify
+    std::shared_ptr<QueryCache> queryCache_ = std::make_shared<QueryCache>();
     asio::io_context &ioc_;
     asio::executor_work_guard<asio::io_context::executor_type> workGuard_;
     std::vector<std::thread> threadPool_;
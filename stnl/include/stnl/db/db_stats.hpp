@@ -0,0 +1,78 @@
+#ifndef STNL_DB_STATS_HPP
+#define STNL_DB_STATS_HPP
+
+#include "stnl/core/histogram.hpp"
+#include "stnl/db/connection_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace STNL {
+
+struct StatementStats {
+    LatencyHistogram latency;
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> rows{0};
+};
+
+struct StatementSnapshot {
+    std::string name;
+    uint64_t calls;
+    uint64_t errors;
+    uint64_t rows;
+    std::chrono::microseconds p50;
+    std::chrono::microseconds p99;
+    std::chrono::microseconds max;
+};
+
+/**
+ * @brief Per-database counters: pool acquire wait and per-statement latency.
+ *
+ * Statements are keyed by the name passed to DB::ExecSQLCmd (e.g.
+ * `sql_cmd_inert_{table}`), plain DB::Exec calls are grouped under `exec`.
+ * The statement table only takes a write lock the first time a name is seen.
+ */
+class DBStats {
+  public:
+    struct Entry {
+        std::string dbAlias;
+        DBStats const *stats;
+        std::vector<std::pair<std::string, ConnectionPool::Stats>> pools; // node name -> pool occupancy
+    };
+
+    void RecordAcquire(std::chrono::nanoseconds wait, bool acquired);
+    void RecordQuery(std::string_view statement, std::chrono::nanoseconds duration, size_t rows, bool ok);
+
+    LatencyHistogram const &AcquireWait() const;
+    uint64_t AcquireTimeouts() const;
+    std::vector<StatementSnapshot> Statements() const;
+
+    // Renders all databases at once so each metric family gets a single HELP/TYPE header.
+    static void RenderPrometheus(std::string &out, std::vector<Entry> const &entries);
+
+  private:
+    struct StringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>{}(s); }
+    };
+
+    StatementStats &Statement(std::string_view name);
+
+    mutable std::shared_mutex statementsMutex_;
+    std::unordered_map<std::string, std::unique_ptr<StatementStats>, StringHash, std::equal_to<>> statements_;
+    LatencyHistogram acquireWait_;
+    std::atomic<uint64_t> acquireTimeouts_{0};
+};
+
+} // namespace STNL
+
+#endif // STNL_DB_STATS_HPP
@@ -0,0 +1,57 @@
+#ifndef STNL_DB_INDEX_DEF_HPP
+#define STNL_DB_INDEX_DEF_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace STNL {
+
+enum class IndexMethod { BTree, Hash, Gin, Gist, Brin };
+
+// A table level index as declared on a Blueprint or read back from pg_index.
+struct IndexDef {
+    std::string name;                 // empty: derived from the table and key columns, see ResolvedName
+    std::vector<std::string> columns; // key columns or expressions, in order
+    std::vector<std::string> include; // INCLUDE (covering) columns, btree and gist only
+    std::string where;                // predicate of a partial index
+    IndexMethod method = IndexMethod::BTree;
+    bool unique = false;
+    // Introspected only: false for the leftover of a failed CREATE INDEX CONCURRENTLY,
+    // and the fingerprint the migrator stored in the index comment.
+    bool valid = true;
+    std::string fingerprint;
+
+    // "<table>_<col1>_<col2>_idx" ("_key" when unique), cut to PostgreSQL's 63 byte identifier limit.
+    std::string ResolvedName(std::string const &tableName) const;
+    // Throws std::invalid_argument for combinations PostgreSQL rejects.
+    void Validate() const;
+    // Stable hash of the definition, stored as the index comment when the migrator builds it.
+    std::string Fingerprint() const;
+    // True when `current` (introspected) already implements this definition. Indexes built by
+    // the migrator are compared by fingerprint, older ones structurally (plain indexes only).
+    bool Matches(IndexDef const &current) const;
+    bool References(std::string_view columnName) const;
+    // `tableName` may be "ONLY <parent>" to create the index on a partitioned table without its partitions.
+    std::string CreateSQL(std::string const &tableName, std::string const &indexName, bool concurrently, bool ifNotExists = false) const;
+
+    static char const *MethodName(IndexMethod method);
+    static IndexMethod MethodFromName(std::string_view name);
+};
+
+class IndexProxy {
+  public:
+    explicit IndexProxy(IndexDef &d);
+    auto Name(std::string name) -> IndexProxy &;
+    auto Unique(bool v = true) -> IndexProxy &;
+    auto Using(IndexMethod method) -> IndexProxy &;
+    auto Include(std::vector<std::string> columns) -> IndexProxy &;
+    auto Where(std::string predicate) -> IndexProxy &;
+
+  private:
+    IndexDef &def;
+};
+
+} // namespace STNL
+
+#endif // STNL_DB_INDEX_DEF_HPP
@@ -1,10 +1,12 @@
 #ifndef STNL_DB_INSERTER_HPP
 #define STNL_DB_INSERTER_HPP
 
+#include <boost/json.hpp>
 #include <pqxx/pqxx>
 
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -29,15 +31,21 @@ class Inserter {
     std::stringstream placeholderSS_;
     pqxx::params params_;
 
+    // Bytes (bytea) values are bound in binary format, boost::json values as their serialized text
+    // (json/jsonb columns), anything else through pqxx's string conversion.
     template <typename T>
-    void ProcessPair(std::string const &key, T value) {
+    void ProcessPair(std::string const &key, T const &value) {
         if (!isFirstPair_) {
             columnsSS_ << ',';
             placeholderSS_ << ',';
         } else {
             isFirstPair_ = false;
         }
-        params_.append(value);
+        if constexpr (std::is_same_v<T, boost::json::value> || std::is_same_v<T, boost::json::object> || std::is_same_v<T, boost::json::array>) {
+            params_.append(boost::json::serialize(value));
+        } else {
+            params_.append(value);
+        }
         columnsSS_ << key;
         placeholderSS_ << "$" + std::to_string(params_.size());
     }
@@ -4,45 +4,172 @@
 
 #include "stnl/db/blueprint.hpp"
 #include "stnl/db/column.hpp"
+#include "stnl/db/db.hpp"
+#include "stnl/db/index_def.hpp"
 #include "stnl/db/migration.hpp"
+#include "stnl/db/partition_def.hpp"
 #include "stnl/db/sr_blueprint.hpp"
 
 #include <pqxx/pqxx>
 
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace STNL {
 class DB;
 
+// Strongest table lock a migration statement takes.
+enum class LockLevel { ShareUpdateExclusive, AccessExclusive };
+
+struct MigrationStatement {
+    std::string sql;
+    LockLevel lock = LockLevel::AccessExclusive;
+    bool rewrite = false;    // rewrites or scans the whole table while holding `lock`
+    bool concurrent = false; // CONCURRENTLY, must run outside a transaction block
+    bool backfill = false;   // batched UPDATE, repeated until it touches no more rows
+    std::string beforeRetry; // runs before a retry, e.g. dropping the invalid index a failed concurrent build leaves
+};
+
+// Tunables for online migrations. Cheap statements of a table are batched into one
+// transaction; statements that rewrite or scan the table run in their own, and none of
+// them waits longer than `lockTimeout` for its lock before backing off and retrying.
+struct MigrationOptions {
+    bool verify = false; // diff every blueprint, even those whose fingerprint is unchanged
+    std::chrono::milliseconds lockTimeout{2000};
+    size_t maxRetries = 5;
+    std::chrono::milliseconds retryBackoff{250};
+    // Type changes that rewrite a table estimated at this many rows or more are done as
+    // expand (shadow column + sync trigger), backfill (batches) and contract (swap). 0 disables it.
+    int64_t largeTableRows = 1000000;
+    size_t backfillBatchSize = 5000;
+
+    // Reads "<keyPath>.verify", "<keyPath>.lockTimeoutMs", "<keyPath>.maxRetries",
+    // "<keyPath>.retryBackoffMs", "<keyPath>.largeTableRows", "<keyPath>.backfillBatchSize".
+    // Keys that are missing keep their default value.
+    static MigrationOptions FromConfig(std::string const &keyPath);
+};
+
+// Statements that bring one table in line with its blueprint.
+struct TablePlan {
+    std::string tableName;
+    bool create = false;
+    int64_t estimatedRows = 0;  // pg_class.reltuples
+    int64_t estimatedBytes = 0; // pg_total_relation_size, heap plus indexes and toast
+    std::vector<MigrationStatement> statements;
+    std::string hash; // fingerprint of the blueprint, recorded once the plan is applied
+};
+
+struct ProcedurePlan {
+    std::string name;
+    std::string sql;
+    std::string hash;
+};
+
+// Everything Migrate would execute, in order: table plans (each in statement order; tables
+// run in parallel unless one references the other or is a partition of it), then procedures.
+struct MigrationPlan {
+    std::vector<TablePlan> tables;
+    std::vector<ProcedurePlan> procedures;
+    // name -> fingerprint of tables that were diffed and found up to date
+    std::vector<std::pair<std::string, std::string>> upToDate;
+    size_t tablesChecked = 0; // blueprints whose fingerprint changed, the others were skipped
+
+    bool Empty() const;
+    // Human readable listing with the lock, rewrite and size estimate of every statement.
+    std::string Render() const;
+};
+
 class Migrator {
   public:
     Migrator() = default;
+    // Introspects the whole schema with one catalog query, diffs every blueprint in
+    // memory and applies the resulting table plans in parallel (tables are independent;
+    // statements of one table keep their order). Procedures run after all tables.
+    // The fingerprint of every applied blueprint is kept in `BOOKKEEPING_TABLE`; entries whose
+    // fingerprint did not change since are skipped, and when no table changed the catalog is
+    // not queried at all. Options are read from "database.migrations", see MigrationOptions.
     static void Migrate(DB &db, Migration const &migration);
     static void Migrate(DB &db);
 
+    // What Migrate would do right now, without changing anything. Throws when the
+    // catalog cannot be read.
+    static MigrationPlan Plan(DB &db, Migration const &migration, MigrationOptions const &options);
+    static MigrationPlan Plan(DB &db);
+
+    // Creates the rolling range partitions that are due (`premake` periods ahead) and detaches,
+    // and optionally drops, the expired ones of every partitioned blueprint that already exists.
+    // Plan includes the same statements; PartitionMaintenance runs this periodically.
+    static void MaintainPartitions(DB &db, Migration const &migration, MigrationOptions const &options);
+    static void MaintainPartitions(DB &db);
+
+    static constexpr char const *BOOKKEEPING_TABLE = "stnl_schema_migrations";
+
+    static std::string Fingerprint(Blueprint const &bp);
+    static std::string Fingerprint(SrBlueprint const &srBp);
+
   private:
-    static void ApplyBlueprint(DB &db, Blueprint const &bp);
-    static void ApplyProcedureBlueprint(DB &db, SrBlueprint const &bp);
+    // kind ("table" | "procedure") -> name -> fingerprint of what was last applied
+    using AppliedHashes = std::unordered_map<std::string, std::unordered_map<std::string, std::string>>;
+    static void EnsureBookkeepingTable(DB &db);
+    static AppliedHashes LoadAppliedHashes(DB &db);
+    static void RecordApplied(DB &db, std::string const &kind, std::string const &name, std::string const &hash);
+
+    struct TableEstimate {
+        int64_t rows = 0;
+        int64_t bytes = 0;
+        bool partitioned = false; // relkind 'p'
+    };
+    // Planner statistics by lower-cased table name.
+    static std::unordered_map<std::string, TableEstimate> EstimateTables(DB &db);
+    // Partition maintenance of existing partitioned tables, blueprint -> fingerprint to record.
+    static std::vector<TablePlan> PlanPartitions(DB &db, std::vector<std::pair<Blueprint const *, std::string>> const &blueprints);
+
+    // `pCurrent` is the table as it exists in the database, nullptr when it does not;
+    // `partitions` are the partitions it currently has.
+    static TablePlan PlanBlueprint(Blueprint const &bp, Blueprint const *pCurrent, TableEstimate const &estimate, std::vector<std::string> const &partitions,
+                                   MigrationOptions const &options);
+    static void ApplyTablePlan(DB &db, TablePlan const &plan, MigrationOptions const &options);
+    static void ApplyTablePlans(DB &db, std::vector<TablePlan> const &plans, MigrationOptions const &options);
+    static void RunBackfill(DB &db, MigrationStatement const &statement, TxOptions const &txOptions);
+    static void ApplyProcedurePlan(DB &db, ProcedurePlan const &plan);
+    static std::string GenerateProcedureSQL(SrBlueprint const &srBp);
     static std::string GenerateSQLType(Column const &col);
     static std::string GenerateCreateSQL(Blueprint const &bp);
     static std::string GenerateSQLConstraints(Column const &col);
+    // Throws std::invalid_argument when the partitioning of `bp` cannot be created.
+    static void ValidatePartitioning(Blueprint const &bp);
+    // Missing static partitions (unless `withStatic` is false) and rolling range partitions up to
+    // `premake` periods after `today`, then the expired ones to detach.
+    static void CollectPartitionStatements(Blueprint const &bp, std::vector<std::string> const &existing, std::chrono::sys_days today, bool withStatic,
+                                           std::vector<MigrationStatement> &alterStatements);
 
     // Stored procedure creation utilities
     static std::string GenerateSrParamSQL(SrParam const &spParam);
-    // Internal helpers used by ApplyBlueprint. Kept private to avoid header
+    // Internal helpers used by PlanBlueprint. Kept private to avoid header
     // API exposure.
     static std::string BuildAddColumnSQL(std::string const &tableName, Column const &desiredCol);
-    static std::string BuildAlterTypeSQL(std::string const &tableName, Column const &desiredCol);
+    // `cast` adds USING <column>::<type> for type changes without an implicit cast.
+    static std::string BuildAlterTypeSQL(std::string const &tableName, Column const &desiredCol, bool cast);
     static std::string BuildIdentitySQL(std::string const &tableName, Column const &desiredCol);
     static std::string BuildNullabilitySQL(std::string const &tableName, Column const &desiredCol);
     static std::string BuildDefaultValueSQL(std::string const &tableName, Column const &desiredCol, std::string const &desiredDefaultValue);
-    static std::string BuildUniqueIndexSQL(Column const &currentCol, Column const &desiredCol);
-    static std::string BuildIndexSQL(Column const &currentCol, Column const &desiredCol);
-    static void CollectAlterStatementsForColumn(std::string const &tableName, Column const &currentCol, Column const &desiredCol,
-                                                std::vector<std::string> &alterStatements);
+    static bool IsRewriteFreeTypeChange(Column const &currentCol, Column const &desiredCol);
+    // Returns true when the column is rebuilt through expand/contract (its indexes go with the old column).
+    static bool CollectAlterStatementsForColumn(std::string const &tableName, Column const &currentCol, Column const &desiredCol, bool largeTable,
+                                                std::vector<MigrationStatement> &alterStatements);
+    static void CollectExpandContractStatements(std::string const &tableName, Column const &desiredCol, std::vector<MigrationStatement> &alterStatements);
+    // Diffs by index name; definitions are compared through IndexDef::Matches. `pPartitions` is
+    // nullptr for a plain table, otherwise indexes are built partition by partition and attached.
+    static void CollectIndexStatements(std::string const &tableName, std::vector<IndexDef> const &desired, std::deque<IndexDef> const &current,
+                                       std::vector<std::string> const &rebuiltColumns, std::vector<std::string> const *pPartitions,
+                                       std::vector<MigrationStatement> &alterStatements);
 };
 } // namespace STNL
 
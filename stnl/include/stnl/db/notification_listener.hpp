@@ -0,0 +1,77 @@
+#ifndef STNL_NOTIFICATION_LISTENER_HPP
+#define STNL_NOTIFICATION_LISTENER_HPP
+
+#include <boost/asio.hpp>
+#include <pqxx/pqxx>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace asio = boost::asio;
+
+namespace STNL {
+
+struct DBNotification {
+    std::string channel;
+    std::string payload;
+    int backendPid;
+};
+
+using NotificationHandler = std::function<void(DBNotification const &notification)>;
+
+/**
+ * @brief LISTEN/NOTIFY subscriptions on one dedicated connection.
+ *
+ * The connection's socket is watched by the io_context, so no thread is parked
+ * waiting for notifications. Handlers are posted to the io_context and may run
+ * concurrently. A lost connection is re-established with backoff and every
+ * channel is LISTENed again; notifications sent while disconnected are lost
+ * (PostgreSQL does not queue them for absent listeners).
+ */
+class NotificationListener : public std::enable_shared_from_this<NotificationListener> {
+  public:
+    NotificationListener(std::string connStr, asio::io_context &ioc);
+
+    // Returns a subscription id for Unsubscribe. Connects lazily on first use.
+    size_t Subscribe(std::string const &channel, NotificationHandler handler);
+    void Unsubscribe(size_t subscriptionId);
+    // Closes the connection and cancels pending waits; handlers already posted still run.
+    void Stop();
+
+  private:
+    struct Subscription {
+        std::string channel;
+        NotificationHandler handler;
+    };
+
+    void Connect();
+    void Disconnect();
+    void ScheduleReconnect();
+    void WaitForNotifications();
+    void OnReadable(boost::system::error_code ec);
+    void ListenOn(std::string const &channel);
+    void Dispatch(pqxx::notification const &notification);
+
+    std::string connStr_;
+    asio::io_context &ioc_;
+    asio::strand<asio::io_context::executor_type> strand_; // serializes every use of conn_
+    std::unique_ptr<pqxx::connection> conn_;
+#if defined(BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR)
+    std::optional<asio::posix::stream_descriptor> socket_;
+#endif
+    asio::steady_timer timer_; // reconnect backoff, and polling where sockets cannot be watched
+    std::chrono::milliseconds backoff_;
+    std::map<size_t, Subscription> subscriptions_;
+    std::atomic<size_t> nextSubscriptionId_{1};
+    bool started_ = false;
+    bool stopped_ = false;
+};
+
+} // namespace STNL
+
+#endif // STNL_NOTIFICATION_LISTENER_HPP
@@ -0,0 +1,65 @@
+#ifndef STNL_DB_PARTITION_DEF_HPP
+#define STNL_DB_PARTITION_DEF_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace STNL {
+
+enum class PartitionStrategy { None, Range, List, Hash };
+enum class PartitionInterval { Day, Week, Month, Year };
+
+// A partition whose bounds are known up front, created as "<table>_<suffix>".
+struct StaticPartition {
+    std::string suffix;
+    std::string boundSQL; // "IN ('eu', 'us')", "FROM (0) TO (1000)", "WITH (MODULUS 4, REMAINDER 0)" or "DEFAULT"
+};
+
+// How a Blueprint's table is partitioned. Range partitioning over a Date/Timestamp column can
+// roll: one partition per interval, `premake` created ahead of time and those older than
+// `retention` intervals detached (and dropped when `dropExpired`) by Migrator::MaintainPartitions.
+struct PartitionDef {
+    PartitionStrategy strategy = PartitionStrategy::None;
+    std::vector<std::string> columns;
+    std::optional<PartitionInterval> interval;
+    std::size_t premake = 3;
+    std::size_t retention = 0; // 0 keeps every partition
+    bool dropExpired = false;
+    std::size_t modulus = 0; // hash partitioning: number of partitions
+    std::vector<StaticPartition> partitions;
+
+    bool Enabled() const;
+    std::string ClauseSQL() const; // "PARTITION BY RANGE (created_at)"
+    // Declared list/range partitions plus "h0".."h<modulus-1>" for hash partitioning.
+    std::vector<StaticPartition> StaticPartitions() const;
+
+    static std::chrono::sys_days PeriodStart(std::chrono::sys_days day, PartitionInterval interval);
+    static std::chrono::sys_days NextPeriod(std::chrono::sys_days start, PartitionInterval interval);
+    // "<table>_p20261001", named after the first day of the period
+    static std::string RollingName(std::string const &tableName, std::chrono::sys_days start);
+    static std::optional<std::chrono::sys_days> ParseRollingName(std::string const &tableName, std::string const &partitionName);
+};
+
+class PartitionProxy {
+  public:
+    explicit PartitionProxy(PartitionDef &d);
+    // Rolling range partitions, one per `interval`.
+    auto Every(PartitionInterval interval) -> PartitionProxy &;
+    auto Premake(std::size_t n) -> PartitionProxy &;
+    auto Retain(std::size_t n, bool dropExpired = false) -> PartitionProxy &;
+    // Static partitions; values and bounds are SQL literals, e.g. Values("eu", {"'de'", "'fr'"}).
+    auto Values(std::string suffix, std::vector<std::string> values) -> PartitionProxy &;
+    auto Range(std::string suffix, std::string from, std::string to) -> PartitionProxy &;
+    auto Default(std::string suffix = "default") -> PartitionProxy &;
+    auto Modulus(std::size_t n) -> PartitionProxy &;
+
+  private:
+    PartitionDef &def;
+};
+
+} // namespace STNL
+
+#endif // STNL_DB_PARTITION_DEF_HPP
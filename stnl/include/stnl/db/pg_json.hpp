@@ -0,0 +1,22 @@
+#ifndef STNL_DB_PG_JSON_HPP
+#define STNL_DB_PG_JSON_HPP
+
+#include <boost/json.hpp>
+
+#include <cstddef>
+#include <string_view>
+
+namespace STNL {
+
+// One value in PostgreSQL text format, `typname` as in pg_type. Integers, finite floats and
+// bools become JSON scalars, json and jsonb are embedded as parsed JSON, bytea (hex output)
+// becomes base64 and timestamps ISO 8601; anything else is kept as a string.
+boost::json::value PgTextToJson(std::string_view text, std::string_view typname);
+
+// Array literal such as {1,2,NULL}, {"a b","c\"d"} or {{1,2},{3,4}} to nested JSON arrays.
+// `pos` is the index of the opening '{' and ends up just past the matching '}'.
+boost::json::array PgArrayToJson(std::string_view text, size_t &pos, std::string_view elemTypname);
+
+} // namespace STNL
+
+#endif // STNL_DB_PG_JSON_HPP
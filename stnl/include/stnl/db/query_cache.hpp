@@ -0,0 +1,119 @@
+#ifndef STNL_QUERY_CACHE_HPP
+#define STNL_QUERY_CACHE_HPP
+
+#include <pqxx/pqxx>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace STNL {
+
+struct CacheOptions {
+    std::chrono::milliseconds ttl{1000};
+    // Tables the query reads. Writes to any of them evict the entry. When empty
+    // they are taken from the FROM/JOIN clauses of the SQL.
+    std::vector<std::string> tables;
+};
+
+/**
+ * @brief Size-bounded LRU cache of read-only query results.
+ *
+ * Entries are keyed by SQL plus parameters and expire after their TTL or when
+ * one of their tables is invalidated. Concurrent misses for the same key are
+ * coalesced: only the first caller runs the query, the others get its result
+ * (AsyncGetOrLoad hands it to them from the loading thread instead of blocking).
+ * Failed queries are handed to the waiting callers but never cached.
+ *
+ * Every table has its own invalidation epoch, so a result is not cached when one
+ * of the tables it read was written while it loaded; writes to other tables do not
+ * keep it out of the cache.
+ */
+class QueryCache {
+  public:
+    struct Entry {
+        bool ok = false;
+        std::string msg;
+        pqxx::result data;
+        std::chrono::steady_clock::time_point expiresAt;
+        std::vector<std::string> tables;
+
+        // Serialized JSON of `data`, produced once by `serialize` and shared by every later hit.
+        std::shared_ptr<std::string const> Json(std::function<std::string(pqxx::result const &)> const &serialize) const;
+
+      private:
+        mutable std::once_flag jsonOnce_;
+        mutable std::shared_ptr<std::string const> json_;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t coalesced = 0; // misses that waited for another caller's query
+        uint64_t evictions = 0;
+        uint64_t invalidations = 0;
+        size_t size = 0;
+    };
+
+    // Runs the query and fills ok/msg/data of the entry.
+    using Loader = std::function<void(Entry &entry)>;
+    using Completion = std::function<void(std::shared_ptr<Entry const> entry)>;
+
+    explicit QueryCache(size_t maxEntries = 1024);
+
+    // Blocks while another caller loads the same key.
+    std::shared_ptr<Entry const> GetOrLoad(std::string const &key, CacheOptions const &options, std::string_view qSQL, Loader const &load);
+    // Never waits for another caller: `done` runs right away on a hit, after `load` on a
+    // miss, and on the loading caller's thread when the miss was coalesced with its load.
+    void AsyncGetOrLoad(std::string const &key, CacheOptions const &options, std::string_view qSQL, Loader const &load, Completion done);
+
+    // Entries whose tables could not be determined are filed under ANY_TABLE and dropped
+    // by a write to any table.
+    static constexpr std::string_view ANY_TABLE = "*";
+
+    void InvalidateTable(std::string_view tableName);
+    void InvalidateAll();
+    void SetMaxEntries(size_t maxEntries);
+    Stats GetStats();
+
+    // Lower-cased tables named after FROM (every item of its list) / JOIN / INTO / UPDATE /
+    // USING / TABLE, without schema or quotes. Empty when a table position holds something
+    // that is not a name or a subquery, so callers do not trust a partial list.
+    static std::vector<std::string> TablesOf(std::string_view qSQL);
+
+  private:
+    struct Slot {
+        std::shared_ptr<Entry const> entry;
+        std::list<std::string>::iterator lruIt;
+    };
+
+    void EraseLocked(std::unordered_map<std::string, Slot>::iterator it);
+    void InvalidateTableLocked(std::string const &table);
+    void EvictLocked();
+
+    std::mutex mutex_;
+    std::list<std::string> lru_; // most recently used at the front
+    std::unordered_map<std::string, Slot> entries_;
+    std::unordered_map<std::string, std::vector<Completion>> inFlight_; // coalesced callers of each load
+    std::unordered_map<std::string, std::unordered_set<std::string>> tableKeys_;
+    // bumped by invalidations so loads racing with a write to a table they read are not cached
+    std::unordered_map<std::string, uint64_t> tableEpochs_;
+    uint64_t allEpoch_ = 0; // bumped by InvalidateAll
+    std::atomic<size_t> tracked_{0}; // entries plus loads in flight, lets writers skip the lock when idle
+    size_t maxEntries_;
+    Stats stats_;
+};
+
+} // namespace STNL
+
+#endif // STNL_QUERY_CACHE_HPP
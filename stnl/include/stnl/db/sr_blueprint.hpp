@@ -33,6 +33,11 @@ class SrBlueprint {
     TimestampParamProxy Timestamp(const std::string &name);
     UUIDParamProxy UUID(const std::string &name);
     TextParamProxy Text(const std::string &name);
+    RealParamProxy Real(const std::string &name);
+    DoublePrecisionParamProxy DoublePrecision(const std::string &name);
+    JsonParamProxy Json(const std::string &name);
+    JsonbParamProxy Jsonb(const std::string &name);
+    ByteaParamProxy Bytea(const std::string &name);
 
   private:
     std::string spName_;
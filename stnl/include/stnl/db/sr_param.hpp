@@ -15,6 +15,7 @@ struct SrParam {
     bool nullable;
     bool out;
     bool in;
+    bool array; // one dimensional array of `type`
     unsigned short precision;
     unsigned short scale;
     std::string defaultValue;
@@ -59,6 +60,11 @@ class SrParamProxy {
         return static_cast<Derived &>(*this);
     }
 
+    Derived &Array(bool v = true) {
+        param.array = v;
+        return static_cast<Derived &>(*this);
+    }
+
     virtual Derived &Default(std::string const &v) {
         param.defaultValue = std::string(v);
         return static_cast<Derived &>(*this);
@@ -124,6 +130,7 @@ class TimestampParamProxy : public SrParamProxy<TimestampParamProxy> {
   public:
     TimestampParamProxy(SrParam &param);
     TimestampParamProxy &Default(std::string const &v = "CURRENT_TIMESTAMP") override;
+    TimestampParamProxy &Precision(unsigned short v);
 };
 
 class UUIDParamProxy : public SrParamProxy<UUIDParamProxy> {
@@ -136,6 +143,31 @@ class TextParamProxy : public SrParamProxy<TextParamProxy> {
   public:
     TextParamProxy(SrParam &param);
 };
+
+class RealParamProxy : public SrParamProxy<RealParamProxy> {
+  public:
+    RealParamProxy(SrParam &param);
+};
+
+class DoublePrecisionParamProxy : public SrParamProxy<DoublePrecisionParamProxy> {
+  public:
+    DoublePrecisionParamProxy(SrParam &param);
+};
+
+class JsonParamProxy : public SrParamProxy<JsonParamProxy> {
+  public:
+    JsonParamProxy(SrParam &param);
+};
+
+class JsonbParamProxy : public SrParamProxy<JsonbParamProxy> {
+  public:
+    JsonbParamProxy(SrParam &param);
+};
+
+class ByteaParamProxy : public SrParamProxy<ByteaParamProxy> {
+  public:
+    ByteaParamProxy(SrParam &param);
+};
 } // namespace STNL
 
 #endif // STNL_SP_PARAM_HPP
\ No newline at end of file
@@ -1,6 +1,9 @@
 #ifndef STNL_DB_TYPES_HPP
 #define STNL_DB_TYPES_HPP
 
+#include <cstddef>
+#include <string>
+
 namespace STNL {
 
 enum class SQLDataType {
@@ -17,9 +20,17 @@ enum class SQLDataType {
     Date,
     Timestamp,
     UUID,
-    Text
+    Text,
+    Real,
+    DoublePrecision,
+    Json,
+    Jsonb,
+    Bytea
 };
 
+// bytea values; pqxx::params sends these in binary format instead of escaped hex text.
+using Bytes = std::basic_string<std::byte>;
+
 }
 
 #endif // STNL_DB_TYPES_HPP
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef STNL_ACCESS_LOG_HPP
+#define STNL_ACCESS_LOG_HPP
+
+#include "stnl/core/logger.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace STNL {
+
+// One served request, filled in by Session as the exchange progresses.
+struct AccessRecord {
+    std::string_view method;
+    std::string route; // path without the query string
+    std::string userAgent;
+    unsigned status = 0;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    std::chrono::microseconds parse{0};      // Request::parse (query, body, multipart)
+    std::chrono::microseconds middleware{0}; // middleware chain
+    std::chrono::microseconds handler{0};    // route lookup and handler, static files included
+    std::chrono::microseconds write{0};      // sending the response
+    std::chrono::microseconds total{0};      // from the request being read to the response being sent
+
+    // {"ts":"2025-01-31T12:00:00.123Z","method":"GET","route":"/api/users","ua":"curl/8.5.0","status":200,"in":312,
+    //  "out":1840,"parse_us":12,"middleware_us":3,"handler_us":840,"write_us":25,"total_us":890}
+    std::string ToJson(std::chrono::system_clock::time_point time) const;
+};
+
+struct AccessLogOptions {
+    bool enabled = false;
+    double sampleRate = 1.0;           // share of requests logged, in [0, 1]
+    std::chrono::milliseconds slow{0}; // requests at least this slow are always logged, 0 disables
+    uint64_t seed = 0;                 // fixed sampling sequence shared by all threads, 0 samples per thread at random
+    // Where the JSON lines go. With an empty file they are written to the application log,
+    // otherwise to that file through a logger thread of their own.
+    LoggerOptions sink;
+
+    // Reads "<keyPath>.enabled", "<keyPath>.sampleRate", "<keyPath>.slowMs", "<keyPath>.seed" and the LoggerOptions
+    // keys ("<keyPath>.file", "<keyPath>.capacity", ...). Keys that are missing keep their default value.
+    static AccessLogOptions FromConfig(std::string const &keyPath);
+};
+
+/**
+ * @brief JSON lines access log. Server errors (5xx) and slow requests are always
+ * kept, other requests are sampled at `sampleRate`.
+ */
+class AccessLog {
+  public:
+    explicit AccessLog(AccessLogOptions options);
+
+    // Whether `record` is written, by status, duration and sampling.
+    bool Keep(AccessRecord const &record) const;
+    void Write(AccessRecord const &record);
+    uint64_t Dropped() const;
+
+  private:
+    AccessLogOptions options_;
+    uint64_t sampleThreshold_; // Keep compares a random 64-bit value against it
+    mutable std::atomic<uint64_t> seeded_; // splitmix64 state when options_.seed is set
+    std::unique_ptr<LogChannel> channel_;
+};
+
+} // namespace STNL
+
+#endif // STNL_ACCESS_LOG_HPP
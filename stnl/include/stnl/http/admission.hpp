@@ -0,0 +1,66 @@
+#ifndef STNL_ADMISSION_HPP
+#define STNL_ADMISSION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace STNL {
+
+struct AdmissionOptions {
+    size_t maxConnections = 0;          // open client connections, 0 = unlimited
+    size_t maxInFlight = 0;             // requests being handled or written, 0 = unlimited
+    std::chrono::seconds retryAfter{1}; // Retry-After of the 503 sent when saturated
+
+    // Reads "<keyPath>.maxConnections", "<keyPath>.maxInFlight" and "<keyPath>.retryAfterSeconds".
+    // Keys that are missing keep their default value.
+    static AdmissionOptions FromConfig(std::string const &keyPath);
+};
+
+/**
+ * @brief Connection and in-flight request limits, shared by every acceptor and session.
+ *
+ * Server pauses accepting while the connection limit is reached, so further clients
+ * wait in the kernel's listen backlog instead of costing a Session each. Requests
+ * above the in-flight limit are answered with 503 and Retry-After without running
+ * middlewares or handlers. Limits may be changed while serving (Reconfigure).
+ */
+class Admission {
+  public:
+    explicit Admission(AdmissionOptions const &options = {});
+    Admission(Admission const &) = delete;
+    Admission &operator=(Admission const &) = delete;
+
+    void Reconfigure(AdmissionOptions const &options);
+
+    // False, without counting the connection, when the limit is reached.
+    bool TryOpenConnection();
+    void CloseConnection();
+    bool ConnectionsFull() const;
+
+    // False, without counting the request, when the limit is reached.
+    bool TryBeginRequest();
+    void EndRequest();
+
+    size_t Connections() const { return connections_.load(std::memory_order_relaxed); }
+    size_t InFlight() const { return inFlight_.load(std::memory_order_relaxed); }
+    std::chrono::seconds RetryAfter() const { return std::chrono::seconds(retryAfterSeconds_.load(std::memory_order_relaxed)); }
+
+    // Appends the open connections, in-flight requests and their limits in Prometheus text format.
+    void RenderPrometheus(std::string &out) const;
+
+  private:
+    static bool TryAcquire(std::atomic<size_t> &count, size_t limit);
+
+    std::atomic<size_t> connections_{0};
+    std::atomic<size_t> inFlight_{0};
+    std::atomic<size_t> maxConnections_{0};
+    std::atomic<size_t> maxInFlight_{0};
+    std::atomic<int64_t> retryAfterSeconds_{1};
+};
+
+} // namespace STNL
+
+#endif // STNL_ADMISSION_HPP
@@ -0,0 +1,58 @@
+#ifndef STNL_HTTP_METRICS_HPP
+#define STNL_HTTP_METRICS_HPP
+
+#include "stnl/core/metrics.hpp"
+#include "stnl/http/core.hpp"
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+namespace STNL {
+
+// Requests of one route, by status class (1xx .. 5xx), and their duration.
+struct RouteMetrics {
+    std::array<Counter *, 5> requests{};
+    Histogram *duration = nullptr;
+
+    void Record(unsigned status, std::chrono::microseconds total);
+};
+
+/**
+ * @brief The server metrics, registered once so Session only touches sharded cells.
+ *
+ * Routes are registered with the router (Server::Get, Post, ...); requests that
+ * match no route (static files, 404s) share the `route="*"` series.
+ */
+class HttpMetrics {
+  public:
+    explicit HttpMetrics(Metrics &metrics);
+
+    void AddRoute(Route const &route);
+    // Not synchronized with AddRoute: routes are added before the server accepts.
+    RouteMetrics &ForRoute(Route const &route);
+    RouteMetrics &Unmatched();
+
+    Gauge &sessionsActive;
+    Counter &accepts;
+    Counter &acceptErrors;
+    Counter &bytesReceived;
+    Counter &bytesSent;
+    Counter &timeouts;
+    Counter &payloadTooLarge;
+    Counter &connectionsRejected;
+    Counter &requestsShed;
+    Counter &acceptPauses;
+
+  private:
+    RouteMetrics Register(std::string const &label);
+
+    Metrics &metrics_;
+    RouteMetrics unmatched_;
+    std::unordered_map<Route, RouteMetrics, RouteHash> routes_;
+};
+
+} // namespace STNL
+
+#endif // STNL_HTTP_METRICS_HPP
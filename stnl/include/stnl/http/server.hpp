@@ -1,8 +1,13 @@
 #ifndef STNL_SERVER_HPP
 #define STNL_SERVER_HPP
 
+#include "stnl/core/metrics.hpp"
+#include "stnl/core/timer_wheel.hpp"
 #include "stnl/db/db.hpp"
+#include "stnl/http/access_log.hpp"
+#include "stnl/http/admission.hpp"
 #include "stnl/http/core.hpp"
+#include "stnl/http/http_metrics.hpp"
 
 #include <boost/asio.hpp>
 #include <boost/beast/core.hpp>
@@ -11,9 +16,16 @@
 #include <boost/json.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace beast = boost::beast;
@@ -28,6 +40,7 @@ class DB;         // forward declaration
 class STNLModule; // forward delcaration
 class Request;    // forward declaration
 class Middleware; // forward declaration
+class Session;    // forward declaration
 
 struct CharPtrHash {
     std::size_t operator()(volatile const void *key) const noexcept { return std::hash<std::uintptr_t>{}(reinterpret_cast<std::uintptr_t>(key)); }
@@ -37,11 +50,26 @@ struct CharPtrEqual {
     bool operator()(volatile const void *lhs, volatile const void *rhs) const noexcept { return lhs == rhs; }
 };
 
+struct ListenerOptions {
+    // 0 accepts on the server's io_context. N > 0 starts N io_contexts, each run by one
+    // thread with its own SO_REUSEPORT acceptor; a session stays on the shard that accepted it.
+    size_t shards = 0;
+    bool pinThreads = false; // pin shard i to CPU i (Linux only)
+
+    // Reads "<keyPath>.shards" (-1 = one per logical core) and "<keyPath>.pinThreads".
+    static ListenerOptions FromConfig(std::string const &keyPath);
+};
+
 class Server {
   public:
-    Server(asio::io_context &ioc, const tcp::endpoint &endpoint, fs::path rootDirPath);
+    Server(asio::io_context &ioc, const tcp::endpoint &endpoint, fs::path rootDirPath, ListenerOptions listenerOptions = {});
+    ~Server();
 
     void AddDatabase(std::string const &keyAlias, std::string const &connectionString, size_t poolSize = 4, size_t numThreads = 4);
+    void AddDatabase(std::string const &keyAlias, std::string const &connectionString, PoolOptions const &poolOptions, size_t numThreads = 4);
+    // Reads classified as such by DB are balanced across `replicaConnectionStrings`, writes go to the primary.
+    void AddDatabase(std::string const &keyAlias, std::string const &primaryConnectionString, std::vector<std::string> const &replicaConnectionStrings,
+                     PoolOptions const &poolOptions, size_t numThreads = 4);
     std::shared_ptr<DB> GetDatabase(std::string const &keyAlias = "default");
 
     static http::message_generator Response(Request const &req, http::status status_code = http::status::ok);
@@ -49,6 +77,8 @@ class Server {
     static http::message_generator Response(Request const &req, const fs::path &file_path, const std::string &content_type,
                                             http::status status_code = http::status::ok);
     static http::message_generator Response(Request const &req, const boost::json::value &data, http::status status_code = http::status::ok);
+    // `body` is sent as is with an application/json content type, e.g. JSON kept by DB::ExecCachedJson.
+    static http::message_generator ResponseJson(Request const &req, std::string body, http::status status_code = http::status::ok);
 
     const Router &GetRouter() const;
     void Get(std::string path, RouteHandler handler);
@@ -91,29 +121,125 @@ class Server {
         return std::static_pointer_cast<ModuleType>(it->second);
     }
 
+    // Prometheus text exposition of the built-in metrics (HTTP, database pools and statements,
+    // logger) and of those registered in GetMetrics().
+    std::string RenderMetrics();
+    // Registry for application metrics, rendered on the metrics route. Modules register
+    // theirs in STNLModule::SetupMetrics.
+    Metrics &GetMetrics();
+    HttpMetrics &GetHttpMetrics();
+
+    // The pending schema changes of every database (see Migrator::Plan), without applying them.
+    std::string PlanDatabaseMigrations();
+
+    // The "http.accessLog" writer, null when disabled.
+    AccessLog *GetAccessLog();
+    // The "http.admission" limits, shared by every session.
+    Admission &GetAdmission();
+    // Called by Session as it starts, so Stop can drain it.
+    void TrackSession(std::shared_ptr<Session> const &session);
+    // Called by Session when its connection closes; resumes a paused acceptor.
+    void ReleaseConnection(Session *session);
+
     fs::path GetRootDirPath();
+    // Starts serving once the io_context runs. SIGINT and SIGTERM call Stop with "server.shutdownTimeoutMs";
+    // a second signal forces it.
     void Run();
+    /**
+     * Drains and stops the server, returns right away; callable from any thread.
+     * Accepting stops, idle keep-alive connections are closed and requests in flight are
+     * let finish, then modules are stopped (STNLModule::Stop) and the databases release
+     * the io_context (DB::Shutdown), so the threads running it return once pending
+     * queries are done. Connections still open after `timeout` are closed. Calling it
+     * again while draining closes them right away. The io_context is never stopped: a
+     * handler stuck past that (e.g. in a query) holds its thread until it returns.
+     */
+    void Stop(std::chrono::milliseconds timeout);
+    bool IsDraining() const;
+    // The io_context of databases, timers and modules; sessions run on it only when unsharded.
     asio::io_context &GetIOC();
+    // Number of accept shards, 0 when sessions share GetIOC().
+    size_t GetShardCount() const;
 
   private:
+    void WarmUpDatabases();
+    void SetupModuleMigrations();
     void RunDatabaseMigrations();
+    // Runs Migrator::MaintainPartitions on every database each "database.partitions.maintenanceIntervalMs",
+    // on a thread per database so DDL and lock waits never hold an io thread.
+    void SchedulePartitionMaintenance();
+    // Reloads the config when its file changes ("config.reloadPollMs") or on SIGHUP.
+    void WatchConfig();
+    void ScheduleConfigPoll(std::chrono::milliseconds interval);
+    void WaitReloadSignal();
+    void WaitStopSignal(std::chrono::milliseconds timeout);
+    void BeginDrain(std::chrono::steady_clock::time_point deadline);
+    void PollDrain();
+    void FinishDrain();
+    // Posts Session::Drain to every open session.
+    void DrainSessions(bool force);
+    void SetupMetricsRoute();
+    void SetupAccessLog();
     void SetupModules();
     void SetupMiddlewares();
     void LaunchModules();
+    struct Shard {
+        asio::io_context ioc{1};
+        tcp::acceptor acceptor{ioc};
+        TimerWheel timerWheel{ioc.get_executor()}; // timeouts of the shard's sessions
+        std::thread thread;
+    };
+
+    void OpenShards(tcp::endpoint const &endpoint);
+    void StartShards();
     void DoAccept();
-    void OnAccept(beast::error_code ec, tcp::socket socket);
+    void DoAccept(Shard &shard);
+    void OnAccept(beast::error_code ec, tcp::socket socket, TimerWheel &timerWheel);
+    // Parks the accept loop `resume` while the connection limit is reached; false when under it.
+    bool PauseAccept(std::function<void()> resume);
+    bool ResumeAccept();
     void AddRoute(http::verb method, std::string path, RouteHandler handler);
     asio::io_context &ioc_;
 
     std::unordered_map<std::string, std::shared_ptr<DB>> databases_;
     std::vector<std::string> databaseKeyAliases_;
+    bool moduleMigrationsSetUp_ = false;
+    /* the drain steps run on drainStrand_, Stop may be called from any thread; the timers,
+     * signal sets and acceptor_ the drain closes are bound to it as well, so their handlers
+     * never re-arm them concurrently with a close */
+    asio::strand<asio::io_context::executor_type> drainStrand_;
+    asio::steady_timer partitionTimer_;
+    std::vector<std::future<void>> partitionMaintenanceRuns_; // std::async, the Server waits for a run in progress when destroyed
+    asio::steady_timer configTimer_;
+    asio::signal_set reloadSignals_;
+    asio::signal_set stopSignals_;
+    asio::steady_timer drainTimer_;
+    std::atomic<bool> draining_{false};
+    std::chrono::steady_clock::time_point drainDeadline_;
+    bool drainForced_ = false;
+    bool drainFinished_ = false;
+    std::mutex sessionsMutex_;
+    std::unordered_map<Session *, std::weak_ptr<Session>> sessions_;
 
     std::vector<std::shared_ptr<STNLModule>> modulesVec_;
     std::unordered_map<volatile const void *, std::shared_ptr<STNLModule>, CharPtrHash, CharPtrEqual> modules_;
 
     tcp::acceptor acceptor_; // Fixed: was missing type in original
+    ListenerOptions listenerOptions_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    /* timeouts of the sessions on ioc_, when unsharded; every ioc_ thread arms and cancels
+     * them, so sessions are spread over one wheel per core rather than sharing one mutex */
+    std::vector<std::unique_ptr<TimerWheel>> timerWheels_;
+    size_t nextTimerWheel_ = 0; // advanced by the accept loop, on drainStrand_
     Router router_;
     std::vector<std::unique_ptr<Middleware>> middlewares_;
+    std::unique_ptr<AccessLog> accessLog_;
+    Admission admission_;
+    std::mutex pausedMutex_;
+    std::vector<std::function<void()>> pausedAccepts_;
+    std::atomic<bool> acceptPaused_{false}; // pausedAccepts_ is not empty, read without the lock
+    Metrics metrics_;
+    HttpMetrics httpMetrics_{metrics_};
     fs::path rootDirPath_;
 };
 
@@ -1,9 +1,16 @@
 #ifndef STNL_SESSION_HPP
 #define STNL_SESSION_HPP
 
+#include "stnl/core/config.hpp"
+#include "stnl/core/timer_wheel.hpp"
+#include "stnl/http/access_log.hpp"
+#include "stnl/http/admission.hpp"
 #include "stnl/http/core.hpp"
+#include "stnl/http/http_metrics.hpp"
 
 #include <boost/beast/core.hpp>
+#include <chrono>
+#include <cstdint>
 #include <iostream> // For error logging
 #include <memory>
 
@@ -15,26 +22,64 @@ class Server;  // forward declaration
 
 class Session : public std::enable_shared_from_this<Session> {
   public:
-    explicit Session(tcp::socket socket, Server &server);
+    Session(tcp::socket socket, Server &server, TimerWheel &timerWheel);
+    ~Session();
+    Session(Session const &) = delete;
+    Session &operator=(Session const &) = delete;
     void Run();
+    // Called on the session's executor when the server stops: closes the connection
+    // when it waits for the next keep-alive request, or right away with `force`.
+    void Drain(bool force);
+    asio::any_io_executor GetExecutor();
 
   private:
+    // Between keep-alive requests waits for data under the idle timeout, then reads the
+    // header and the body under their own timeouts.
     void DoRead();
+    void OnIdleReady(beast::error_code ec);
+    void ReadHeader();
+    void OnReadHeader(beast::error_code ec, std::size_t bytes_transferred);
     void OnRead(beast::error_code ec, std::size_t bytes_transferred);
+    void DoWrite(http::message_generator res);
     void OnWrite(beast::error_code ec, std::size_t bytes_transferred);
     http::message_generator HandleRequest(Request &req);
     boost::optional<http::message_generator> ApplyMiddlewares(Request &req);
-    void SetupTimeout();
-    void OnTimeout(beast::error_code ec);
+    void ArmTimeout(ConfigValue<int64_t> const &timeoutMs);
+    void CancelTimeout();
+    // Closes the socket when `sequence` is still the armed timeout.
+    void OnTimeout(uint64_t sequence);
+    void Close();
+    // Starts timing once a request is read; once the response is sent, updates the metrics
+    // and writes the access log record.
+    void BeginExchange(std::size_t bytesIn);
+    void EndExchange(std::size_t bytesOut);
+    // Answers 503 with Retry-After when the in-flight limit is reached.
+    void Shed();
+    void EndRequest();
 
     beast::tcp_stream stream_;
     beast::flat_buffer buffer_;
     boost::optional<http::request_parser<http::string_body>> parser_;  // Use optional parser for proper reset
     Server &server_;
     bool keepAlive_;
+    HttpMetrics &metrics_;
+    AccessLog *accessLog_;                           // null when the access log is disabled
+    Admission &admission_;
+    bool inFlight_ = false;                          // counted in Admission::InFlight until the response is written
+    TimerWheel &timerWheel_;
+    TimerWheel::Entry timeout_;
+    uint64_t timeoutSequence_ = 0;
+    bool timeoutArmed_ = false;
+    bool closing_ = false;                           // closed by a timeout or Drain, errors are expected
+    bool idle_ = false;                              // waiting for the next keep-alive request
+    std::size_t headerBytes_ = 0;
+    bool exchangePending_ = false;
+    RouteMetrics *routeMetrics_ = nullptr;
+    AccessRecord access_;                            // route and method only filled for the access log
+    std::chrono::steady_clock::time_point readDone_;
+    std::chrono::steady_clock::time_point writeStart_;
     
     static constexpr size_t DEFAULT_BODY_LIMIT = 10 * 1024 * 1024;  // 10MB
-    static constexpr std::chrono::seconds REQUEST_TIMEOUT{30};       // 30 seconds
 };
 } // namespace STNL
 
@@ -14,12 +14,32 @@
 #include <stdexcept>
 #include <string>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace json = boost::json;
 namespace fs = boost::filesystem;
 
 namespace STNL {
 
+ConfigSnapshot::ConfigSnapshot(json::value data) : data_(std::move(data)) {
+    Index(data_, "");
+}
+
+void ConfigSnapshot::Index(json::value const &value, std::string const &keyPath) {
+    if (!keyPath.empty()) { index_.emplace(keyPath, &value); }
+    if (!value.is_object()) { return; }
+    for (json::key_value_pair const &entry : value.as_object()) {
+        std::string const key(entry.key());
+        Index(entry.value(), keyPath.empty() ? key : keyPath + '.' + key);
+    }
+}
+
+auto ConfigSnapshot::Find(std::string_view keyPath) const -> json::value const * {
+    auto it = index_.find(keyPath);
+    return it == index_.end() ? nullptr : it->second;
+}
+
 std::unique_ptr<Config> Config::instance_ = nullptr;
 std::mutex Config::initMutex_;
 
@@ -37,7 +57,19 @@ auto Config::Instance() -> Config& {
     return *instance_;
 }
 
+auto Config::Snapshot() -> std::shared_ptr<ConfigSnapshot const> {
+    return Config::Instance().current_.load(std::memory_order_acquire);
+}
+
+auto Config::Generation() -> uint64_t {
+    return Config::Instance().generation_.load(std::memory_order_acquire);
+}
+
 Config::Config(): rootDirPath_(boost::dll::program_location().parent_path()) {
+    {
+        std::lock_guard<std::mutex> lock(reloadMutex_);
+        PublishLocked(std::make_shared<ConfigSnapshot const>(json::value{}));
+    }
     bool bLoadError = false;
     fs::path configPath;
     if (fs::exists(rootDirPath_ / "config.local.json")) {
@@ -62,6 +94,9 @@ auto Config::LoadFromFile(const fs::path &configPath) -> bool {
         std::cerr << "Config file does not exist or is not a regular file: " + configPath.string() << '\n';
         return false;
     }
+    boost::system::error_code ec;
+    std::time_t const modified = fs::last_write_time(configPath, ec);
+    uintmax_t const size = fs::file_size(configPath, ec);
     std::ifstream configFile(configPath.string());
     if (!configFile.is_open()) {
         std::cerr << "Could not open config file: " + configPath.string() << '\n';
@@ -69,12 +104,82 @@ auto Config::LoadFromFile(const fs::path &configPath) -> bool {
     }
     std::string content((std::istreambuf_iterator<char>(configFile)), std::istreambuf_iterator<char>());
 
-    boost::system::error_code ec;
-    data_ = json::parse(content, ec);
+    json::value data = json::parse(content, ec);
     if (ec) {
         std::cerr << "Failed to parse config file: " + ec.what() << '\n';
         return false;
     }
+    std::lock_guard<std::mutex> lock(reloadMutex_);
+    configPath_ = configPath;
+    configModified_ = modified;
+    configSize_ = size;
+    PublishLocked(std::make_shared<ConfigSnapshot const>(std::move(data)));
+    return true;
+}
+
+void Config::PublishLocked(std::shared_ptr<ConfigSnapshot const> snapshot) {
+    current_.store(std::move(snapshot), std::memory_order_release);
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+auto Config::Reload() -> bool {
+    Config &config = Config::Instance();
+    fs::path configPath;
+    {
+        std::lock_guard<std::mutex> lock(config.reloadMutex_);
+        configPath = config.configPath_;
+    }
+    if (configPath.empty()) { return false; }
+    if (!config.LoadFromFile(configPath)) {
+        Logger::Err() << "Config::Reload: keeping the current configuration, " << configPath.string() << " could not be loaded";
+        return false;
+    }
+    Logger::Inf() << "Config::Reload: reloaded " << configPath.string();
+    std::vector<ChangeHandler> handlers;
+    {
+        std::lock_guard<std::mutex> lock(config.reloadMutex_);
+        for (auto const &[id, handler] : config.subscribers_) { handlers.push_back(handler); }
+    }
+    std::shared_ptr<ConfigSnapshot const> const snapshot = Config::Snapshot();
+    for (ChangeHandler const &handler : handlers) {
+        try {
+            handler(*snapshot);
+        } catch (std::exception const &e) { Logger::Err() << "Config::Reload: change handler failed: " << e.what(); }
+    }
     return true;
 }
+
+auto Config::ReloadIfChanged() -> bool {
+    Config &config = Config::Instance();
+    fs::path configPath;
+    std::time_t modified = 0;
+    uintmax_t size = 0;
+    {
+        std::lock_guard<std::mutex> lock(config.reloadMutex_);
+        configPath = config.configPath_;
+        modified = config.configModified_;
+        size = config.configSize_;
+    }
+    if (configPath.empty()) { return false; }
+    boost::system::error_code ec;
+    std::time_t const currentModified = fs::last_write_time(configPath, ec);
+    if (ec) { return false; }
+    uintmax_t const currentSize = fs::file_size(configPath, ec);
+    if (ec || (currentModified == modified && currentSize == size)) { return false; }
+    return Reload();
+}
+
+auto Config::OnChange(ChangeHandler handler) -> size_t {
+    Config &config = Config::Instance();
+    std::lock_guard<std::mutex> lock(config.reloadMutex_);
+    size_t const id = ++config.nextSubscriberId_;
+    config.subscribers_.emplace(id, std::move(handler));
+    return id;
+}
+
+void Config::Unsubscribe(size_t id) {
+    Config &config = Config::Instance();
+    std::lock_guard<std::mutex> lock(config.reloadMutex_);
+    config.subscribers_.erase(id);
+}
 } // namespace STNL
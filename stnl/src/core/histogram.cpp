@@ -0,0 +1,83 @@
+#include "stnl/core/histogram.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <string>
+
+namespace STNL {
+
+auto LatencyHistogram::BucketIndex(uint64_t micros) -> size_t {
+    if (micros < SUB_BUCKETS) { return static_cast<size_t>(micros); }
+    size_t const exponent = static_cast<size_t>(std::bit_width(micros)) - 1;
+    if (exponent >= MAX_EXPONENT) { return BUCKET_COUNT - 1; }
+    size_t const subBucket = static_cast<size_t>(micros >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return SUB_BUCKETS + ((exponent - SUB_BUCKET_BITS) * SUB_BUCKETS) + subBucket;
+}
+
+auto LatencyHistogram::BucketUpperBound(size_t index) -> uint64_t {
+    if (index < SUB_BUCKETS) { return index + 1; }
+    size_t const exponent = ((index - SUB_BUCKETS) / SUB_BUCKETS) + SUB_BUCKET_BITS;
+    size_t const subBucket = index % SUB_BUCKETS;
+    return static_cast<uint64_t>(SUB_BUCKETS + subBucket + 1) << (exponent - SUB_BUCKET_BITS);
+}
+
+void LatencyHistogram::Record(std::chrono::nanoseconds duration) {
+    RecordMicros(static_cast<uint64_t>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(duration).count())));
+}
+
+void LatencyHistogram::RecordMicros(uint64_t micros) {
+    buckets_[BucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sumMicros_.fetch_add(micros, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Merge(LatencyHistogram const &other) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) { buckets_[i].fetch_add(other.buckets_[i].load(std::memory_order_relaxed), std::memory_order_relaxed); }
+    count_.fetch_add(other.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    sumMicros_.fetch_add(other.sumMicros_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+auto LatencyHistogram::Count() const -> uint64_t {
+    return count_.load(std::memory_order_relaxed);
+}
+
+auto LatencyHistogram::SumMicros() const -> uint64_t {
+    return sumMicros_.load(std::memory_order_relaxed);
+}
+
+auto LatencyHistogram::Percentile(double q) const -> std::chrono::microseconds {
+    uint64_t const total = Count();
+    if (total == 0) { return std::chrono::microseconds{0}; }
+    q = std::clamp(q, 0.0, 1.0);
+    auto const rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(total))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) { return std::chrono::microseconds{BucketUpperBound(i)}; }
+    }
+    return std::chrono::microseconds{BucketUpperBound(BUCKET_COUNT - 1)};
+}
+
+void LatencyHistogram::RenderPrometheus(std::string &out, std::string_view name, std::string_view labels) const {
+    std::string const sep = labels.empty() ? "" : ",";
+    /* the fine sub-buckets are folded into one Prometheus bucket per power of two:
+     * enough resolution for dashboards while keeping the exposition small */
+    uint64_t cumulative = 0;
+    size_t index = 0;
+    for (size_t exponent = SUB_BUCKET_BITS; exponent < MAX_EXPONENT; ++exponent) {
+        size_t const octaveEnd = SUB_BUCKETS + ((exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS);
+        for (; index < octaveEnd; ++index) { cumulative += buckets_[index].load(std::memory_order_relaxed); }
+        if (exponent < 4 || exponent > 26) { continue; } // 32us .. ~134s
+        double const le = static_cast<double>(uint64_t{1} << (exponent + 1)) / 1e6;
+        out += std::format("{}_bucket{{{}{}le=\"{}\"}} {}\n", name, labels, sep, le, cumulative);
+    }
+    for (; index < BUCKET_COUNT; ++index) { cumulative += buckets_[index].load(std::memory_order_relaxed); }
+    /* +Inf and _count reuse the bucket total so a concurrent Record() can never make them disagree */
+    out += std::format("{}_bucket{{{}{}le=\"+Inf\"}} {}\n", name, labels, sep, cumulative);
+    out += std::format("{}_sum{{{}}} {}\n", name, labels, static_cast<double>(SumMicros()) / 1e6);
+    out += std::format("{}_count{{{}}} {}\n", name, labels, cumulative);
+}
+
+} // namespace STNL
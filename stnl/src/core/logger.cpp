@@ -1,135 +1,492 @@
-
 #include "stnl/core/logger.hpp"
+#include "stnl/core/config.hpp"
 
-#include <boost/asio.hpp>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-#include <chrono>  // For std::chrono::system_clock
-#include <ctime>   // For std::time_t and std::localtime
-#include <iomanip> // For std::put_time and std::setw
-#include <iostream>
-#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
 #include <thread>
 #include <utility>
-
-namespace asio = boost::asio;
+#include <vector>
 
 namespace STNL {
-std::unique_ptr<asio::strand<asio::io_context::executor_type>> Logger::strand_ = nullptr;
-
-LogStream::LogStream(std::string logType) : logType_(std::move(logType)) {
-    auto now = std::chrono::system_clock::now();
-    auto duration = now.time_since_epoch();
-    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration) % std::chrono::seconds(1);
-    std::time_t now_c = std::chrono::system_clock::to_time_t(now);
-    std::tm *tm = std::localtime(&now_c);
-    
-    // ANSI color codes
-    const char* color;
-    const char* reset = "\033[0m";
-    
-    if (logType_ == "DBG") {
-        color = "\033[36m";  // Cyan
-    } else if (logType_ == "INF") {
-        color = "\033[32m";  // Green
-    } else if (logType_ == "WRN") {
-        color = "\033[33m";  // Yellow
-    } else if (logType_ == "ERR") {
-        color = "\033[31m";  // Red
-    } else {
-        color = "\033[37m";  // White
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+
+void AppendPrefix(std::string &out, LogLevel level, Clock::time_point time);
+void AppendIndented(std::string &out, std::string_view message);
+
+} // namespace
+
+namespace detail {
+
+// Bounded multi-producer / single-consumer ring (Vyukov): a slot is free for the producer
+// that claimed position p when its sequence is p, and readable once it is p + 1. Slot
+// strings keep their capacity between uses, so steady state logging does not allocate.
+// A slot holds either a formatted record or, for Logger::Write, the format string and a
+// copy of its arguments, formatted by the logger thread.
+class LogBackend {
+  public:
+    explicit LogBackend(LoggerOptions options) : options_(std::move(options)) {
+        size_t capacity = 1;
+        while (capacity < std::max<size_t>(options_.capacity, 2)) { capacity <<= 1; }
+        mask_ = capacity - 1;
+        slots_ = std::make_unique<Slot[]>(capacity);
+        for (size_t i = 0; i < capacity; ++i) {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+            slots_[i].text.reserve(SLOT_RESERVE);
+        }
+        OpenSink();
+        thread_ = std::thread([this]() { Run(); });
+    }
+
+    LogBackend(LogBackend const &) = delete;
+    LogBackend &operator=(LogBackend const &) = delete;
+    ~LogBackend() { Stop(); }
+
+    void Stop() {
+        if (!running_.exchange(false)) { return; }
+        wakeup_.notify_one();
+        if (thread_.joinable()) { thread_.join(); }
+        // records pushed while the thread was finishing
+        std::string batch;
+        while (Drain(batch) > 0) {
+            Write(batch);
+            batch.clear();
+        }
+        if (fd_ > STDERR_FILENO) { ::close(fd_); }
+        fd_ = -1;
+    }
+
+    auto Push(std::string_view text) -> bool {
+        Slot *slot = Claim();
+        if (slot == nullptr) { return false; }
+        slot->text.assign(text);
+        Publish(*slot);
+        return true;
+    }
+
+    auto PushDeferred(LogLevel level, Clock::time_point time, std::string_view fmt, detail::LogFormatFn format, detail::LogEmplaceFn emplace,
+                      void *source) -> bool {
+        Slot *slot = Claim();
+        if (slot == nullptr) { return false; }
+        emplace(slot->args, source);
+        slot->format = format;
+        slot->fmt = fmt;
+        slot->level = level;
+        slot->time = time;
+        Publish(*slot);
+        return true;
+    }
+
+    auto DroppedTotal() const -> uint64_t { return droppedTotal_.load(std::memory_order_relaxed); }
+    auto ToTerminal() const -> bool { return options_.file.empty() && ::isatty(STDOUT_FILENO) == 1; }
+
+  private:
+    static constexpr size_t SLOT_RESERVE = 256;
+    static constexpr size_t SLOT_KEEP = 4096; // larger strings are released after use
+
+    struct Slot {
+        std::atomic<size_t> seq{0};
+        std::string text;
+        detail::LogFormatFn format = nullptr; // set for deferred records
+        std::string_view fmt;
+        LogLevel level = LogLevel::Debug;
+        Clock::time_point time;
+        alignas(std::max_align_t) std::byte args[detail::LOG_ARGS_BYTES];
+    };
+
+    // Reserves the next slot, or counts a drop when the ring is full.
+    auto Claim() -> Slot * {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = slots_[pos & mask_];
+            size_t const seq = slot.seq.load(std::memory_order_acquire);
+            auto const diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { return &slot; }
+            } else if (diff < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                droppedTotal_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void Publish(Slot &slot) {
+        slot.seq.store(slot.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        if (sleeping_.load(std::memory_order_acquire)) { wakeup_.notify_one(); }
+    }
+
+    void Run() {
+        std::string batch;
+        batch.reserve(options_.batchSize * SLOT_RESERVE);
+        while (running_.load(std::memory_order_acquire)) {
+            if (Drain(batch) == 0) {
+                /* nothing queued: sleep until a producer sees `sleeping_` and notifies, or at
+                 * the latest flushInterval (a notify racing the check above is only delayed) */
+                std::unique_lock lock(mutex_);
+                sleeping_.store(true, std::memory_order_release);
+                wakeup_.wait_for(lock, options_.flushInterval);
+                sleeping_.store(false, std::memory_order_release);
+                continue;
+            }
+            Write(batch);
+            batch.clear();
+        }
+    }
+
+    // Moves up to batchSize records into `batch`, one per line.
+    auto Drain(std::string &batch) -> size_t {
+        size_t n = 0;
+        for (; n < options_.batchSize; ++n) {
+            Slot &slot = slots_[head_ & mask_];
+            if (slot.seq.load(std::memory_order_acquire) != head_ + 1) { break; }
+            if (slot.format != nullptr) {
+                AppendPrefix(batch, slot.level, slot.time);
+                scratch_.clear();
+                slot.format(scratch_, slot.fmt, slot.args);
+                slot.format = nullptr;
+                AppendIndented(batch, scratch_);
+            } else {
+                batch.append(slot.text);
+            }
+            batch.push_back('\n');
+            if (slot.text.capacity() > SLOT_KEEP) {
+                std::string{}.swap(slot.text);
+            } else {
+                slot.text.clear();
+            }
+            slot.seq.store(head_ + mask_ + 1, std::memory_order_release);
+            ++head_;
+        }
+        if (uint64_t const dropped = dropped_.exchange(0, std::memory_order_relaxed); dropped > 0) {
+            batch += "[logger] dropped " + std::to_string(dropped) + " record(s), the queue was full\n";
+            ++n;
+        }
+        return n;
+    }
+
+    void OpenSink() {
+        if (options_.file.empty()) {
+            fd_ = STDOUT_FILENO;
+            return;
+        }
+        fd_ = ::open(options_.file.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            std::fprintf(stderr, "Logger: cannot open %s (errno %d), logging to stdout\n", options_.file.c_str(), errno);
+            fd_ = STDOUT_FILENO;
+            return;
+        }
+        struct stat st {};
+        written_ = ::fstat(fd_, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+    }
+
+    void Rotate() {
+        ::close(fd_);
+        for (size_t i = options_.rotateKeep; i > 1; --i) {
+            std::string const from = options_.file + '.' + std::to_string(i - 1);
+            std::string const to = options_.file + '.' + std::to_string(i);
+            std::rename(from.c_str(), to.c_str());
+        }
+        if (options_.rotateKeep > 0) {
+            std::rename(options_.file.c_str(), (options_.file + ".1").c_str());
+        } else {
+            std::remove(options_.file.c_str());
+        }
+        written_ = 0;
+        OpenSink();
+    }
+
+    void Write(std::string const &batch) {
+        if (fd_ == STDOUT_FILENO) {
+            std::fflush(stdout); // keep the order with std::cout output
+        } else if (options_.rotateBytes > 0 && written_ > 0 && written_ + batch.size() > options_.rotateBytes) {
+            Rotate();
+        }
+        char const *p = batch.data();
+        size_t left = batch.size();
+        while (left > 0) {
+            ssize_t const n = ::write(fd_, p, left);
+            if (n < 0) {
+                if (errno == EINTR) { continue; }
+                return;
+            }
+            p += n;
+            left -= static_cast<size_t>(n);
+        }
+        written_ += batch.size();
     }
-    
-    std::ostringstream oss;
-    // Format: [HH:MM:SS.mmm] LEVEL  message
-    oss << "[" 
-        << std::put_time(tm, "%H:%M:%S") << '.' 
-        << std::setfill('0') << std::setw(3) << static_cast<int>(ms.count()) 
-        << "] "
-        << color << std::setw(5) << std::left << logType_ << reset << " ";
-    buffer_ << oss.str();
+
+    LoggerOptions options_;
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) size_t head_ = 0; // logger thread only
+    std::string scratch_;         // logger thread only
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> droppedTotal_{0};
+    std::atomic<bool> running_{true};
+    std::atomic<bool> sleeping_{false};
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::thread thread_;
+    int fd_ = -1;
+    size_t written_ = 0;
+};
+
+} // namespace detail
+
+namespace {
+
+using detail::LogBackend;
+
+std::mutex gLifecycleMutex;
+std::atomic<LogBackend *> gActive{nullptr};
+bool gStarted = false; // under gLifecycleMutex, Start is honoured once
+std::atomic<bool> gColored{::isatty(STDOUT_FILENO) == 1};
+
+// Flushes at exit when Stop was not called; later records are written directly.
+struct BackendHolder {
+    std::unique_ptr<LogBackend> backend;
+    BackendHolder() = default;
+    BackendHolder(BackendHolder const &) = delete;
+    BackendHolder &operator=(BackendHolder const &) = delete;
+    ~BackendHolder() {
+        gActive.store(nullptr, std::memory_order_release);
+        backend.reset();
+    }
+} gBackend;
+
+void WriteDirect(std::string_view msg) {
+    std::string line{msg};
+    line.push_back('\n');
+    std::fflush(stdout);
+    [[maybe_unused]] ssize_t const n = ::write(STDOUT_FILENO, line.data(), line.size());
+}
+
+// "HH:MM:SS" of the current second, formatted once per second and thread.
+auto ClockPrefix(std::time_t now) -> std::string_view {
+    thread_local std::time_t second = -1;
+    thread_local char hms[9] = {};
+    if (now != second) {
+        std::tm tm{};
+        localtime_r(&now, &tm);
+        std::strftime(hms, sizeof(hms), "%H:%M:%S", &tm);
+        second = now;
+    }
+    return {hms, 8};
+}
+
+
+// Format: [HH:MM:SS.mmm] LEVEL  message
+void AppendPrefix(std::string &out, LogLevel level, Clock::time_point time) {
+    // ANSI color codes, indexed by level: cyan, green, yellow, red
+    static constexpr std::string_view NAMES[] = {"DBG", "INF", "WRN", "ERR"};
+    static constexpr std::string_view COLORS[] = {"\033[36m", "\033[32m", "\033[33m", "\033[31m"};
+    auto const index = std::min<size_t>(static_cast<size_t>(level), std::size(NAMES) - 1);
+
+    auto const millis = static_cast<int>((std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()) % std::chrono::seconds(1)).count());
+    out += '[';
+    out += ClockPrefix(Clock::to_time_t(time));
+    out += '.';
+    out += static_cast<char>('0' + millis / 100);
+    out += static_cast<char>('0' + millis / 10 % 10);
+    out += static_cast<char>('0' + millis % 10);
+    out += "] ";
+    bool const colored = Logger::Colored();
+    if (colored) { out += COLORS[index]; }
+    out += NAMES[index];
+    out += "  ";
+    if (colored) { out += "\033[0m"; }
+    out += ' ';
+}
+
+// Appends `message`, indenting continuation lines so they align with where the
+// message starts (after "[HH:MM:SS.mmm] LEVEL ").
+void AppendIndented(std::string &out, std::string_view message) {
+    constexpr std::string_view INDENT = "                    ";
+    size_t pos = 0;
+    for (size_t found = message.find('\n'); found != std::string_view::npos; found = message.find('\n', pos)) {
+        // Append everything up to and including the newline
+        out.append(message.substr(pos, found - pos + 1));
+        pos = found + 1;
+        // If there's more content after this newline, add indent
+        if (pos < message.size()) { out += INDENT; }
+    }
+    out.append(message.substr(pos));
+}
+
+} // namespace
+
+auto LoggerOptions::FromConfig(std::string const &keyPath) -> LoggerOptions {
+    LoggerOptions options;
+    auto file = Config::Value<std::string>(keyPath + ".file");
+    auto capacity = Config::Value<int64_t>(keyPath + ".capacity");
+    auto batchSize = Config::Value<int64_t>(keyPath + ".batchSize");
+    auto flushIntervalMs = Config::Value<int64_t>(keyPath + ".flushIntervalMs");
+    auto rotateBytes = Config::Value<int64_t>(keyPath + ".rotateBytes");
+    auto rotateKeep = Config::Value<int64_t>(keyPath + ".rotateKeep");
+    if (file) { options.file = *file; }
+    if (capacity && *capacity > 0) { options.capacity = static_cast<size_t>(*capacity); }
+    if (batchSize && *batchSize > 0) { options.batchSize = static_cast<size_t>(*batchSize); }
+    if (flushIntervalMs && *flushIntervalMs > 0) { options.flushInterval = std::chrono::milliseconds(*flushIntervalMs); }
+    if (rotateBytes && *rotateBytes >= 0) { options.rotateBytes = static_cast<size_t>(*rotateBytes); }
+    if (rotateKeep && *rotateKeep >= 0) { options.rotateKeep = static_cast<size_t>(*rotateKeep); }
+    if (auto level = Config::Value<std::string>(keyPath + ".level")) { options.level = Logger::LevelFromName(*level, options.level); }
+    return options;
+}
+
+LogStream::LogStream(LogLevel level) : enabled_(Logger::Enabled(level)) {
+    if (!enabled_) { return; }
+    buffer_.reserve(128);
+    AppendPrefix(buffer_, level, Clock::now());
 }
 
 // The core logic runs when the LogStream object is destroyed (goes out of
 // scope).
 LogStream::~LogStream() {
-    std::string message = buffer_.str();
-    
-    // Check if message contains newlines (multi-line content)
-    size_t pos = 0;
-    size_t found = message.find('\n', pos);
-    
-    if (found != std::string::npos && found < message.length() - 1) {
-        // Multi-line message detected - indent continuation lines
-        // The indent should align with where the message starts (after timestamp and level)
-        const std::string indent = "                    "; // 20 spaces to align after "[HH:MM:SS.mmm] LEVEL "
-        
+    if (!enabled_) { return; }
+    // the prefix has no newline, so indenting the whole record only touches the message
+    if (size_t const found = buffer_.find('\n'); found != std::string::npos && found < buffer_.size() - 1) {
         std::string formatted;
-        formatted.reserve(message.size() + 100); // Reserve extra space for indents
-        
-        while (found != std::string::npos) {
-            // Append everything up to and including the newline
-            formatted.append(message, pos, found - pos + 1);
-            pos = found + 1;
-            
-            // If there's more content after this newline, add indent
-            if (pos < message.length()) {
-                formatted.append(indent);
-            }
-            
-            found = message.find('\n', pos);
-        }
-        
-        // Append any remaining content
-        if (pos < message.length()) {
-            formatted.append(message, pos, message.length() - pos);
-        }
-        
+        formatted.reserve(buffer_.size() + 100); // Reserve extra space for indents
+        AppendIndented(formatted, buffer_);
         Logger::Log(formatted);
     } else {
         // Single-line message - log as-is
-        Logger::Log(message);
+        Logger::Log(buffer_);
+    }
+}
+
+void Logger::Start(LoggerOptions const &options) {
+    std::scoped_lock lock(gLifecycleMutex);
+    if (gActive.load(std::memory_order_acquire) != nullptr) { return; }
+    /* producers use the published backend without pinning it, so a stopped backend is kept
+     * until exit and never replaced: one may still be inside its Push */
+    if (gStarted) {
+        WriteDirect("Logger::Start: the logger cannot be restarted after Stop, records are written synchronously");
+        return;
+    }
+    gStarted = true;
+    SetLevel(options.level);
+    gBackend.backend = std::make_unique<LogBackend>(options);
+    gColored.store(gBackend.backend->ToTerminal(), std::memory_order_relaxed);
+    gActive.store(gBackend.backend.get(), std::memory_order_release);
+}
+
+void Logger::Stop() {
+    std::scoped_lock lock(gLifecycleMutex);
+    LogBackend *backend = gActive.exchange(nullptr, std::memory_order_acq_rel);
+    if (backend != nullptr) { backend->Stop(); }
+}
+
+void Logger::Log(std::string_view msg) {
+    LogBackend *backend = gActive.load(std::memory_order_acquire);
+    if (backend == nullptr) {
+        WriteDirect(msg);
+        return;
     }
+    // a full ring drops the record, counted and reported by the logger thread
+    backend->Push(msg);
 }
 
-void Logger::Init(asio::io_context &ioc) {
-    strand_ = std::make_unique<asio::strand<asio::io_context::executor_type>>(ioc.get_executor());
+void Logger::Emit(LogLevel level, std::string_view msg) {
+    LogStream stream(level);
+    stream << msg;
 }
 
-void Logger::Log(std::string msg) {
-    if (!strand_) {
-        std::cout << msg << std::endl;  // Use endl for immediate flush
+void Logger::Defer(LogLevel level, std::string_view fmt, detail::LogFormatFn format, detail::LogEmplaceFn emplace, void *source) {
+    auto const now = Clock::now();
+    if (LogBackend *backend = gActive.load(std::memory_order_acquire); backend != nullptr) {
+        // a full ring drops the record, counted and reported by the logger thread
+        backend->PushDeferred(level, now, fmt, format, emplace, source);
         return;
     }
-    // Post the actual logging to the strand to ensure thread-safe, sequential
-    // writes. We capture the strings by value (using std::move on the temporary
-    // arguments) to ensure they are copied safely into the heap-allocated
-    // lambda closure.
-    asio::post(*strand_, [msg = std::move(msg)]() { std::cout << msg << std::endl; });
+    alignas(std::max_align_t) std::byte args[detail::LOG_ARGS_BYTES];
+    emplace(args, source);
+    std::string message;
+    format(message, fmt, args);
+    std::string record;
+    AppendPrefix(record, level, now);
+    AppendIndented(record, message);
+    WriteDirect(record);
+}
+
+auto Logger::LevelFromName(std::string_view name, LogLevel fallback) -> LogLevel {
+    std::string lower;
+    for (char c : name) { lower += static_cast<char>(std::tolower(static_cast<unsigned char>(c))); }
+    if (lower == "debug" || lower == "dbg") { return LogLevel::Debug; }
+    if (lower == "info" || lower == "inf") { return LogLevel::Info; }
+    if (lower == "warning" || lower == "warn" || lower == "wrn") { return LogLevel::Warning; }
+    if (lower == "error" || lower == "err") { return LogLevel::Error; }
+    if (lower == "off" || lower == "none") { return LogLevel::Off; }
+    return fallback;
+}
+
+LogChannel::LogChannel(LoggerOptions const &options) : backend_(std::make_unique<LogBackend>(options)) {}
+
+LogChannel::~LogChannel() = default;
+
+auto LogChannel::Write(std::string_view line) -> bool {
+    return backend_->Push(line);
+}
+
+auto LogChannel::Dropped() const -> uint64_t {
+    return backend_->DroppedTotal();
+}
+
+auto Logger::Dropped() -> uint64_t {
+    std::scoped_lock lock(gLifecycleMutex);
+    return gBackend.backend ? gBackend.backend->DroppedTotal() : 0;
+}
+
+auto Logger::Colored() -> bool {
+    return gColored.load(std::memory_order_relaxed);
 }
 
 auto Logger::Dbg() -> LogStream {
-    return {"DBG"};
+    return {LogLevel::Debug};
 }
 auto Logger::Inf() -> LogStream {
-    return {"INF"};
+    return {LogLevel::Info};
 }
 auto Logger::Err() -> LogStream {
-    return {"ERR"};
+    return {LogLevel::Error};
 }
 auto Logger::Wrn() -> LogStream {
-    return {"WRN"};
+    return {LogLevel::Warning};
 }
 
 void Logger::Dbg(std::string_view msg) {
-    Dbg() << std::string(msg);
+    Dbg() << msg;
 }
 void Logger::Inf(std::string_view msg) {
-    Inf() << std::string(msg);
+    Inf() << msg;
 }
 void Logger::Err(std::string_view msg) {
-    Err() << std::string(msg);
+    Err() << msg;
 }
 void Logger::Wrn(std::string_view msg) {
-    Wrn() << std::string(msg);
+    Wrn() << msg;
 }
 } // namespace STNL
@@ -0,0 +1,83 @@
+#include "stnl/core/metrics.hpp"
+
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace STNL {
+
+auto Counter::Value() const -> uint64_t {
+    int64_t sum = 0;
+    for (detail::MetricCell const &cell : cells_) { sum += cell.value.load(std::memory_order_relaxed); }
+    return static_cast<uint64_t>(sum);
+}
+
+void Gauge::Set(int64_t value) {
+    Add(value - Value());
+}
+
+auto Gauge::Value() const -> int64_t {
+    int64_t sum = 0;
+    for (detail::MetricCell const &cell : cells_) { sum += cell.value.load(std::memory_order_relaxed); }
+    return sum;
+}
+
+void Histogram::Snapshot(LatencyHistogram &out) const {
+    for (detail::HistogramCell const &shard : shards_) { out.Merge(shard.histogram); }
+}
+
+auto Metrics::AddCounter(std::string const &name, std::string const &help, std::string const &labels) -> Counter & {
+    return *GetSeries(name, help, labels, Type::Counter).counter;
+}
+
+auto Metrics::AddGauge(std::string const &name, std::string const &help, std::string const &labels) -> Gauge & {
+    return *GetSeries(name, help, labels, Type::Gauge).gauge;
+}
+
+auto Metrics::AddHistogram(std::string const &name, std::string const &help, std::string const &labels) -> Histogram & {
+    return *GetSeries(name, help, labels, Type::Histogram).histogram;
+}
+
+auto Metrics::GetSeries(std::string const &name, std::string const &help, std::string const &labels, Type type) -> Series & {
+    std::scoped_lock lock(mutex_);
+    auto [it, inserted] = families_.try_emplace(name, Family{.type = type, .help = help, .series = {}});
+    Family &family = it->second;
+    if (family.type != type) { throw std::invalid_argument(std::format("Metric {} is already registered with another type", name)); }
+    for (std::unique_ptr<Series> const &series : family.series) {
+        if (series->labels == labels) { return *series; }
+    }
+    auto series = std::make_unique<Series>();
+    series->labels = labels;
+    switch (type) {
+    case Type::Counter: series->counter = std::make_unique<Counter>(); break;
+    case Type::Gauge: series->gauge = std::make_unique<Gauge>(); break;
+    case Type::Histogram: series->histogram = std::make_unique<Histogram>(); break;
+    }
+    family.series.push_back(std::move(series));
+    return *family.series.back();
+}
+
+void Metrics::RenderPrometheus(std::string &out) const {
+    std::scoped_lock lock(mutex_);
+    for (auto const &[name, family] : families_) {
+        char const *type = family.type == Type::Counter ? "counter" : family.type == Type::Gauge ? "gauge" : "histogram";
+        out += std::format("# HELP {} {}\n# TYPE {} {}\n", name, family.help, name, type);
+        for (std::unique_ptr<Series> const &series : family.series) {
+            std::string const labels = series->labels.empty() ? "" : std::format("{{{}}}", series->labels);
+            switch (family.type) {
+            case Type::Counter: out += std::format("{}{} {}\n", name, labels, series->counter->Value()); break;
+            case Type::Gauge: out += std::format("{}{} {}\n", name, labels, series->gauge->Value()); break;
+            case Type::Histogram: {
+                /* a LatencyHistogram is a few KiB of atomics, keep it off the stack */
+                auto merged = std::make_unique<LatencyHistogram>();
+                series->histogram->Snapshot(*merged);
+                merged->RenderPrometheus(out, name, series->labels);
+                break;
+            }
+            }
+        }
+    }
+}
+
+} // namespace STNL
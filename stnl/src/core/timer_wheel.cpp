@@ -0,0 +1,108 @@
+#include "stnl/core/timer_wheel.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace STNL {
+
+TimerWheel::TimerWheel(asio::any_io_executor executor, std::chrono::milliseconds tick, size_t slots)
+    : timer_(std::move(executor)), tick_(std::max(tick, std::chrono::milliseconds(1))), slots_(std::max<size_t>(slots, 1), nullptr) {}
+
+TimerWheel::~TimerWheel() {
+    Stop();
+}
+
+void TimerWheel::Start() {
+    std::scoped_lock lock(mutex_);
+    if (!stopped_) { return; }
+    stopped_ = false;
+    ScheduleTick();
+}
+
+void TimerWheel::Stop() {
+    std::scoped_lock lock(mutex_);
+    stopped_ = true;
+    timer_.cancel();
+}
+
+void TimerWheel::ScheduleTick() {
+    timer_.expires_after(tick_);
+    timer_.async_wait([this](boost::system::error_code ec) {
+        if (ec) { return; }
+        Tick();
+        std::scoped_lock lock(mutex_);
+        if (!stopped_) { ScheduleTick(); }
+    });
+}
+
+auto TimerWheel::Arm(Entry &entry, std::chrono::milliseconds timeout) -> uint64_t {
+    /* Arm lands anywhere inside the current tick, so the next Tick may be only a moment
+     * away: one tick more than the timeout needs keeps it from firing early */
+    uint64_t const ticks = static_cast<uint64_t>((std::max<int64_t>(timeout.count(), 0) + tick_.count() - 1) / tick_.count()) + 1;
+    std::scoped_lock lock(mutex_);
+    if (entry.linked_) { UnlinkLocked(entry); }
+    /* the slot is visited every slots_.size() ticks, the first time (ticks - 1) % size + 1
+     * ticks from now; it fires on the visit where no rounds are left */
+    entry.slot_ = (cursor_ + ticks) % slots_.size();
+    entry.rounds_ = (ticks - 1) / slots_.size();
+    entry.sequence_ = ++nextSequence_;
+    LinkLocked(entry);
+    return entry.sequence_;
+}
+
+void TimerWheel::Cancel(Entry &entry) {
+    std::scoped_lock lock(mutex_);
+    if (entry.linked_) { UnlinkLocked(entry); }
+}
+
+auto TimerWheel::Size() const -> size_t {
+    std::scoped_lock lock(mutex_);
+    return size_;
+}
+
+auto TimerWheel::Tick() -> size_t {
+    std::vector<std::pair<std::function<void(uint64_t)>, uint64_t>> due;
+    {
+        std::scoped_lock lock(mutex_);
+        ++cursor_;
+        Entry *entry = slots_[cursor_ % slots_.size()];
+        while (entry != nullptr) {
+            Entry *next = entry->next_;
+            if (entry->rounds_ == 0) {
+                UnlinkLocked(*entry);
+                if (entry->callback) { due.emplace_back(entry->callback, entry->sequence_); }
+            } else {
+                --entry->rounds_;
+            }
+            entry = next;
+        }
+    }
+    // outside of the lock: callbacks may arm or cancel entries, and their owners may be gone by now
+    for (auto &[callback, sequence] : due) { callback(sequence); }
+    return due.size();
+}
+
+void TimerWheel::LinkLocked(Entry &entry) {
+    Entry *&head = slots_[entry.slot_];
+    entry.prev_ = nullptr;
+    entry.next_ = head;
+    if (head != nullptr) { head->prev_ = &entry; }
+    head = &entry;
+    entry.linked_ = true;
+    ++size_;
+}
+
+void TimerWheel::UnlinkLocked(Entry &entry) {
+    if (entry.prev_ != nullptr) {
+        entry.prev_->next_ = entry.next_;
+    } else {
+        slots_[entry.slot_] = entry.next_;
+    }
+    if (entry.next_ != nullptr) { entry.next_->prev_ = entry.prev_; }
+    entry.prev_ = nullptr;
+    entry.next_ = nullptr;
+    entry.linked_ = false;
+    --size_;
+}
+
+} // namespace STNL
@@ -127,4 +127,37 @@ auto Utils::FixIndent(const std::string_view s) -> std::string {
     trim(finalOutput);
     return finalOutput;
 }
+
+auto Utils::Fnv1a64(std::string_view s) -> uint64_t {
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+auto Utils::Base64Encode(std::string_view bytes) -> std::string {
+    static constexpr char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((bytes.size() + 2) / 3 * 4);
+    size_t i = 0;
+    for (; i + 2 < bytes.size(); i += 3) {
+        uint32_t const n = (static_cast<uint8_t>(bytes[i]) << 16) | (static_cast<uint8_t>(bytes[i + 1]) << 8) | static_cast<uint8_t>(bytes[i + 2]);
+        out += ALPHABET[(n >> 18) & 63];
+        out += ALPHABET[(n >> 12) & 63];
+        out += ALPHABET[(n >> 6) & 63];
+        out += ALPHABET[n & 63];
+    }
+    if (i < bytes.size()) {
+        uint32_t n = static_cast<uint8_t>(bytes[i]) << 16;
+        if (i + 1 < bytes.size()) { n |= static_cast<uint8_t>(bytes[i + 1]) << 8; }
+        out += ALPHABET[(n >> 18) & 63];
+        out += ALPHABET[(n >> 12) & 63];
+        out += i + 1 < bytes.size() ? ALPHABET[(n >> 6) & 63] : '=';
+        out += '=';
+    }
+    return out;
+}
+
 } // namespace STNL
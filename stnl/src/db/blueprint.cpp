@@ -3,9 +3,13 @@
 
 #include "stnl/core/utils.hpp"
 #include "stnl/db/column.hpp"
+#include "stnl/db/index_def.hpp"
+#include "stnl/db/partition_def.hpp"
 
 #include <boost/optional.hpp>
 
+#include <deque>
+#include <format>
 #include <map>
 #include <string>
 #include <utility>
@@ -41,6 +45,61 @@ void Blueprint::AddColumn(Column &&col) {
     columns_.emplace(col.name, std::move(col));
 }
 
+void Blueprint::AddIndex(IndexDef &&index) {
+    indexes_.push_back(std::move(index));
+}
+
+auto Blueprint::Index(std::vector<std::string> columns) -> IndexProxy {
+    IndexDef &index = indexes_.emplace_back();
+    index.columns = std::move(columns);
+    return IndexProxy{index};
+}
+
+auto Blueprint::GetIndexes() const -> std::deque<IndexDef> const & {
+    return indexes_;
+}
+
+auto Blueprint::PartitionByRange(std::vector<std::string> columns) -> PartitionProxy {
+    partition_ = PartitionDef{};
+    partition_.strategy = PartitionStrategy::Range;
+    partition_.columns = std::move(columns);
+    return PartitionProxy{partition_};
+}
+
+auto Blueprint::PartitionByList(std::string const &column) -> PartitionProxy {
+    partition_ = PartitionDef{};
+    partition_.strategy = PartitionStrategy::List;
+    partition_.columns = {column};
+    return PartitionProxy{partition_};
+}
+
+auto Blueprint::PartitionByHash(std::vector<std::string> columns) -> PartitionProxy {
+    partition_ = PartitionDef{};
+    partition_.strategy = PartitionStrategy::Hash;
+    partition_.columns = std::move(columns);
+    return PartitionProxy{partition_};
+}
+
+auto Blueprint::GetPartition() const -> PartitionDef const & {
+    return partition_;
+}
+
+auto Blueprint::GetEffectiveIndexes() const -> std::vector<IndexDef> {
+    std::vector<IndexDef> indexes;
+    indexes.reserve(indexes_.size() + columnNames_.size());
+    for (std::string const &columnName : columnNames_) {
+        Column const &col = columns_.at(columnName);
+        if (!col.unique && !col.index) { continue; }
+        IndexDef &index = indexes.emplace_back();
+        index.columns = {col.realName};
+        index.unique = col.unique;
+        // the names the migrator has always used for column indexes
+        index.name = std::format("{}_{}_{}", Utils::StringToLower(tableName_), col.name, col.unique ? "key" : "idx");
+    }
+    indexes.insert(indexes.end(), indexes_.begin(), indexes_.end());
+    return indexes;
+}
+
 auto Blueprint::BigInt(const std::string &name) -> BigIntProxy {
     Column &col = GetOrAddColumn(name);
     return BigIntProxy{col};
@@ -100,4 +159,29 @@ auto Blueprint::Text(const std::string &name) -> TextProxy {
     Column &col = GetOrAddColumn(name);
     return {col};
 }
+
+auto Blueprint::Real(const std::string &name) -> RealProxy {
+    Column &col = GetOrAddColumn(name);
+    return RealProxy{col};
+}
+
+auto Blueprint::DoublePrecision(const std::string &name) -> DoublePrecisionProxy {
+    Column &col = GetOrAddColumn(name);
+    return DoublePrecisionProxy{col};
+}
+
+auto Blueprint::Json(const std::string &name) -> JsonProxy {
+    Column &col = GetOrAddColumn(name);
+    return JsonProxy{col};
+}
+
+auto Blueprint::Jsonb(const std::string &name) -> JsonbProxy {
+    Column &col = GetOrAddColumn(name);
+    return JsonbProxy{col};
+}
+
+auto Blueprint::Bytea(const std::string &name) -> ByteaProxy {
+    Column &col = GetOrAddColumn(name);
+    return ByteaProxy{col};
+}
 } // namespace STNL
@@ -14,7 +14,7 @@ constexpr std::size_t DEFAULT_BIT_LENGTH = 1;
 } // namespace
 Column::Column(std::string colTableName, const std::string &colRealName, SQLDataType colType)
     : tableName(std::move(std::move(colTableName))), realName(colRealName), type(colType), length(0), identity(false), index(false), unique(false),
-      nullable(false), precision(0), scale(0) {
+      nullable(false), array(false), precision(0), scale(0), explicitPrecision(false), narrowPrecision(false) {
     name = Utils::StringToLower(colRealName);
 }
 
@@ -164,6 +164,13 @@ auto TimestampProxy::Index(bool v) -> TimestampProxy & {
     return *this;
 }
 
+auto TimestampProxy::Precision(unsigned short v, bool narrow) -> TimestampProxy & {
+    col.precision = v;
+    col.explicitPrecision = true;
+    col.narrowPrecision = narrow;
+    return *this;
+}
+
 UUIDProxy::UUIDProxy(Column &c) : ColumnProxy(c) {
     col.type = SQLDataType::UUID;
 }
@@ -186,4 +193,24 @@ TextProxy::TextProxy(Column &c) : ColumnProxy(c) {
     col.type = SQLDataType::Text;
 }
 
+RealProxy::RealProxy(Column &c) : ColumnProxy(c) {
+    col.type = SQLDataType::Real;
+}
+
+DoublePrecisionProxy::DoublePrecisionProxy(Column &c) : ColumnProxy(c) {
+    col.type = SQLDataType::DoublePrecision;
+}
+
+JsonProxy::JsonProxy(Column &c) : ColumnProxy(c) {
+    col.type = SQLDataType::Json;
+}
+
+JsonbProxy::JsonbProxy(Column &c) : ColumnProxy(c) {
+    col.type = SQLDataType::Jsonb;
+}
+
+ByteaProxy::ByteaProxy(Column &c) : ColumnProxy(c) {
+    col.type = SQLDataType::Bytea;
+}
+
 } // namespace STNL
@@ -1,44 +1,400 @@
 
 #include "stnl/db/connection_pool.hpp"
+#include "stnl/core/config.hpp"
 #include "stnl/core/logger.hpp"
 
 #include <algorithm>
+#include <boost/asio.hpp>
 #include <pqxx/pqxx>
 
+#include <chrono>
 #include <condition_variable>
+#include <format>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+namespace asio = boost::asio;
+
 namespace STNL {
 
-ConnectionPool::ConnectionPool(std::string connStr, std::size_t maxSize) : connStr_(std::move(connStr)), maxSize_(maxSize), size_(0) {
-    maxSize_ = std::max<size_t>(maxSize_, 1);
-    pool_.reserve(maxSize_);
+namespace {
+constexpr std::chrono::milliseconds CONNECT_RETRY_INITIAL{50};
+constexpr std::chrono::milliseconds CONNECT_RETRY_MAX{1000};
+constexpr std::chrono::seconds WARM_UP_TIMEOUT{10};
+// Connections idle for longer than this are pinged before being handed out.
+constexpr std::chrono::seconds VALIDATE_AFTER_IDLE{30};
+constexpr size_t CONNECTOR_THREADS = 4;
+
+// Blocking connects (with their retry backoff) for async waiters run here, never on the
+// caller's io threads. Shared by every pool in the process.
+auto Connector() -> asio::thread_pool & {
+    static asio::thread_pool connector(CONNECTOR_THREADS);
+    return connector;
+}
+} // namespace
+
+auto PoolOptions::FromConfig(std::string const &keyPath) -> PoolOptions {
+    PoolOptions options;
+    auto minIdle = Config::Value<int64_t>(keyPath + ".minIdle");
+    auto maxSize = Config::Value<int64_t>(keyPath + ".maxSize");
+    auto acquireTimeoutMs = Config::Value<int64_t>(keyPath + ".acquireTimeoutMs");
+    auto idleTimeoutMs = Config::Value<int64_t>(keyPath + ".idleTimeoutMs");
+    auto maxLifetimeMs = Config::Value<int64_t>(keyPath + ".maxLifetimeMs");
+    if (minIdle && *minIdle >= 0) { options.minIdle = static_cast<size_t>(*minIdle); }
+    if (maxSize && *maxSize > 0) { options.maxSize = static_cast<size_t>(*maxSize); }
+    if (acquireTimeoutMs && *acquireTimeoutMs > 0) { options.acquireTimeout = std::chrono::milliseconds(*acquireTimeoutMs); }
+    if (idleTimeoutMs && *idleTimeoutMs > 0) { options.idleTimeout = std::chrono::milliseconds(*idleTimeoutMs); }
+    if (maxLifetimeMs && *maxLifetimeMs >= 0) { options.maxLifetime = std::chrono::milliseconds(*maxLifetimeMs); }
+    return options;
+}
+
+ConnectionPool::ConnectionPool(std::string connStr, std::size_t maxSize)
+    : ConnectionPool(std::move(connStr), PoolOptions{.minIdle = std::min<size_t>(1, maxSize), .maxSize = maxSize}) {}
+
+ConnectionPool::ConnectionPool(std::string connStr, PoolOptions options) : connStr_(std::move(connStr)), options_(options), opening_(0) {
+    options_.maxSize = std::max<size_t>(options_.maxSize, 1);
+    options_.minIdle = std::min(options_.minIdle, options_.maxSize);
+    maxLifetimeMs_.store(options_.maxLifetime.count(), std::memory_order_relaxed);
+}
+
+void ConnectionPool::Reconfigure(PoolOptions options) {
+    options.maxSize = std::max<size_t>(options.maxSize, 1);
+    options.minIdle = std::min(options.minIdle, options.maxSize);
+    std::vector<std::unique_ptr<pqxx::connection>> trimmed;
+    {
+        std::unique_lock<std::mutex> lock(poolMutex_);
+        // the maintenance interval is left as is, the timer is already armed with it
+        options.maintenanceInterval = options_.maintenanceInterval;
+        options_ = options;
+        maxLifetimeMs_.store(options_.maxLifetime.count(), std::memory_order_relaxed);
+        // least recently used are at the front
+        while (!idle_.empty() && TotalLocked() > options_.maxSize) {
+            trimmed.emplace_back(std::move(idle_.front().conn));
+            idle_.pop_front();
+        }
+        // a larger pool may serve waiters right away
+        ServeWaitersLocked();
+        poolCondition_.notify_all();
+    }
+    Logger::Inf() << std::format("ConnectionPool::Reconfigure: minIdle {}, maxSize {}, closed {} idle connection(s)", options.minIdle, options.maxSize,
+                                 trimmed.size());
+}
+
+ConnectionPool::~ConnectionPool() {
+    StopMaintenance();
+    std::unique_lock<std::mutex> lock(poolMutex_);
+    for (std::shared_ptr<AsyncWaiter> const &waiter : waiters_) {
+        if (waiter->done) { continue; }
+        CompleteWaiter(waiter, asio::error::operation_aborted, nullptr);
+    }
+    waiters_.clear();
+}
+
+void ConnectionPool::WarmUp() {
+    auto const deadline = std::chrono::steady_clock::now() + WARM_UP_TIMEOUT;
+    size_t opened = 0;
+    while (RefillOne(deadline)) { ++opened; }
+    std::unique_lock<std::mutex> lock(poolMutex_);
+    if (idle_.size() < options_.minIdle) {
+        Logger::Wrn() << std::format("ConnectionPool::WarmUp: only {} of {} idle connections could be opened", idle_.size(), options_.minIdle);
+    } else if (opened > 0) {
+        Logger::Inf() << std::format("ConnectionPool::WarmUp: {} connection(s) ready", idle_.size());
+    }
+}
+
+void ConnectionPool::StartMaintenance(asio::any_io_executor executor) {
+    std::unique_lock<std::mutex> lock(poolMutex_);
+    if (maintenanceTimer_) { return; }
+    maintenanceTimer_ = std::make_unique<asio::steady_timer>(std::move(executor));
+    maintenanceStopped_ = false;
+    ScheduleMaintenance();
+}
+
+void ConnectionPool::StopMaintenance() {
+    std::unique_lock<std::mutex> lock(poolMutex_);
+    maintenanceStopped_ = true;
+    if (maintenanceTimer_) { maintenanceTimer_->cancel(); }
+}
+
+void ConnectionPool::ScheduleMaintenance() {
+    maintenanceTimer_->expires_after(options_.maintenanceInterval);
+    maintenanceTimer_->async_wait([weak = weak_from_this()](boost::system::error_code ec) {
+        if (ec) { return; }
+        // reaping only takes the lock; refilling connects, so it runs on the connector and not on the timer's io thread
+        asio::post(Connector(), [weak]() {
+            std::shared_ptr<ConnectionPool> self = weak.lock();
+            if (!self) { return; }
+            self->RunMaintenance();
+            std::unique_lock<std::mutex> lock(self->poolMutex_);
+            if (!self->maintenanceStopped_) { self->ScheduleMaintenance(); }
+        });
+    });
+}
+
+void ConnectionPool::RunMaintenance() {
+    // 1. Reap: idle connections past their lifetime, and idle connections above
+    //    minIdle that have not been used for idleTimeout. Oldest are at the front.
+    std::vector<std::unique_ptr<pqxx::connection>> reaped;
+    {
+        std::unique_lock<std::mutex> lock(poolMutex_);
+        auto const now = std::chrono::steady_clock::now();
+        for (auto it = idle_.begin(); it != idle_.end();) {
+            bool const idleTooLong = (idle_.size() > options_.minIdle) && (now - it->lastUsedAt >= options_.idleTimeout);
+            if (IsExpired(*it, now) || idleTooLong) {
+                reaped.emplace_back(std::move(it->conn));
+                it = idle_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    if (!reaped.empty()) { STNL_LOG_DBG("ConnectionPool: closed {} idle/expired connection(s)", reaped.size()); }
+    reaped.clear(); // close sockets outside of the lock
+
+    // 2. Refill up to minIdle, one connection at a time so the lock is never held while connecting
+    while (RefillOne(std::chrono::steady_clock::now())) {}
+}
+
+auto ConnectionPool::RefillOne(std::chrono::steady_clock::time_point deadline) -> bool {
+    {
+        std::unique_lock<std::mutex> lock(poolMutex_);
+        if (idle_.size() + opening_ >= options_.minIdle || TotalLocked() >= options_.maxSize) { return false; }
+        ++opening_;
+    }
+    std::unique_ptr<pqxx::connection> conn = Connect(connStr_, deadline);
+    bool const opened = (conn != nullptr);
+    std::unique_lock<std::mutex> lock(poolMutex_);
+    --opening_;
+    if (opened) { idle_.push_back(NewPooled(std::move(conn))); }
+    ServeWaitersLocked();
+    if (!idle_.empty()) { poolCondition_.notify_one(); }
+    return opened;
 }
 
 auto ConnectionPool::GetConnection() -> pqxx::connection * {
+    std::chrono::milliseconds timeout;
+    {
+        std::unique_lock<std::mutex> lock(poolMutex_);
+        timeout = options_.acquireTimeout;
+    }
+    return GetConnection(timeout);
+}
+
+auto ConnectionPool::GetConnection(std::chrono::milliseconds timeout) -> pqxx::connection * {
+    auto const deadline = std::chrono::steady_clock::now() + timeout;
     std::unique_lock<std::mutex> lock(poolMutex_);
-    if (size_ < 1 && pool_.size() < maxSize_) {
-        try {
-            pool_.emplace_back(std::make_unique<pqxx::connection>(connStr_));
-            return pool_.back().release();
-        } catch (const std::exception &e) {
-            Logger::Err() << "ConnectionPool::GetConnection: Error: " << std::string(e.what());
+    while (true) {
+        if (!idle_.empty()) {
+            PooledConnection pooled = std::move(idle_.back());
+            idle_.pop_back();
+            // Keep the slot reserved while the connection is validated outside the lock
+            ++opening_;
+            lock.unlock();
+            bool alive = IsAlive(pooled, std::chrono::steady_clock::now());
+            if (!alive) {
+                Logger::Wrn() << "ConnectionPool::GetConnection: dropping dead or expired idle connection";
+                pooled.conn.reset();
+            }
+            lock.lock();
+            --opening_;
+            if (alive) { return LeaseLocked(std::move(pooled)); }
+            ServeWaitersLocked();
+            continue;
+        }
+        if (TotalLocked() < options_.maxSize) {
+            ++opening_;
+            lock.unlock();
+            std::unique_ptr<pqxx::connection> conn = Connect(connStr_, deadline);
+            lock.lock();
+            --opening_;
+            if (conn) { return LeaseLocked(NewPooled(std::move(conn))); }
+            ServeWaitersLocked();
+            poolCondition_.notify_one();
+            return nullptr;
+        }
+        ++blockedWaiters_;
+        std::cv_status const status = poolCondition_.wait_until(lock, deadline);
+        --blockedWaiters_;
+        if (status == std::cv_status::timeout && idle_.empty() && TotalLocked() >= options_.maxSize) {
+            Logger::Wrn() << "ConnectionPool::GetConnection: timed out after " << timeout.count() << "ms waiting for a connection";
             return nullptr;
         }
     }
-    poolCondition_.wait(lock, [this]() { return size_ > 0; });
-    return pool_[--size_].release();
 }
 
-void ConnectionPool::ReturnConnection(pqxx::connection *pConn) {
-    if (pConn == nullptr) { return; }
+void ConnectionPool::AsyncGetConnection(asio::any_io_executor executor, std::chrono::milliseconds timeout, AcquireHandler handler) {
+    auto waiter = std::make_shared<AsyncWaiter>(std::move(executor), std::move(handler));
+    waiter->deadline = std::chrono::steady_clock::now() + timeout;
     std::unique_lock<std::mutex> lock(poolMutex_);
-    pool_[size_++].reset(pConn);
-    poolCondition_.notify_one();
+    // The timer is only ever touched under poolMutex_, which serializes arming and cancellation.
+    waiter->timer.expires_at(waiter->deadline);
+    waiter->timer.async_wait([weak = weak_from_this(), waiter](boost::system::error_code ec) {
+        if (ec) { return; }
+        if (std::shared_ptr<ConnectionPool> self = weak.lock()) { self->OnWaiterTimeout(waiter); }
+    });
+    waiters_.push_back(waiter);
+    ServeWaitersLocked();
+}
+
+void ConnectionPool::ReturnConnection(pqxx::connection *pConn, bool broken) {
+    if (pConn == nullptr) { return; }
+    // pConn is still leased to the caller, so it is safe to inspect outside of the lock
+    bool const dead = broken || !pConn->is_open();
+    auto const now = std::chrono::steady_clock::now();
+    PooledConnection pooled;
+    {
+        std::unique_lock<std::mutex> lock(poolMutex_);
+        auto it = leased_.find(pConn);
+        if (it == leased_.end()) {
+            Logger::Err() << "ConnectionPool::ReturnConnection: connection does not belong to this pool";
+            return;
+        }
+        // decided before the lease is released: above maxSize the pool was shrunk by Reconfigure while this connection was leased
+        bool const overCap = TotalLocked() > options_.maxSize;
+        pooled = std::move(it->second);
+        leased_.erase(it);
+        if (!dead && !overCap && !IsExpired(pooled, now)) {
+            pooled.lastUsedAt = now;
+            idle_.push_back(std::move(pooled));
+        }
+        ServeWaitersLocked();
+        poolCondition_.notify_one();
+    }
+    if (dead) { Logger::Wrn() << "ConnectionPool::ReturnConnection: dropping broken connection"; }
+    pooled.conn.reset(); // close outside of the lock; the freed slot is refilled on demand
+}
+
+auto ConnectionPool::Connect(std::string const &connStr, std::chrono::steady_clock::time_point deadline) -> std::unique_ptr<pqxx::connection> {
+    std::chrono::milliseconds backoff = CONNECT_RETRY_INITIAL;
+    while (true) {
+        try {
+            return std::make_unique<pqxx::connection>(connStr);
+        } catch (const std::exception &e) { Logger::Err() << "ConnectionPool::Connect: Error: " << std::string(e.what()); }
+        if (std::chrono::steady_clock::now() + backoff >= deadline) { return nullptr; }
+        std::this_thread::sleep_for(backoff);
+        backoff = std::min(backoff * 2, CONNECT_RETRY_MAX);
+    }
+}
+
+auto ConnectionPool::IsExpired(PooledConnection const &pooled, std::chrono::steady_clock::time_point now) const -> bool {
+    int64_t const maxLifetimeMs = maxLifetimeMs_.load(std::memory_order_relaxed);
+    return maxLifetimeMs > 0 && now - pooled.createdAt >= std::chrono::milliseconds(maxLifetimeMs);
+}
+
+auto ConnectionPool::IsAlive(PooledConnection const &pooled, std::chrono::steady_clock::time_point now) const -> bool {
+    if (!pooled.conn->is_open() || IsExpired(pooled, now)) { return false; }
+    if (now - pooled.lastUsedAt < VALIDATE_AFTER_IDLE) { return true; }
+    try {
+        pqxx::nontransaction tx(*pooled.conn);
+        tx.exec("SELECT 1");
+        return true;
+    } catch (const std::exception &) { return false; }
+}
+
+auto ConnectionPool::NewPooled(std::unique_ptr<pqxx::connection> conn) -> PooledConnection {
+    auto const now = std::chrono::steady_clock::now();
+    return PooledConnection{.conn = std::move(conn), .createdAt = now, .lastUsedAt = now};
+}
+
+auto ConnectionPool::LeaseLocked(PooledConnection pooled) -> pqxx::connection * {
+    pqxx::connection *pConn = pooled.conn.get();
+    leased_.emplace(pConn, std::move(pooled));
+    return pConn;
+}
+
+void ConnectionPool::ServeWaitersLocked() {
+    auto const now = std::chrono::steady_clock::now();
+    while (!waiters_.empty()) {
+        std::shared_ptr<AsyncWaiter> waiter = waiters_.front();
+        if (!idle_.empty()) {
+            waiters_.pop_front();
+            PooledConnection pooled = std::move(idle_.back());
+            idle_.pop_back();
+            // IsAlive does not ping recently used connections, so this check is cheap enough for the lock
+            if (now - pooled.lastUsedAt < VALIDATE_AFTER_IDLE && IsAlive(pooled, now)) {
+                CompleteWaiter(waiter, {}, LeaseLocked(std::move(pooled)));
+                continue;
+            }
+            // Keep the slot reserved while the connector validates it, or replaces it when dead
+            ++opening_;
+            asio::post(Connector(), [weak = weak_from_this(), connStr = connStr_, waiter, idle = std::make_shared<PooledConnection>(std::move(pooled))]() {
+                OpenForWaiter(weak, connStr, waiter, idle);
+            });
+        } else if (TotalLocked() < options_.maxSize) {
+            waiters_.pop_front();
+            ++opening_;
+            asio::post(Connector(), [weak = weak_from_this(), connStr = connStr_, waiter]() { OpenForWaiter(weak, connStr, waiter); });
+        } else {
+            break;
+        }
+    }
+}
+
+void ConnectionPool::OpenForWaiter(std::weak_ptr<ConnectionPool> const &pool, std::string const &connStr, std::shared_ptr<AsyncWaiter> const &waiter,
+                                   std::shared_ptr<PooledConnection> const &idle) {
+    PooledConnection pooled;
+    if (idle) {
+        if (std::shared_ptr<ConnectionPool> self = pool.lock(); self && self->IsAlive(*idle, std::chrono::steady_clock::now())) {
+            pooled = std::move(*idle);
+        } else if (self) {
+            Logger::Wrn() << "ConnectionPool::AsyncGetConnection: replacing dead or expired idle connection";
+        }
+        idle->conn.reset();
+    }
+    // no reference to the pool is held while connecting, so it may be destroyed meanwhile
+    if (!pooled.conn && !pool.expired()) { pooled = NewPooled(Connect(connStr, waiter->deadline)); }
+    std::shared_ptr<ConnectionPool> self = pool.lock();
+    if (!self) {
+        // the waiter was no longer queued when the pool went away, so nobody else completes it
+        if (!waiter->done) {
+            waiter->done = true;
+            asio::post(waiter->executor, [waiter]() { waiter->handler(asio::error::operation_aborted, nullptr); });
+        }
+        return;
+    }
+    std::unique_lock<std::mutex> lock(self->poolMutex_);
+    --self->opening_;
+    if (!pooled.conn) {
+        if (!waiter->done) { self->CompleteWaiter(waiter, asio::error::connection_refused, nullptr); }
+    } else if (waiter->done) {
+        // The waiter timed out while connecting; keep the connection for the next caller
+        self->idle_.push_back(std::move(pooled));
+    } else {
+        self->CompleteWaiter(waiter, {}, self->LeaseLocked(std::move(pooled)));
+    }
+    self->ServeWaitersLocked();
+    self->poolCondition_.notify_one();
+}
+
+void ConnectionPool::CompleteWaiter(std::shared_ptr<AsyncWaiter> const &waiter, boost::system::error_code ec, pqxx::connection *pConn) {
+    waiter->done = true;
+    waiter->timer.cancel();
+    asio::post(waiter->executor, [waiter, ec, pConn]() { waiter->handler(ec, pConn); });
+}
+
+void ConnectionPool::OnWaiterTimeout(std::shared_ptr<AsyncWaiter> const &waiter) {
+    {
+        std::unique_lock<std::mutex> lock(poolMutex_);
+        if (waiter->done) { return; }
+        waiter->done = true;
+        auto it = std::find(waiters_.begin(), waiters_.end(), waiter);
+        if (it != waiters_.end()) { waiters_.erase(it); }
+    }
+    Logger::Wrn() << "ConnectionPool::AsyncGetConnection: timed out waiting for a connection";
+    waiter->handler(asio::error::timed_out, nullptr);
+}
+
+auto ConnectionPool::GetStats() -> Stats {
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    return Stats{.idle = idle_.size(), .inUse = leased_.size(), .opening = opening_, .waiting = blockedWaiters_ + waiters_.size(), .maxSize = options_.maxSize};
+}
+
+auto ConnectionPool::TotalLocked() const -> size_t {
+    return idle_.size() + leased_.size() + opening_;
 }
 } // namespace STNL
@@ -5,6 +5,7 @@
 #include "stnl/db/blueprint.hpp"
 #include "stnl/db/connection_pool.hpp"
 #include "stnl/db/inserter.hpp"
+#include "stnl/db/pg_json.hpp"
 
 #include <boost/asio.hpp>
 #include <boost/json.hpp>
@@ -13,6 +14,11 @@
 #include <pqxx/pqxx>
 #include <pqxx/result>
 
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <chrono>
 #include <format>
 #include <functional>
 #include <future>
@@ -21,7 +27,11 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <random>
 #include <thread>
+#include <unordered_set>
 
 namespace asio = boost::asio;
 namespace json = boost::json;
@@ -29,7 +39,19 @@ namespace json = boost::json;
 namespace STNL {
 
 DB::DB(std::string const &connStr, asio::io_context &ioc, size_t poolSize, size_t numThreads)
-    : pool_(connStr, poolSize), ioc_(ioc), workGuard_(asio::make_work_guard(ioc_)) {
+    : DB(connStr, ioc, PoolOptions{.minIdle = std::min<size_t>(1, poolSize), .maxSize = poolSize}, numThreads) {}
+
+DB::DB(std::string const &connStr, asio::io_context &ioc, PoolOptions const &poolOptions, size_t numThreads)
+    : DB(connStr, {}, ioc, poolOptions, numThreads) {}
+
+DB::DB(std::string const &primaryConnStr, std::vector<std::string> const &replicaConnStrs, asio::io_context &ioc, PoolOptions const &poolOptions,
+       size_t numThreads)
+    : primaryConnStr_(primaryConnStr), ioc_(ioc), workGuard_(asio::make_work_guard(ioc_)) {
+    nodes_.reserve(1 + replicaConnStrs.size());
+    nodes_.emplace_back(std::make_unique<Node>("primary", primaryConnStr, poolOptions));
+    for (size_t i = 0; i < replicaConnStrs.size(); ++i) {
+        nodes_.emplace_back(std::make_unique<Node>(std::format("replica{}", i), replicaConnStrs[i], poolOptions));
+    }
     /* there has to be at least one mandatory thread */
     if (numThreads == 0) { numThreads = 1; }
     threadPool_.reserve(numThreads);
@@ -39,126 +61,557 @@ DB::DB(std::string const &connStr, asio::io_context &ioc, size_t poolSize, size_
 }
 
 DB::~DB() {
-    workGuard_.reset();
+    Shutdown();
     for (auto &t : threadPool_) {
         if (t.joinable()) { t.join(); }
     }
 }
 
+void DB::WarmUp() {
+    for (auto &node : nodes_) {
+        node->pool->WarmUp();
+        node->pool->StartMaintenance(ioc_.get_executor());
+    }
+}
+
+void DB::Shutdown() {
+    // The maintenance timers are outstanding work on ioc_ and would keep the threads from exiting
+    for (auto &node : nodes_) { node->pool->StopMaintenance(); }
+    if (listener_) { listener_->Stop(); }
+    workGuard_.reset();
+}
+
+void DB::ReconfigurePools(PoolOptions const &poolOptions) {
+    for (auto &node : nodes_) { node->pool->Reconfigure(poolOptions); }
+}
+
+void DB::SetStickyAfterWrite(std::chrono::milliseconds window) {
+    stickyAfterWriteMs_.store(window.count(), std::memory_order_relaxed);
+}
+
 auto DB::GetIOC() -> asio::io_context & {
     return ioc_;
 }
 
-auto DB::Exec(std::string_view qSQL, bool silent) -> QResult {
-    if (!silent) { Logger::Dbg() << "DB::Exec:qSQL:\n" << qSQL; }
-    QResult qResult{.data = pqxx::result{}, .ok = false, .msg = ""};
-    pqxx::connection *pConn = nullptr;
-    try {
-        pConn = pool_.GetConnection();
-        if (pConn != nullptr) {
-            pqxx::nontransaction tx(*pConn);
-            pqxx::result r = tx.exec(qSQL);
-            qResult.data = std::move(r);
-            qResult.ok = true;
+auto DB::PickNode(Intent intent, std::string_view qSQL, Consistency *consistency) -> Node & {
+    intent = ResolveAuto(intent, qSQL);
+    auto const now = std::chrono::steady_clock::now();
+    if (intent == Intent::Write) {
+        int64_t const stickyMs = stickyAfterWriteMs_.load(std::memory_order_relaxed);
+        if (consistency != nullptr && nodes_.size() > 1 && stickyMs > 0) {
+            consistency->primaryUntil_.store((now + std::chrono::milliseconds(stickyMs)).time_since_epoch().count(), std::memory_order_release);
+        }
+        return *nodes_[0];
+    }
+    if (intent == Intent::Primary || nodes_.size() == 1) { return *nodes_[0]; }
+    if (consistency != nullptr && consistency->PrimaryRequired(now)) { return *nodes_[0]; }
+    /* least outstanding requests; the rotating start spreads ties evenly */
+    size_t const replicaCount = nodes_.size() - 1;
+    size_t const start = nextReplica_.fetch_add(1, std::memory_order_relaxed);
+    Node *pBest = nullptr;
+    size_t bestInFlight = 0;
+    for (size_t i = 0; i < replicaCount; ++i) {
+        Node &node = *nodes_[1 + ((start + i) % replicaCount)];
+        size_t const inFlight = node.inFlight.load(std::memory_order_relaxed);
+        if (pBest == nullptr || inFlight < bestInFlight) {
+            pBest = &node;
+            bestInFlight = inFlight;
+        }
+    }
+    return *pBest;
+}
+
+auto DB::ResolveAuto(Intent intent, std::string_view qSQL) -> Intent {
+    if (intent != Intent::Auto) { return intent; }
+    /* a read only looking statement may still write through a function, which a hot standby
+     * refuses: Auto stays on the primary, replicas take explicit Intent::Read only */
+    return IsReadOnlySQL(qSQL) ? Intent::Primary : Intent::Write;
+}
+
+auto DB::IsReadOnlySQL(std::string_view qSQL) -> bool {
+    /* tokenize just enough to skip comments, literals and quoted identifiers */
+    std::vector<std::string> words;
+    bool moreStatements = false;
+    size_t i = 0;
+    while (i < qSQL.size()) {
+        char const c = qSQL[i];
+        if (std::isspace(static_cast<unsigned char>(c)) != 0 || c == '(' || c == ')' || c == ',') {
+            ++i;
+        } else if (qSQL.substr(i, 2) == "--") {
+            i = qSQL.find('\n', i);
+            if (i == std::string_view::npos) { break; }
+        } else if (qSQL.substr(i, 2) == "/*") {
+            i = qSQL.find("*/", i + 2);
+            if (i == std::string_view::npos) { break; }
+            i += 2;
+        } else if (c == '\'' || c == '"') {
+            i = qSQL.find(c, i + 1);
+            if (i == std::string_view::npos) { break; }
+            ++i;
+        } else if (c == ';') {
+            ++i;
+            if (qSQL.find_first_not_of(" \t\r\n;", i) != std::string_view::npos) { moreStatements = true; }
+            break;
+        } else if (std::isalpha(static_cast<unsigned char>(c)) != 0 || c == '_') {
+            size_t const start = i;
+            while (i < qSQL.size() && (std::isalnum(static_cast<unsigned char>(qSQL[i])) != 0 || qSQL[i] == '_')) { ++i; }
+            words.emplace_back(Utils::StringToUpper(qSQL.substr(start, i - start)));
         } else {
-            qResult.ok = false;
-            qResult.msg = "Failed to get a database connection";
+            ++i;
         }
-    } catch (const pqxx::sql_error &e) {
-        qResult.ok = false;
-        qResult.msg = Utils::Trim(std::string(e.what()));
-        Logger::Err() << "DB::Exec: ErrorWhat: \n" << e.what();
-        Logger::Err() << "DB::Exec: ErrorSQL: " << e.query();
     }
-    if (pConn != nullptr) { pool_.ReturnConnection(pConn); }
-    return qResult;
+    if (moreStatements || words.empty()) { return false; }
+    static const std::unordered_set<std::string> readStarts{"SELECT", "WITH", "SHOW", "VALUES", "TABLE"};
+    static const std::unordered_set<std::string> writeWords{"INSERT", "UPDATE", "DELETE", "MERGE", "INTO", "SHARE", "NEXTVAL", "SETVAL", "LOCK"};
+    if (!readStarts.contains(words.front())) { return false; }
+    return std::none_of(words.begin(), words.end(), [](std::string const &w) { return writeWords.contains(w); });
 }
 
-auto DB::ExecSQLCmd(std::string const &sqlCmdName, std::string const &sqlCmd, pqxx::params &params, bool silent) -> QResult {
-    if (!silent) { Logger::Dbg() << std::format("DB::ExecSQLCmd:<{}>: {}", sqlCmdName, sqlCmd); }
+auto DB::WithConnection(std::string_view caller, std::string_view statement, Node &node,
+                        const std::function<void(pqxx::connection &conn, QResult &qResult)> &fn, size_t const *rows) -> QResult {
     QResult qResult{.data = pqxx::result{}, .ok = false, .msg = ""};
-    pqxx::connection *pConn = nullptr;
+    Node *pNode = &node;
+    auto const acquireStart = std::chrono::steady_clock::now();
+    bool const replica = pNode != nodes_[0].get();
+    /* a busy replica must not hold the statement for the full acquire timeout before the primary gets a try */
+    pqxx::connection *pConn = replica ? pNode->pool->GetConnection(REPLICA_ACQUIRE_TIMEOUT) : pNode->pool->GetConnection();
+    if (pConn == nullptr && replica) {
+        Logger::Wrn() << caller << ": no connection from " << pNode->name << ", falling back to the primary";
+        pNode = nodes_[0].get();
+        pConn = pNode->pool->GetConnection();
+    }
+    auto const queryStart = std::chrono::steady_clock::now();
+    stats_.RecordAcquire(queryStart - acquireStart, pConn != nullptr);
+    if (pConn == nullptr) {
+        qResult.msg = "Failed to get a database connection";
+        Logger::Err() << caller << ": " << qResult.msg;
+        return qResult;
+    }
+    pNode->inFlight.fetch_add(1, std::memory_order_relaxed);
+    bool broken = false;
     try {
-        pConn = pool_.GetConnection();
-        if (pConn != nullptr) {
-            // pConn->prepare(sqlCmdName, sqlCmd);
-            pqxx::nontransaction tx(*pConn);
-            pqxx::result result = tx.exec(sqlCmd, params);
-            qResult.data = result;
-            qResult.ok = true;
-        } else {
-            qResult.ok = false;
-            qResult.msg = "Failed to get a database connection";
-        }
+        fn(*pConn, qResult);
+        qResult.ok = true;
+    } catch (const pqxx::broken_connection &e) {
+        broken = true;
+        qResult.msg = Utils::Trim(std::string(e.what()));
+        Logger::Err() << caller << ": Connection lost: \n" << e.what();
     } catch (const pqxx::sql_error &e) {
         qResult.msg = Utils::Trim(std::string(e.what()));
-        Logger::Err() << "DB::ExecSQLCmd: ErrorWhat: \n" << e.what();
-        Logger::Err() << "DB::ExecSQLCmd: ErrorSQL: " << e.query();
+        Logger::Err() << caller << ": ErrorWhat: \n" << e.what();
+        Logger::Err() << caller << ": ErrorSQL: " << e.query();
+    } catch (const std::exception &e) {
+        qResult.msg = Utils::Trim(std::string(e.what()));
+        Logger::Err() << caller << ": Error: \n" << e.what();
     }
-    if (pConn != nullptr) { pool_.ReturnConnection(pConn); }
+    pNode->inFlight.fetch_sub(1, std::memory_order_relaxed);
+    pNode->pool->ReturnConnection(pConn, broken);
+    stats_.RecordQuery(statement, std::chrono::steady_clock::now() - queryStart, rows != nullptr ? *rows : qResult.data.size(), qResult.ok);
     return qResult;
 }
 
+auto DB::Exec(std::string_view qSQL, bool silent) -> QResult {
+    return Exec(qSQL, Intent::Auto, silent);
+}
+
+auto DB::Exec(std::string_view qSQL, Intent intent, bool silent) -> QResult {
+    return ExecOn(qSQL, intent, nullptr, silent);
+}
+
+auto DB::Exec(std::string_view qSQL, Intent intent, Consistency &consistency, bool silent) -> QResult {
+    return ExecOn(qSQL, intent, &consistency, silent);
+}
+
+auto DB::ExecOn(std::string_view qSQL, Intent intent, Consistency *consistency, bool silent) -> QResult {
+    if (!silent) { STNL_LOG_DBG("DB::Exec:qSQL:\n{}", qSQL); }
+    intent = ResolveAuto(intent, qSQL);
+    QResult r = WithConnection("DB::Exec", "exec", PickNode(intent, qSQL, consistency), [&qSQL](pqxx::connection &conn, QResult &qResult) {
+        pqxx::nontransaction tx(conn);
+        qResult.data = tx.exec(qSQL);
+    });
+    if (intent == Intent::Write) { InvalidateCacheFor(qSQL); }
+    return r;
+}
+
+auto DB::ExecSQLCmd(std::string const &sqlCmdName, std::string const &sqlCmd, pqxx::params &params, bool silent) -> QResult {
+    return ExecSQLCmd(sqlCmdName, sqlCmd, params, Intent::Auto, silent);
+}
+
+auto DB::ExecSQLCmd(std::string const &sqlCmdName, std::string const &sqlCmd, pqxx::params &params, Intent intent, bool silent) -> QResult {
+    return ExecSQLCmdOn(sqlCmdName, sqlCmd, params, intent, nullptr, silent);
+}
+
+auto DB::ExecSQLCmd(std::string const &sqlCmdName, std::string const &sqlCmd, pqxx::params &params, Intent intent, Consistency &consistency, bool silent)
+    -> QResult {
+    return ExecSQLCmdOn(sqlCmdName, sqlCmd, params, intent, &consistency, silent);
+}
+
+auto DB::ExecSQLCmdOn(std::string const &sqlCmdName, std::string const &sqlCmd, pqxx::params &params, Intent intent, Consistency *consistency, bool silent)
+    -> QResult {
+    if (!silent) { STNL_LOG_DBG("DB::ExecSQLCmd:<{}>: {}", sqlCmdName, sqlCmd); }
+    intent = ResolveAuto(intent, sqlCmd);
+    QResult r = WithConnection("DB::ExecSQLCmd", sqlCmdName, PickNode(intent, sqlCmd, consistency), [&sqlCmd, &params](pqxx::connection &conn, QResult &qResult) {
+        // conn.prepare(sqlCmdName, sqlCmd);
+        pqxx::nontransaction tx(conn);
+        qResult.data = tx.exec(sqlCmd, params);
+    });
+    if (intent == Intent::Write) { InvalidateCacheFor(sqlCmd); }
+    return r;
+}
+
+auto DB::CacheKey(std::string const &qSQL, std::vector<std::string> const &params) -> std::string {
+    std::string key = qSQL;
+    for (std::string const &param : params) {
+        key += '\x1f';
+        key += param;
+    }
+    return key;
+}
+
+auto DB::ExecCachedImpl(CacheOptions const &options, std::string const &qSQL, pqxx::params params, std::string const &key) -> CachedQResult {
+    std::shared_ptr<QueryCache::Entry const> entry = queryCache_->GetOrLoad(key, options, qSQL, [&](QueryCache::Entry &e) {
+        QResult r = params.size() == 0 ? Exec(qSQL, Intent::Read) : ExecSQLCmd("sql_cached", qSQL, params, Intent::Read);
+        e.ok = r.ok;
+        e.msg = std::move(r.msg);
+        e.data = std::move(r.data);
+    });
+    return CachedQResult{.result = QResult{.data = entry->data, .ok = entry->ok, .msg = entry->msg}, .entry = entry};
+}
+
+auto DB::ExecCached(std::string const &qSQL, CacheOptions const &options) -> QResult {
+    return ExecCachedImpl(options, qSQL, pqxx::params{}, qSQL).result;
+}
+
+auto DB::ExecCachedJson(std::string const &qSQL, CacheOptions const &options) -> std::shared_ptr<std::string const> {
+    CachedQResult cached = ExecCachedImpl(options, qSQL, pqxx::params{}, qSQL);
+    if (!cached.result.ok) { return nullptr; }
+    return cached.entry->Json([this](pqxx::result const &data) { return json::serialize(ConvertPQXXResultToJson(data)); });
+}
+
+auto DB::QExecCached(std::string qSQL, CacheOptions options) -> std::future<QResult> {
+    auto promise = std::make_shared<std::promise<QResult>>();
+    std::future<QResult> future = promise->get_future();
+    asio::post(ioc_, [this, promise, qSQL = std::move(qSQL), options = std::move(options)]() {
+        // a miss coalesced with another caller's load does not hold this io thread, the loading thread completes it
+        auto load = [this, &qSQL](QueryCache::Entry &e) {
+            QResult r = Exec(qSQL, Intent::Read);
+            e.ok = r.ok;
+            e.msg = std::move(r.msg);
+            e.data = std::move(r.data);
+        };
+        queryCache_->AsyncGetOrLoad(qSQL, options, qSQL, load, [promise](std::shared_ptr<QueryCache::Entry const> entry) {
+            promise->set_value(QResult{.data = entry->data, .ok = entry->ok, .msg = entry->msg});
+        });
+    });
+    return future;
+}
+
+auto DB::GetQueryCache() -> QueryCache & {
+    return *queryCache_;
+}
+
+void DB::InvalidateCacheFor(std::string_view qSQL) {
+    std::vector<std::string> tables = QueryCache::TablesOf(qSQL);
+    /* DDL and statements we cannot attribute to a table drop everything */
+    if (tables.empty()) {
+        queryCache_->InvalidateAll();
+        return;
+    }
+    for (std::string const &table : tables) { queryCache_->InvalidateTable(table); }
+}
+
+auto DB::Stream(std::string const &qSQL, size_t batchSize, StreamBatchFn const &onBatch) -> QResult {
+    pqxx::params params;
+    return Stream(qSQL, params, batchSize, onBatch);
+}
+
+auto DB::Stream(std::string const &qSQL, pqxx::params &params, size_t batchSize, StreamBatchFn const &onBatch) -> QResult {
+    static std::atomic<uint64_t> cursorCounter{0};
+    if (batchSize == 0) { batchSize = 1; }
+    std::string const cursorName = std::format("stnl_stream_{}", cursorCounter.fetch_add(1, std::memory_order_relaxed));
+    /* DECLARE wraps a single query, so the statement terminator a caller may have written has to go */
+    std::string_view query = qSQL;
+    while (!query.empty() && (query.back() == ';' || std::isspace(static_cast<unsigned char>(query.back())) != 0)) { query.remove_suffix(1); }
+    // rows handed to onBatch, the batches themselves never reach qResult.data
+    size_t delivered = 0;
+    return WithConnection(
+        "DB::Stream", "stream", PickNode(Intent::Read, qSQL),
+        [&](pqxx::connection &conn, QResult & /*qResult*/) {
+            pqxx::read_transaction tx(conn);
+            std::string const cursor = tx.quote_name(cursorName);
+            tx.exec(std::format("DECLARE {} NO SCROLL CURSOR FOR {}", cursor, query), params);
+            std::string const fetchSQL = std::format("FETCH FORWARD {} FROM {}", batchSize, cursor);
+            while (true) {
+                pqxx::result batch = tx.exec(fetchSQL);
+                if (batch.empty()) { break; }
+                delivered += batch.size();
+                if (!onBatch(batch) || batch.size() < batchSize) { break; }
+            }
+            tx.exec(std::format("CLOSE {}", cursor));
+            tx.commit();
+        },
+        &delivered);
+}
+
+auto DB::QStream(std::string qSQL, size_t batchSize, StreamBatchFn onBatch) -> std::future<QResult> {
+    return Utils::AsFuture<QResult>(ioc_, [this, qSQL = std::move(qSQL), batchSize, onBatch = std::move(onBatch)]() {
+        return this->Stream(qSQL, batchSize, onBatch);
+    });
+}
+
+auto DB::Listen(std::string const &channel, NotificationHandler handler) -> size_t {
+    std::call_once(listenerOnce_, [this]() { listener_ = std::make_shared<NotificationListener>(primaryConnStr_, ioc_); });
+    return listener_->Subscribe(channel, std::move(handler));
+}
+
+void DB::Unlisten(size_t subscriptionId) {
+    if (listener_) { listener_->Unsubscribe(subscriptionId); }
+}
+
+auto DB::Notify(std::string const &channel, std::string const &payload) -> QResult {
+    pqxx::params params{channel, payload};
+    return ExecSQLCmd("sql_cmd_notify", "SELECT pg_notify($1, $2)", params, Intent::Primary);
+}
+
+auto DB::InvalidateCacheOnNotify(std::string const &channel) -> size_t {
+    // handlers already posted by the listener may still run after this DB is gone
+    return Listen(channel, [weakCache = std::weak_ptr<QueryCache>(queryCache_)](DBNotification const &notification) {
+        std::shared_ptr<QueryCache> cache = weakCache.lock();
+        if (!cache) { return; }
+        if (notification.payload.empty() || notification.payload == "*") {
+            cache->InvalidateAll();
+        } else {
+            cache->InvalidateTable(notification.payload);
+        }
+    });
+}
+
 auto DB::QExec(std::string_view qSQL, bool silent) -> std::future<QResult> {
-    return Utils::AsFuture<QResult>(ioc_, [this, qSQL, silent = silent]() { return this->Exec(qSQL, silent); });
+    return QExec(qSQL, Intent::Auto, silent);
+}
+
+auto DB::QExec(std::string_view qSQL, Intent intent, bool silent) -> std::future<QResult> {
+    return Utils::AsFuture<QResult>(ioc_, [this, qSQL, intent, silent = silent]() { return this->Exec(qSQL, intent, silent); });
+}
+
+auto DB::QExec(std::string_view qSQL, Intent intent, Consistency &consistency, bool silent) -> std::future<QResult> {
+    return Utils::AsFuture<QResult>(ioc_, [this, qSQL, intent, &consistency, silent = silent]() { return this->Exec(qSQL, intent, consistency, silent); });
 }
 
 auto DB::InsertBatch(std::string const &tableName, const std::function<void(BatchInserter &batch)> &populateBatchFn) -> QResult {
     BatchInserter batch{tableName};
     populateBatchFn(batch);
-    // debug:start
-    // if (!silent) { Logger::Dbg() << "DB::Exec:qSQL: \n" << qSQL; }
-    QResult qResult{.data = pqxx::result{}, .ok = true, .msg = ""};
-    pqxx::connection *pConn = nullptr;
-    try {
-        pConn = pool_.GetConnection();
-        if (pConn != nullptr) {
-            pqxx::work tx(*pConn);
-            for (auto &[SQLCmd, params] : batch.GetSQLCmdLst()) { tx.exec(SQLCmd, params); }
-            tx.commit();
-            qResult.ok = true;
-        } else {
-            qResult.ok = false;
-            qResult.msg = "Failed to get a database connection";
-        }
-    } catch (const pqxx::sql_error &e) {
-        qResult.ok = false;
-        qResult.msg = Utils::Trim(std::string(e.what()));
-        Logger::Err() << "DB::InsertBatch: (ROOLBACK) - ErrorWhat: \n" << e.what();
-        Logger::Err() << "DB::InsertBatch: ErrorSQL: " << e.query();
-    }
-    if (pConn != nullptr) { pool_.ReturnConnection(pConn); }
-    return qResult;
+    QResult r = WithConnection("DB::InsertBatch", std::format("sql_batch_insert_{}", tableName), PickNode(Intent::Write, ""), [&batch](pqxx::connection &conn, QResult & /*qResult*/) {
+        pqxx::work tx(conn);
+        for (auto &[SQLCmd, params] : batch.GetSQLCmdLst()) { tx.exec(SQLCmd, params); }
+        tx.commit();
+    });
+    queryCache_->InvalidateTable(tableName);
+    return r;
 }
 
 auto DB::QInsertBatch(std::string const &tableName, std::function<void(BatchInserter &batch)> populateBatchFn) -> std::future<QResult> {
-    return Utils::AsFuture<QResult>(ioc_, [this, tableName = &tableName, populateBatchFn = std::move(populateBatchFn)]() {
-        return this->InsertBatch(*tableName, populateBatchFn);
+    return Utils::AsFuture<QResult>(ioc_, [this, tableName = tableName, populateBatchFn = std::move(populateBatchFn)]() {
+        return this->InsertBatch(tableName, populateBatchFn);
     });
 }
 
 void DB::Work(const std::function<void(pqxx::work &tx)> &doWorkFn) {
-    pqxx::connection *pConn = nullptr;
-    try {
-        pConn = pool_.GetConnection();
-        if (pConn != nullptr) {
-            pqxx::work tx(*pConn);
-            doWorkFn(tx);
-        } else {
-            Logger::Err() << "BD::Work: failed to get connection. nullptr returned";
-        }
-    } catch (std::exception const &e) { Logger::Err() << "DB::Work: Error: \n" << e.what(); }
-    if (pConn != nullptr) { pool_.ReturnConnection(pConn); }
+    WithConnection("DB::Work", "work", PickNode(Intent::Write, ""), [&doWorkFn](pqxx::connection &conn, QResult & /*qResult*/) {
+        pqxx::work tx(conn);
+        doWorkFn(tx);
+    });
+    /* the tables a transaction touched are unknown here */
+    queryCache_->InvalidateAll();
 }
 
 auto DB::QWork(std::function<void(pqxx::work &tx)> doWorkFn) -> std::future<void> {
     return Utils::AsFuture<void>(ioc_, [this, doWorkFn = std::move(doWorkFn)]() { this->Work(doWorkFn); });
 }
 
+namespace {
+auto SetTransactionSQL(TxOptions const &options) -> std::string {
+    std::string sql = "SET TRANSACTION ISOLATION LEVEL ";
+    switch (options.isolation) {
+    case IsolationLevel::ReadCommitted: sql += "READ COMMITTED"; break;
+    case IsolationLevel::RepeatableRead: sql += "REPEATABLE READ"; break;
+    case IsolationLevel::Serializable: sql += "SERIALIZABLE"; break;
+    }
+    sql += options.readOnly ? " READ ONLY" : " READ WRITE";
+    if (options.deferrable) { sql += " DEFERRABLE"; }
+    return sql;
+}
+
+constexpr std::string_view LOCK_NOT_AVAILABLE = "55P03";
+
+auto IsRetryableLockTimeout(TxOptions const &options, pqxx::sql_error const &e) -> bool {
+    return options.lockTimeout.count() > 0 && e.sqlstate() == LOCK_NOT_AVAILABLE;
+}
+
+// The wait before re-running a transaction that lost a serialization conflict, deadlock or
+// lock timeout; the whole transaction is safe to re-run in all cases.
+auto BackOffDelay(std::string_view caller, TxOptions const &options, size_t attempt, std::string_view reason) -> std::chrono::milliseconds {
+    thread_local std::mt19937 rng{std::random_device{}()};
+    auto const base = options.retryBackoff * (int64_t{1} << std::min<size_t>(attempt, 10));
+    /* jitter keeps retrying contenders from colliding again in lockstep */
+    std::uniform_int_distribution<int64_t> jitter(0, std::max<int64_t>(1, base.count()));
+    auto const delay = std::chrono::milliseconds(base.count() / 2 + jitter(rng) / 2);
+    Logger::Wrn() << std::format("{}: {} (attempt {}), retrying in {}ms", caller, Utils::Trim(reason), attempt + 1, delay.count());
+    return delay;
+}
+
+// Blocking callers (Work, ExecAutocommit) sleep through the back-off on their own thread.
+void BackOff(std::string_view caller, TxOptions const &options, size_t attempt, std::string_view reason) {
+    std::this_thread::sleep_for(BackOffDelay(caller, options, attempt, reason));
+}
+
+auto RunPipeline(pqxx::work &tx, std::vector<std::string> const &statements) -> std::vector<pqxx::result> {
+    std::vector<pqxx::result> results;
+    results.reserve(statements.size());
+    pqxx::pipeline pipe(tx);
+    /* by default the pipeline sends the first statement on its own as soon as it is
+     * inserted; holding everything back until the batch is complete sends it in one go */
+    pipe.retain(static_cast<int>(std::max<size_t>(statements.size(), 1)));
+    std::vector<long> ids;
+    ids.reserve(statements.size());
+    for (std::string const &statement : statements) { ids.push_back(pipe.insert(statement)); }
+    pipe.resume();
+    for (long id : ids) { results.push_back(pipe.retrieve(id)); }
+    pipe.complete();
+    return results;
+}
+} // namespace
+
+auto DB::AttemptTransaction(std::string_view caller, TxOptions const &options, std::function<void(pqxx::work &tx)> const &body, size_t attempt,
+                            TxResult<void> &txResult) -> std::optional<std::chrono::milliseconds> {
+    bool const needsSet = options.isolation != IsolationLevel::ReadCommitted || options.readOnly || options.deferrable;
+    std::optional<std::chrono::milliseconds> retryAfter;
+    txResult.attempts = attempt + 1;
+    Node &node = PickNode(options.readOnly ? Intent::Primary : Intent::Write, "");
+    QResult r = WithConnection(caller, "work", node, [&](pqxx::connection &conn, QResult & /*qResult*/) {
+        try {
+            pqxx::work tx(conn);
+            if (needsSet) { tx.exec(SetTransactionSQL(options)); }
+            if (options.lockTimeout.count() > 0) { tx.exec(std::format("SET LOCAL lock_timeout = {}", options.lockTimeout.count())); }
+            body(tx);
+            tx.commit();
+        } catch (pqxx::serialization_failure const &e) {
+            if (attempt >= options.maxRetries) { throw; }
+            retryAfter = BackOffDelay(caller, options, attempt, e.what());
+        } catch (pqxx::deadlock_detected const &e) {
+            if (attempt >= options.maxRetries) { throw; }
+            retryAfter = BackOffDelay(caller, options, attempt, e.what());
+        } catch (pqxx::sql_error const &e) {
+            if (!IsRetryableLockTimeout(options, e) || attempt >= options.maxRetries) { throw; }
+            retryAfter = BackOffDelay(caller, options, attempt, e.what());
+        }
+    });
+    txResult.ok = r.ok && !retryAfter;
+    txResult.msg = std::move(r.msg);
+    return retryAfter;
+}
+
+auto DB::RunTransaction(std::string_view caller, TxOptions const &options, std::function<void(pqxx::work &tx)> const &body) -> TxResult<void> {
+    TxResult<void> txResult;
+    for (size_t attempt = 0;; ++attempt) {
+        std::optional<std::chrono::milliseconds> const retryAfter = AttemptTransaction(caller, options, body, attempt, txResult);
+        if (!retryAfter) { break; }
+        std::this_thread::sleep_for(*retryAfter);
+    }
+    if (!options.readOnly) { queryCache_->InvalidateAll(); }
+    return txResult;
+}
+
+void DB::RunTransactionAsync(std::string caller, TxOptions options, std::function<void(pqxx::work &tx)> body, std::function<void(TxResult<void>)> done,
+                             size_t attempt) {
+    asio::post(ioc_, [this, caller = std::move(caller), options, body = std::move(body), done = std::move(done), attempt]() mutable {
+        TxResult<void> txResult;
+        std::optional<std::chrono::milliseconds> const retryAfter = AttemptTransaction(caller, options, body, attempt, txResult);
+        if (!retryAfter) {
+            if (!options.readOnly) { queryCache_->InvalidateAll(); }
+            done(std::move(txResult));
+            return;
+        }
+        auto timer = std::make_shared<asio::steady_timer>(ioc_, *retryAfter);
+        timer->async_wait([this, timer, caller = std::move(caller), options, body = std::move(body), done = std::move(done), attempt,
+                           txResult = std::move(txResult)](boost::system::error_code ec) mutable {
+            if (ec) {
+                txResult.msg = "Retry cancelled: " + ec.message();
+                done(std::move(txResult));
+                return;
+            }
+            RunTransactionAsync(std::move(caller), options, std::move(body), std::move(done), attempt + 1);
+        });
+    });
+}
+
+auto DB::ExecAutocommit(std::string_view qSQL, TxOptions const &options, std::string_view beforeRetrySQL) -> QResult {
+    QResult r = WithConnection("DB::ExecAutocommit", "autocommit", PickNode(Intent::Write, qSQL), [&](pqxx::connection &conn, QResult &qResult) {
+        pqxx::nontransaction tx(conn);
+        bool const setLockTimeout = options.lockTimeout.count() > 0;
+        if (setLockTimeout) { tx.exec(std::format("SET lock_timeout = {}", options.lockTimeout.count())); }
+        /* the setting is session wide, restore it before the connection goes back to the pool,
+         * however the statement, the retry hook or the back-off failed */
+        try {
+            for (size_t attempt = 0;; ++attempt) {
+                try {
+                    qResult.data = tx.exec(qSQL);
+                    break;
+                } catch (pqxx::sql_error const &e) {
+                    if (!IsRetryableLockTimeout(options, e) || attempt >= options.maxRetries) { throw; }
+                    BackOff("DB::ExecAutocommit", options, attempt, e.what());
+                    if (!beforeRetrySQL.empty()) { tx.exec(beforeRetrySQL); }
+                }
+            }
+        } catch (...) {
+            if (setLockTimeout) {
+                try {
+                    tx.exec("RESET lock_timeout");
+                } catch (std::exception const &e) { Logger::Err() << "DB::ExecAutocommit: could not reset lock_timeout: " << e.what(); }
+            }
+            throw;
+        }
+        if (setLockTimeout) { tx.exec("RESET lock_timeout"); }
+    });
+    InvalidateCacheFor(qSQL);
+    return r;
+}
+
+auto DB::Pipeline(std::function<void(PipelineBatch &batch)> const &buildFn, TxOptions const &options) -> TxResult<std::vector<pqxx::result>> {
+    PipelineBatch batch;
+    buildFn(batch);
+    return Work<std::vector<pqxx::result>>([&statements = batch.statements_](pqxx::work &tx) { return RunPipeline(tx, statements); }, options);
+}
+
+auto DB::QPipeline(std::function<void(PipelineBatch &batch)> const &buildFn, TxOptions options) -> std::future<TxResult<std::vector<pqxx::result>>> {
+    auto batch = std::make_shared<PipelineBatch>();
+    buildFn(*batch);
+    return QWork<std::vector<pqxx::result>>([batch](pqxx::work &tx) { return RunPipeline(tx, batch->statements_); }, options);
+}
+
 auto DB::GetMigration() -> Migration & {
     return migration_;
 }
 
+auto DB::GetPool() -> ConnectionPool & {
+    return *nodes_[0]->pool;
+}
+
+auto DB::GetPoolStats() -> std::vector<std::pair<std::string, ConnectionPool::Stats>> {
+    std::vector<std::pair<std::string, ConnectionPool::Stats>> poolStats;
+    poolStats.reserve(nodes_.size());
+    for (auto &node : nodes_) { poolStats.emplace_back(node->name, node->pool->GetStats()); }
+    return poolStats;
+}
+
+auto DB::GetReplicaCount() const -> size_t {
+    return nodes_.size() - 1;
+}
+
+auto DB::GetStats() -> DBStats & {
+    return stats_;
+}
+
 auto DB::TableExists(std::string_view const tableName) -> bool {
     std::string qSQL = Utils::FixIndent(R"(
         SELECT 1
@@ -167,14 +620,14 @@ auto DB::TableExists(std::string_view const tableName) -> bool {
                                         pqxx::to_string(tableName) + R"(')
         AND table_schema = CURRENT_SCHEMA;
     )");
-    QResult r = this->Exec(qSQL);
+    QResult r = this->Exec(qSQL, Intent::Primary);
     if (!r.ok) { throw std::runtime_error("Failed to query table schema for " + std::string(tableName) + ": " + r.msg); }
     return (!r.data.empty());
 }
 
 auto DB::GetTableIndexNames(std::string_view tableName) -> std::vector<std::string> {
     std::string qSQL = std::format("SELECT indexname FROM pg_indexes WHERE LOWER(tablename) = LOWER('{}')", tableName);
-    QResult r = this->Exec(qSQL);
+    QResult r = this->Exec(qSQL, Intent::Primary);
     std::vector<std::string> indexNameLst;
     if (r.ok) {
         indexNameLst.reserve(r.data.size());
@@ -183,9 +636,60 @@ auto DB::GetTableIndexNames(std::string_view tableName) -> std::vector<std::stri
     return indexNameLst;
 }
 
+// Element type of an array column, from its udt_name without the leading underscore.
+static auto SQLDataTypeFromUdtName(std::string_view udt) -> SQLDataType {
+    static std::unordered_map<std::string_view, SQLDataType> const TYPES{
+        {"int8", SQLDataType::BigInt}, {"int4", SQLDataType::Integer}, {"int2", SQLDataType::SmallInt}, {"numeric", SQLDataType::Numeric},
+        {"bit", SQLDataType::Bit}, {"bpchar", SQLDataType::Char}, {"varchar", SQLDataType::Varchar}, {"bool", SQLDataType::Boolean},
+        {"date", SQLDataType::Date}, {"timestamptz", SQLDataType::Timestamp}, {"timestamp", SQLDataType::Timestamp}, {"uuid", SQLDataType::UUID},
+        {"text", SQLDataType::Text}, {"float4", SQLDataType::Real}, {"float8", SQLDataType::DoublePrecision}, {"json", SQLDataType::Json},
+        {"jsonb", SQLDataType::Jsonb}, {"bytea", SQLDataType::Bytea}};
+    auto it = TYPES.find(udt);
+    return it == TYPES.end() ? SQLDataType::Undefined : it->second;
+}
+
+// information_schema has no length or precision for array elements; format_type renders them,
+// e.g. "character varying(50)[]", "numeric(10,2)[]" or "timestamp(3) with time zone[]".
+static void SetArrayElementParams(Column &col, std::string const &formattedType) {
+    std::vector<std::size_t> params;
+    if (size_t open = formattedType.find('('); open != std::string::npos) {
+        char const *p = formattedType.data() + open + 1;
+        char const *end = formattedType.data() + formattedType.size();
+        for (;;) {
+            std::size_t value = 0;
+            auto [next, ec] = std::from_chars(p, end, value);
+            if (ec != std::errc{}) { break; }
+            params.push_back(value);
+            if (next == end || *next != ',') { break; }
+            p = next + 1;
+        }
+    }
+    switch (col.type) {
+    case SQLDataType::Numeric:
+        col.precision = static_cast<unsigned short>(params.empty() ? 0 : params[0]);
+        col.scale = static_cast<unsigned short>(params.size() < 2 ? 0 : params[1]);
+        break;
+    case SQLDataType::Bit:
+    case SQLDataType::Char: col.length = params.empty() ? 1 : params[0]; break;
+    case SQLDataType::Varchar: col.length = params.empty() ? 0 : params[0]; break;
+    case SQLDataType::Timestamp: col.precision = static_cast<unsigned short>(params.empty() ? 6 : params[0]); break;
+    default: break;
+    }
+}
+
 // Helper to map information_schema type strings to Column properties.
 static void SetColumnTypeFromData(Column &col, const std::string &dt, const pqxx::row &row) {
-    if (dt == "bigint") {
+    if (dt == "ARRAY") {
+        // udt_name of an array type is its element's prefixed with an underscore, e.g. _int4
+        std::string const udt = row["udt_name"].as<std::string>("");
+        col.array = true;
+        col.type = SQLDataTypeFromUdtName(std::string_view{udt}.substr(std::min<size_t>(1, udt.size())));
+        if (col.type == SQLDataType::Undefined) {
+            STNL::Logger::Wrn() << "DB::GetTableColumns: Unsupported array type: " << udt << " for column " << col.name;
+            return;
+        }
+        SetArrayElementParams(col, row["formatted_type"].as<std::string>(""));
+    } else if (dt == "bigint") {
         col.type = SQLDataType::BigInt;
     } else if (dt == "integer") {
         col.type = SQLDataType::Integer;
@@ -211,12 +715,22 @@ static void SetColumnTypeFromData(Column &col, const std::string &dt, const pqxx
         col.type = SQLDataType::Date;
     } else if (dt.find("timestamp") != std::string::npos) {
         col.type = SQLDataType::Timestamp;
-        constexpr std::size_t DEFAULT_TIMESTAMP_PRECISION = 6;
-        col.length = row["numeric_precision"].as<std::size_t>(DEFAULT_TIMESTAMP_PRECISION);
+        constexpr unsigned short DEFAULT_TIMESTAMP_PRECISION = 6;
+        col.precision = row["datetime_precision"].as<unsigned short>(DEFAULT_TIMESTAMP_PRECISION);
     } else if (dt == "uuid") {
         col.type = SQLDataType::UUID;
     } else if (dt == "text") {
         col.type = SQLDataType::Text;
+    } else if (dt == "real") {
+        col.type = SQLDataType::Real;
+    } else if (dt == "double precision") {
+        col.type = SQLDataType::DoublePrecision;
+    } else if (dt == "json") {
+        col.type = SQLDataType::Json;
+    } else if (dt == "jsonb") {
+        col.type = SQLDataType::Jsonb;
+    } else if (dt == "bytea") {
+        col.type = SQLDataType::Bytea;
     } else {
         STNL::Logger::Wrn() << "DB::GetTableColumns: Unsupported data type: " << dt << " for column " << col.name;
         col.type = SQLDataType::Undefined;
@@ -224,29 +738,41 @@ static void SetColumnTypeFromData(Column &col, const std::string &dt, const pqxx
 }
 
 auto DB::GetTableColumns(std::string_view tableName) -> std::vector<Column> {
-    std::vector<std::string> indexNameLst = this->GetTableIndexNames(tableName);
-
-    constexpr std::size_t SELECT_RESERVE = 10;
+    constexpr std::size_t SELECT_RESERVE = 15;
     std::vector<std::string> select;
     select.reserve(SELECT_RESERVE);
-    select.emplace_back("table_name");
-    select.emplace_back("column_name");
-    select.emplace_back("data_type");
-    select.emplace_back("character_maximum_length");
-    select.emplace_back("numeric_precision");
-    select.emplace_back("numeric_scale");
-    select.emplace_back("is_nullable");
-    select.emplace_back("column_default");
-    select.emplace_back("identity_generation");
+    select.emplace_back("c.table_name");
+    select.emplace_back("c.column_name");
+    select.emplace_back("c.data_type");
+    select.emplace_back("c.character_maximum_length");
+    select.emplace_back("c.numeric_precision");
+    select.emplace_back("c.numeric_scale");
+    select.emplace_back("c.datetime_precision");
+    select.emplace_back("c.udt_name");
+    select.emplace_back("CASE WHEN c.data_type = 'ARRAY' THEN (SELECT format_type(a.atttypid, a.atttypmod) FROM pg_attribute a "
+                        "WHERE a.attrelid = (quote_ident(c.table_schema) || '.' || quote_ident(c.table_name))::regclass "
+                        "AND a.attnum = c.ordinal_position) END AS formatted_type");
+    select.emplace_back("c.is_nullable");
+    select.emplace_back("c.column_default");
+    select.emplace_back("c.identity_generation");
+    /* plain single column btree indexes, read from pg_index in the same round trip
+     * (information_schema's ordinal_position is the column's attnum) */
+    constexpr std::string_view SINGLE_COLUMN_INDEX = "EXISTS (SELECT 1 FROM pg_index ix JOIN pg_class ic ON ic.oid = ix.indexrelid "
+                                                     "JOIN pg_am am ON am.oid = ic.relam "
+                                                     "WHERE ix.indrelid = (quote_ident(c.table_schema) || '.' || quote_ident(c.table_name))::regclass "
+                                                     "AND ix.indnatts = 1 AND ix.indkey[0] = c.ordinal_position AND ix.indpred IS NULL "
+                                                     "AND am.amname = 'btree' AND NOT ix.indisprimary AND {}ix.indisunique)";
+    select.emplace_back(std::format("{} AS has_index", std::format(SINGLE_COLUMN_INDEX, "NOT ")));
+    select.emplace_back(std::format("{} AS has_unique", std::format(SINGLE_COLUMN_INDEX, "")));
 
     std::vector<std::string> where;
     where.reserve(4);
-    where.emplace_back("table_schema = CURRENT_SCHEMA()");
-    if (!tableName.empty()) { where.emplace_back(std::format("LOWER(table_name) = LOWER('{}')", tableName)); }
-    std::string qSQL = std::format("SELECT {} FROM information_schema.columns WHERE {} ORDER "
-                                   "BY table_name, ordinal_position",
+    where.emplace_back("c.table_schema = CURRENT_SCHEMA()");
+    if (!tableName.empty()) { where.emplace_back(std::format("LOWER(c.table_name) = LOWER('{}')", tableName)); }
+    std::string qSQL = std::format("SELECT {} FROM information_schema.columns c WHERE {} ORDER "
+                                   "BY c.table_name, c.ordinal_position",
                                    Utils::Join(select, ","), Utils::Join(where, " AND "));
-    QResult r = this->Exec(qSQL);
+    QResult r = this->Exec(qSQL, Intent::Primary);
     std::vector<Column> columns;
     columns.reserve(r.data.size());
 
@@ -263,16 +789,8 @@ auto DB::GetTableColumns(std::string_view tableName) -> std::vector<Column> {
         auto isNullable = row["is_nullable"].as<std::string>();
 
         Column col(table, colName, SQLDataType::Undefined);
-        auto standardIndexName = std::format("{}_{}_idx", table, colName);
-        auto uniqueIndexName = std::format("{}_{}_key", table, colName);
-        for (const std::string &indexName : indexNameLst) {
-            if (Utils::StringCaseCmp(indexName, standardIndexName)) {
-                col.index = true;
-            } else if (Utils::StringCaseCmp(indexName, uniqueIndexName)) {
-                col.unique = true;
-            }
-            if (col.index && col.unique) { break; }
-        }
+        col.index = row["has_index"].as<bool>(false);
+        col.unique = row["has_unique"].as<bool>(false);
 
         // A. Handle Nullability
         col.nullable = (isNullable == "YES");
@@ -316,12 +834,99 @@ auto DB::QueryBlueprint(std::string_view tableName) -> Blueprint {
     std::vector<Column> cols = GetTableColumns(tableName);
     Blueprint bp{std::string(tableName)};
     for (Column &col : cols) { bp.AddColumn(std::move(col)); }
+    for (auto &[key, indexes] : GetTableIndexes(tableName)) {
+        for (IndexDef &index : indexes) { bp.AddIndex(std::move(index)); }
+    }
     return bp;
 }
 
+auto DB::QuerySchema() -> std::unordered_map<std::string, Blueprint> {
+    std::unordered_map<std::string, Blueprint> schema;
+    for (Column &col : GetTableColumns("")) {
+        std::string key = Utils::StringToLower(col.tableName);
+        auto it = schema.find(key);
+        if (it == schema.end()) { it = schema.emplace(key, Blueprint{col.tableName}).first; }
+        it->second.AddColumn(std::move(col));
+    }
+    for (auto &[key, indexes] : GetTableIndexes("")) {
+        auto it = schema.find(key);
+        if (it == schema.end()) { continue; }
+        for (IndexDef &index : indexes) { it->second.AddIndex(std::move(index)); }
+    }
+    return schema;
+}
+
+auto DB::GetTableIndexes(std::string_view tableName) -> std::unordered_map<std::string, std::vector<IndexDef>> {
+    /* indexes backing a primary key or constraint belong to the constraint, not to the blueprint;
+     * pg_get_indexdef(oid, n, true) renders key n (columns and expressions), INCLUDE columns last */
+    std::string qSQL = std::format(R"(
+        SELECT LOWER(t.relname) AS table_name, ic.relname AS index_name, am.amname AS method, ix.indisunique AS is_unique,
+               ix.indisvalid AS is_valid, ix.indnkeyatts AS key_count,
+               (SELECT string_agg(pg_get_indexdef(ix.indexrelid, k + 1, true), chr(31) ORDER BY k)
+                FROM generate_series(0, ix.indnatts - 1) AS k) AS keys,
+               COALESCE(pg_get_expr(ix.indpred, ix.indrelid, true), '') AS predicate,
+               COALESCE(obj_description(ix.indexrelid, 'pg_class'), '') AS fingerprint
+        FROM pg_index ix
+        JOIN pg_class ic ON ic.oid = ix.indexrelid
+        JOIN pg_class t ON t.oid = ix.indrelid
+        JOIN pg_namespace n ON n.oid = t.relnamespace
+        JOIN pg_am am ON am.oid = ic.relam
+        WHERE n.nspname = CURRENT_SCHEMA() AND NOT ix.indisprimary
+          AND NOT EXISTS (SELECT 1 FROM pg_constraint con WHERE con.conindid = ix.indexrelid){}
+        ORDER BY t.relname, ic.relname
+    )",
+                                   tableName.empty() ? "" : std::format(" AND LOWER(t.relname) = LOWER('{}')", tableName));
+    QResult r = this->Exec(Utils::FixIndent(qSQL), Intent::Primary);
+    if (!r.ok) {
+        STNL::Logger::Err() << ("DB::GetTableIndexes: Error executing query: " + r.msg);
+        throw std::runtime_error("Failed to query table indexes: " + r.msg);
+    }
+    std::unordered_map<std::string, std::vector<IndexDef>> indexes;
+    for (const auto &row : r.data) {
+        IndexDef index;
+        index.name = row["index_name"].as<std::string>();
+        index.method = IndexDef::MethodFromName(row["method"].as<std::string>());
+        index.unique = row["is_unique"].as<bool>();
+        index.valid = row["is_valid"].as<bool>();
+        index.where = row["predicate"].as<std::string>();
+        index.fingerprint = row["fingerprint"].as<std::string>();
+        auto const keyCount = row["key_count"].as<size_t>();
+        std::string keys = row["keys"].as<std::string>("");
+        for (size_t begin = 0, i = 0; begin <= keys.size(); ++i) {
+            size_t end = keys.find('\x1f', begin);
+            if (end == std::string::npos) { end = keys.size(); }
+            (i < keyCount ? index.columns : index.include).emplace_back(keys.substr(begin, end - begin));
+            begin = end + 1;
+        }
+        indexes[row["table_name"].as<std::string>()].push_back(std::move(index));
+    }
+    return indexes;
+}
+
+auto DB::GetTablePartitions(std::string_view tableName) -> std::unordered_map<std::string, std::vector<std::string>> {
+    std::string qSQL = std::format(R"(
+        SELECT LOWER(p.relname) AS table_name, LOWER(c.relname) AS partition_name
+        FROM pg_inherits i
+        JOIN pg_class c ON c.oid = i.inhrelid
+        JOIN pg_class p ON p.oid = i.inhparent
+        JOIN pg_namespace n ON n.oid = p.relnamespace
+        WHERE n.nspname = CURRENT_SCHEMA() AND p.relkind = 'p'{}
+        ORDER BY p.relname, c.relname
+    )",
+                                   tableName.empty() ? "" : std::format(" AND LOWER(p.relname) = LOWER('{}')", tableName));
+    QResult r = this->Exec(Utils::FixIndent(qSQL), Intent::Primary);
+    if (!r.ok) {
+        STNL::Logger::Err() << ("DB::GetTablePartitions: Error executing query: " + r.msg);
+        throw std::runtime_error("Failed to query table partitions: " + r.msg);
+    }
+    std::unordered_map<std::string, std::vector<std::string>> partitions;
+    for (const auto &row : r.data) { partitions[row["table_name"].as<std::string>()].push_back(row["partition_name"].as<std::string>()); }
+    return partitions;
+}
+
 auto DB::GetDataTypes() -> std::unordered_map<size_t, std::string> const & {
     if (dataTypes_.empty()) {
-        QResult r = this->Exec("SELECT oid, typname FROM pg_type");
+        QResult r = this->Exec("SELECT oid, typname FROM pg_type", Intent::Primary);
         std::unordered_map<size_t, std::string> dataTypes;
         if (r.ok) {
             dataTypes_.reserve(r.data.size());
@@ -344,25 +949,23 @@ auto DB::RowToJson(pqxx::row const &row, std::unordered_map<size_t, std::string>
         const char *fieldName = field.name();
         if (field.is_null()) {
             obj[fieldName] = nullptr;
+            continue;
+        }
+        std::string_view const text{field.c_str(), field.size()};
+        auto it = dataTypes.find(field.type());
+        if (it == dataTypes.end()) {
+            obj[fieldName] = text;
+            continue;
+        }
+        std::string_view const typname = it->second;
+        if (typname == "bit" && text.size() == 1) {
+            obj[fieldName] = (text[0] == '1');
+        } else if (typname.starts_with('_')) {
+            // array types are named after their element type with a leading underscore; skip bounds like [0:1]=
+            size_t pos = text.find('{');
+            obj[fieldName] = pos == std::string_view::npos ? boost::json::value(boost::json::string(text)) : PgArrayToJson(text, pos, typname.substr(1));
         } else {
-            auto it = dataTypes.find(field.type());
-            if (it != dataTypes.end()) {
-                std::string const &typname = it->second;
-                if (typname == "int4" || typname == "int8") {
-                    obj[fieldName] = field.as<long long>();
-                } else if (typname == "numeric" || typname == "float4" || typname == "float8" || typname == "double") {
-                    obj[fieldName] = field.as<double>();
-                } else if (typname == "boolean") {
-                    obj[fieldName] = field.as<bool>();
-                } else if (typname == "bit" && field.size() == 1) {
-                    auto fv = field.as<std::string>();
-                    obj[fieldName] = (fv.size() == 1 && fv[0] == '1');
-                } else {
-                    obj[fieldName] = field.c_str();
-                }
-            } else {
-                obj[fieldName] = field.c_str();
-            }
+            obj[fieldName] = PgTextToJson(text, typname);
         }
     }
     // Assuming the function needs to return a boost::json::value containing the
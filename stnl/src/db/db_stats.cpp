@@ -0,0 +1,134 @@
+#include "stnl/db/db_stats.hpp"
+
+#include <format>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+namespace STNL {
+
+namespace {
+auto EscapeLabel(std::string_view value) -> std::string {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') { escaped += '\\'; }
+        if (c == '\n') {
+            escaped += "\\n";
+            continue;
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+} // namespace
+
+auto DBStats::Statement(std::string_view name) -> StatementStats & {
+    {
+        std::shared_lock<std::shared_mutex> lock(statementsMutex_);
+        auto it = statements_.find(name);
+        if (it != statements_.end()) { return *it->second; }
+    }
+    std::unique_lock<std::shared_mutex> lock(statementsMutex_);
+    auto [it, inserted] = statements_.try_emplace(std::string(name), nullptr);
+    if (inserted) { it->second = std::make_unique<StatementStats>(); }
+    return *it->second;
+}
+
+void DBStats::RecordAcquire(std::chrono::nanoseconds wait, bool acquired) {
+    acquireWait_.Record(wait);
+    if (!acquired) { acquireTimeouts_.fetch_add(1, std::memory_order_relaxed); }
+}
+
+void DBStats::RecordQuery(std::string_view statement, std::chrono::nanoseconds duration, size_t rows, bool ok) {
+    StatementStats &stats = Statement(statement);
+    stats.latency.Record(duration);
+    stats.calls.fetch_add(1, std::memory_order_relaxed);
+    stats.rows.fetch_add(rows, std::memory_order_relaxed);
+    if (!ok) { stats.errors.fetch_add(1, std::memory_order_relaxed); }
+}
+
+auto DBStats::AcquireWait() const -> LatencyHistogram const & {
+    return acquireWait_;
+}
+
+auto DBStats::AcquireTimeouts() const -> uint64_t {
+    return acquireTimeouts_.load(std::memory_order_relaxed);
+}
+
+auto DBStats::Statements() const -> std::vector<StatementSnapshot> {
+    std::shared_lock<std::shared_mutex> lock(statementsMutex_);
+    std::vector<StatementSnapshot> snapshots;
+    snapshots.reserve(statements_.size());
+    for (auto const &[name, stats] : statements_) {
+        snapshots.push_back(StatementSnapshot{.name = name,
+                                              .calls = stats->calls.load(std::memory_order_relaxed),
+                                              .errors = stats->errors.load(std::memory_order_relaxed),
+                                              .rows = stats->rows.load(std::memory_order_relaxed),
+                                              .p50 = stats->latency.Percentile(0.5),
+                                              .p99 = stats->latency.Percentile(0.99),
+                                              .max = stats->latency.Percentile(1.0)});
+    }
+    return snapshots;
+}
+
+void DBStats::RenderPrometheus(std::string &out, std::vector<Entry> const &entries) {
+    auto header = [&out](std::string_view name, std::string_view type, std::string_view help) {
+        out += std::format("# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+    };
+
+    header("stnl_db_pool_connections", "gauge", "Open pool connections by node and state.");
+    for (Entry const &e : entries) {
+        for (auto const &[node, pool] : e.pools) {
+            std::string const labels = std::format("db=\"{}\",node=\"{}\"", EscapeLabel(e.dbAlias), EscapeLabel(node));
+            out += std::format("stnl_db_pool_connections{{{},state=\"idle\"}} {}\n", labels, pool.idle);
+            out += std::format("stnl_db_pool_connections{{{},state=\"in_use\"}} {}\n", labels, pool.inUse);
+            out += std::format("stnl_db_pool_connections{{{},state=\"opening\"}} {}\n", labels, pool.opening);
+        }
+    }
+    header("stnl_db_pool_max_connections", "gauge", "Configured pool size.");
+    for (Entry const &e : entries) {
+        for (auto const &[node, pool] : e.pools) {
+            out += std::format("stnl_db_pool_max_connections{{db=\"{}\",node=\"{}\"}} {}\n", EscapeLabel(e.dbAlias), EscapeLabel(node), pool.maxSize);
+        }
+    }
+    header("stnl_db_pool_waiting", "gauge", "Callers currently waiting for a pool connection.");
+    for (Entry const &e : entries) {
+        for (auto const &[node, pool] : e.pools) {
+            out += std::format("stnl_db_pool_waiting{{db=\"{}\",node=\"{}\"}} {}\n", EscapeLabel(e.dbAlias), EscapeLabel(node), pool.waiting);
+        }
+    }
+    header("stnl_db_pool_acquire_timeouts_total", "counter", "Pool acquisitions that gave up without a connection.");
+    for (Entry const &e : entries) {
+        out += std::format("stnl_db_pool_acquire_timeouts_total{{db=\"{}\"}} {}\n", EscapeLabel(e.dbAlias), e.stats->AcquireTimeouts());
+    }
+    header("stnl_db_pool_acquire_seconds", "histogram", "Time spent waiting for a pool connection.");
+    for (Entry const &e : entries) {
+        e.stats->AcquireWait().RenderPrometheus(out, "stnl_db_pool_acquire_seconds", std::format("db=\"{}\"", EscapeLabel(e.dbAlias)));
+    }
+
+    /* take every statement table lock once and render the four statement families from the copies */
+    struct StatementRow {
+        std::string labels;
+        StatementStats const *stats;
+    };
+    std::vector<StatementRow> rows;
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    locks.reserve(entries.size());
+    for (Entry const &e : entries) {
+        locks.emplace_back(e.stats->statementsMutex_);
+        for (auto const &[name, stats] : e.stats->statements_) {
+            rows.push_back(StatementRow{.labels = std::format("db=\"{}\",statement=\"{}\"", EscapeLabel(e.dbAlias), EscapeLabel(name)), .stats = stats.get()});
+        }
+    }
+    header("stnl_db_queries_total", "counter", "Executed statements.");
+    for (StatementRow const &r : rows) { out += std::format("stnl_db_queries_total{{{}}} {}\n", r.labels, r.stats->calls.load(std::memory_order_relaxed)); }
+    header("stnl_db_query_errors_total", "counter", "Statements that failed.");
+    for (StatementRow const &r : rows) { out += std::format("stnl_db_query_errors_total{{{}}} {}\n", r.labels, r.stats->errors.load(std::memory_order_relaxed)); }
+    header("stnl_db_query_rows_total", "counter", "Rows returned by statements.");
+    for (StatementRow const &r : rows) { out += std::format("stnl_db_query_rows_total{{{}}} {}\n", r.labels, r.stats->rows.load(std::memory_order_relaxed)); }
+    header("stnl_db_query_duration_seconds", "histogram", "Statement latency including the round trip.");
+    for (StatementRow const &r : rows) { r.stats->latency.RenderPrometheus(out, "stnl_db_query_duration_seconds", r.labels); }
+}
+
+} // namespace STNL
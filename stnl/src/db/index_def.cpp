@@ -0,0 +1,146 @@
+#include "stnl/db/index_def.hpp"
+#include "stnl/core/utils.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace STNL {
+namespace {
+constexpr std::size_t MAX_IDENTIFIER_LENGTH = 63;
+constexpr std::string_view FINGERPRINT_PREFIX = "stnl:";
+
+// Lower-cased, unquoted and without whitespace, so "LOWER(\"Email\")" and "lower(email)" compare equal.
+auto Normalize(std::string_view s) -> std::string {
+    std::string out;
+    out.reserve(s.size());
+    for (unsigned char c : s) {
+        if (c == '"' || std::isspace(c) != 0) { continue; }
+        out += static_cast<char>(std::tolower(c));
+    }
+    return out;
+}
+
+auto NormalizeAll(std::vector<std::string> const &parts) -> std::vector<std::string> {
+    std::vector<std::string> out;
+    out.reserve(parts.size());
+    for (std::string const &part : parts) { out.emplace_back(Normalize(part)); }
+    return out;
+}
+
+// Identifier-safe rendering of a column or expression: "lower(email)" -> "lower_email"
+auto Sanitize(std::string_view s) -> std::string {
+    std::string out;
+    for (unsigned char c : s) {
+        if (std::isalnum(c) != 0) {
+            out += static_cast<char>(std::tolower(c));
+        } else if (!out.empty() && out.back() != '_') {
+            out += '_';
+        }
+    }
+    while (!out.empty() && out.back() == '_') { out.pop_back(); }
+    return out;
+}
+} // namespace
+
+auto IndexDef::ResolvedName(std::string const &tableName) const -> std::string {
+    if (!name.empty()) { return name; }
+    std::string resolved = Utils::StringToLower(tableName);
+    for (std::string const &column : columns) { resolved += '_' + Sanitize(column); }
+    resolved += unique ? "_key" : "_idx";
+    if (resolved.size() > MAX_IDENTIFIER_LENGTH) {
+        /* PostgreSQL would silently truncate and could collide, keep a hash of the full name instead */
+        std::string suffix = std::format("_{:08x}", static_cast<uint32_t>(Utils::Fnv1a64(resolved)));
+        resolved = resolved.substr(0, MAX_IDENTIFIER_LENGTH - suffix.size()) + suffix;
+    }
+    return resolved;
+}
+
+void IndexDef::Validate() const {
+    if (columns.empty()) { throw std::invalid_argument("Index without columns"); }
+    if (unique && method != IndexMethod::BTree) { throw std::invalid_argument(std::format("Unique {} index is not supported", MethodName(method))); }
+    if (!include.empty() && method != IndexMethod::BTree && method != IndexMethod::Gist) {
+        throw std::invalid_argument(std::format("INCLUDE is not supported by {} indexes", MethodName(method)));
+    }
+    if (method == IndexMethod::Hash && columns.size() > 1) { throw std::invalid_argument("Hash indexes support a single column"); }
+}
+
+auto IndexDef::Fingerprint() const -> std::string {
+    std::string definition = std::format("{}|{}|{}|{}|{}", MethodName(method), unique, Utils::Join(NormalizeAll(columns), ","),
+                                         Utils::Join(NormalizeAll(include), ","), Normalize(where));
+    return std::format("{}{:016x}", FINGERPRINT_PREFIX, Utils::Fnv1a64(definition));
+}
+
+auto IndexDef::Matches(IndexDef const &current) const -> bool {
+    if (!current.valid) { return false; }
+    if (current.fingerprint.starts_with(FINGERPRINT_PREFIX)) { return current.fingerprint == Fingerprint(); }
+    // built before fingerprints or by hand: only plain definitions can be compared reliably
+    return where.empty() && current.where.empty() && method == current.method && unique == current.unique &&
+           NormalizeAll(columns) == NormalizeAll(current.columns) && NormalizeAll(include) == NormalizeAll(current.include);
+}
+
+auto IndexDef::References(std::string_view columnName) const -> bool {
+    std::string const needle = Normalize(columnName);
+    auto matches = [&needle](std::string const &part) { return Normalize(part) == needle; };
+    return std::ranges::any_of(columns, matches) || std::ranges::any_of(include, matches);
+}
+
+auto IndexDef::CreateSQL(std::string const &tableName, std::string const &indexName, bool concurrently, bool ifNotExists) const -> std::string {
+    std::string sql = std::format("CREATE {}INDEX {}{}{} ON {} USING {} ({})", unique ? "UNIQUE " : "", concurrently ? "CONCURRENTLY " : "",
+                                  ifNotExists ? "IF NOT EXISTS " : "", indexName, tableName, MethodName(method), Utils::Join(columns, ", "));
+    if (!include.empty()) { sql += std::format(" INCLUDE ({})", Utils::Join(include, ", ")); }
+    if (!where.empty()) { sql += std::format(" WHERE {}", where); }
+    return sql;
+}
+
+auto IndexDef::MethodName(IndexMethod method) -> char const * {
+    switch (method) {
+    case IndexMethod::BTree: return "btree";
+    case IndexMethod::Hash: return "hash";
+    case IndexMethod::Gin: return "gin";
+    case IndexMethod::Gist: return "gist";
+    case IndexMethod::Brin: return "brin";
+    }
+    return "btree";
+}
+
+auto IndexDef::MethodFromName(std::string_view name) -> IndexMethod {
+    if (name == "hash") { return IndexMethod::Hash; }
+    if (name == "gin") { return IndexMethod::Gin; }
+    if (name == "gist") { return IndexMethod::Gist; }
+    if (name == "brin") { return IndexMethod::Brin; }
+    return IndexMethod::BTree;
+}
+
+IndexProxy::IndexProxy(IndexDef &d) : def(d) {}
+
+auto IndexProxy::Name(std::string name) -> IndexProxy & {
+    def.name = std::move(name);
+    return *this;
+}
+
+auto IndexProxy::Unique(bool v) -> IndexProxy & {
+    def.unique = v;
+    return *this;
+}
+
+auto IndexProxy::Using(IndexMethod method) -> IndexProxy & {
+    def.method = method;
+    return *this;
+}
+
+auto IndexProxy::Include(std::vector<std::string> columns) -> IndexProxy & {
+    def.include = std::move(columns);
+    return *this;
+}
+
+auto IndexProxy::Where(std::string predicate) -> IndexProxy & {
+    def.where = std::move(predicate);
+    return *this;
+}
+
+} // namespace STNL
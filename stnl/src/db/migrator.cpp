@@ -1,22 +1,33 @@
 
 
 #include "stnl/db/migrator.hpp"
+#include "stnl/core/config.hpp"
 #include "stnl/core/logger.hpp"
 #include "stnl/core/utils.hpp"
 #include "stnl/db/blueprint.hpp"
 #include "stnl/db/column.hpp"
 #include "stnl/db/db.hpp"
+#include "stnl/db/index_def.hpp"
 #include "stnl/db/migration.hpp"
+#include "stnl/db/partition_def.hpp"
 #include "stnl/db/sr_blueprint.hpp"
 #include "stnl/db/types.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <format> // Assuming C++20 std::format is available
 #include <functional>
 #include <future>
+#include <optional>
 #include <sstream> // For std::stringstream
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <pqxx/pqxx>
@@ -29,30 +40,124 @@ static auto GetConstraintName(Column const &col, std::string const &suffix) -> s
     return std::format("{}_{}_{}", Utils::StringToLower(col.tableName), Utils::StringToLower(col.name), Utils::StringToLower(suffix));
 }
 
+auto MigrationOptions::FromConfig(std::string const &keyPath) -> MigrationOptions {
+    MigrationOptions options;
+    auto verify = Config::Value<bool>(keyPath + ".verify");
+    auto lockTimeoutMs = Config::Value<int64_t>(keyPath + ".lockTimeoutMs");
+    auto maxRetries = Config::Value<int64_t>(keyPath + ".maxRetries");
+    auto retryBackoffMs = Config::Value<int64_t>(keyPath + ".retryBackoffMs");
+    auto largeTableRows = Config::Value<int64_t>(keyPath + ".largeTableRows");
+    auto backfillBatchSize = Config::Value<int64_t>(keyPath + ".backfillBatchSize");
+    if (verify) { options.verify = *verify; }
+    if (lockTimeoutMs && *lockTimeoutMs >= 0) { options.lockTimeout = std::chrono::milliseconds(*lockTimeoutMs); }
+    if (maxRetries && *maxRetries >= 0) { options.maxRetries = static_cast<size_t>(*maxRetries); }
+    if (retryBackoffMs && *retryBackoffMs > 0) { options.retryBackoff = std::chrono::milliseconds(*retryBackoffMs); }
+    if (largeTableRows && *largeTableRows >= 0) { options.largeTableRows = *largeTableRows; }
+    if (backfillBatchSize && *backfillBatchSize > 0) { options.backfillBatchSize = static_cast<size_t>(*backfillBatchSize); }
+    return options;
+}
+
 // Forward declare helper used below to ensure ordering does not affect
 // compilation when helpers are split into multiple small functions.
 static auto SQLDataTypeAndParamsMatch(const Column &current, const Column &desired) -> bool;
 
-void Migrator::Migrate(DB &db, Migration const &migration) {
-    // Table migration
+auto Migrator::Plan(DB &db, Migration const &migration, MigrationOptions const &options) -> MigrationPlan {
+    MigrationPlan plan;
+    AppliedHashes const applied = LoadAppliedHashes(db);
+    auto isUnchanged = [&applied, &options](std::string const &kind, std::string const &name, std::string const &hash) {
+        if (options.verify) { return false; }
+        auto kindIt = applied.find(kind);
+        if (kindIt == applied.end()) { return false; }
+        auto it = kindIt->second.find(Utils::StringToLower(name));
+        return it != kindIt->second.end() && it->second == hash;
+    };
+
+    // Table migration: only blueprints whose fingerprint changed are diffed against the catalog
     std::vector<std::string> const &tableNames = migration.GetTableNames();
     std::unordered_map<std::string, Blueprint> const &blueprints = migration.GetBlueprints();
+    std::vector<std::pair<Blueprint const *, std::string>> changed;
+    std::vector<std::pair<Blueprint const *, std::string>> unchangedPartitioned; // rolling partitions may still be due
     for (std::string const &key : tableNames) {
         Blueprint const &bp = blueprints.at(key);
-        try {
-            ApplyBlueprint(db, bp);
-        } catch (std::exception const &e) { Logger::Err() << "Migrator::Migrate: Error: " + std::string(e.what()); }
+        std::string hash = Fingerprint(bp);
+        if (isUnchanged("table", bp.GetTableName(), hash)) {
+            if (bp.GetPartition().Enabled()) { unchangedPartitioned.emplace_back(&bp, std::move(hash)); }
+            continue;
+        }
+        changed.emplace_back(&bp, std::move(hash));
     }
+    plan.tablesChecked = changed.size();
+    if (!changed.empty()) {
+        // one catalog round trip, then an in-memory diff per blueprint
+        std::unordered_map<std::string, Blueprint> const schema = db.QuerySchema();
+        std::unordered_map<std::string, TableEstimate> const estimates = EstimateTables(db);
+        std::unordered_map<std::string, std::vector<std::string>> const partitions = db.GetTablePartitions();
+        std::vector<std::string> const noPartitions;
+        plan.tables.reserve(changed.size());
+        for (auto const &[pBp, hash] : changed) {
+            std::string const key = Utils::StringToLower(pBp->GetTableName());
+            auto it = schema.find(key);
+            auto estimateIt = estimates.find(key);
+            auto partitionsIt = partitions.find(key);
+            try {
+                TablePlan tablePlan = PlanBlueprint(*pBp, it == schema.end() ? nullptr : &it->second,
+                                                    estimateIt == estimates.end() ? TableEstimate{} : estimateIt->second,
+                                                    partitionsIt == partitions.end() ? noPartitions : partitionsIt->second, options);
+                tablePlan.hash = hash;
+                if (tablePlan.statements.empty()) {
+                    plan.upToDate.emplace_back(tablePlan.tableName, tablePlan.hash);
+                    continue;
+                }
+                plan.tables.push_back(std::move(tablePlan));
+            } catch (std::exception const &e) { Logger::Err() << "Migrator::Plan: Error: " + std::string(e.what()); }
+        }
+    }
+    for (TablePlan &tablePlan : PlanPartitions(db, unchangedPartitioned)) { plan.tables.push_back(std::move(tablePlan)); }
 
-    // Stored Procedure migration
+    // Stored Procedure migration, after the tables they may reference
     std::vector<std::string> const &spNames = migration.GetProcedureNames();
     std::unordered_map<std::string, SrBlueprint> const &spBlueprints = migration.GetProcedureBlueprints();
     for (std::string const &key : spNames) {
         SrBlueprint const &srBp = spBlueprints.at(key);
         try {
-            ApplyProcedureBlueprint(db, srBp);
+            std::string hash = Fingerprint(srBp);
+            if (isUnchanged("procedure", srBp.GetName(), hash)) { continue; }
+            plan.procedures.push_back(ProcedurePlan{.name = srBp.GetName(), .sql = GenerateProcedureSQL(srBp), .hash = std::move(hash)});
+        } catch (std::exception const &e) { Logger::Err() << "Migrator::Plan: Error: " + std::string(e.what()); }
+    }
+    return plan;
+}
+
+auto Migrator::Plan(DB &db) -> MigrationPlan {
+    return Plan(db, db.GetMigration(), MigrationOptions::FromConfig("database.migrations"));
+}
+
+void Migrator::Migrate(DB &db, Migration const &migration) {
+    auto const started = std::chrono::steady_clock::now();
+    MigrationOptions const options = MigrationOptions::FromConfig("database.migrations");
+    MigrationPlan plan;
+    try {
+        EnsureBookkeepingTable(db);
+        plan = Plan(db, migration, options);
+    } catch (std::exception const &e) {
+        Logger::Err() << "Migrator::Migrate: Error: " + std::string(e.what());
+        return;
+    }
+    for (auto const &[tableName, hash] : plan.upToDate) {
+        Logger::Inf() << std::format("Migrator: Table '{}' is already up to date.", tableName);
+        RecordApplied(db, "table", tableName, hash);
+    }
+    ApplyTablePlans(db, plan.tables, options);
+
+    for (ProcedurePlan const &procedurePlan : plan.procedures) {
+        try {
+            ApplyProcedurePlan(db, procedurePlan);
+            RecordApplied(db, "procedure", procedurePlan.name, procedurePlan.hash);
         } catch (std::exception const &e) { Logger::Err() << "Migrationor::Migrate: Error: " + std::string(e.what()); }
     }
+    auto const elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+    Logger::Inf() << std::format("Migrator: {} table(s) checked, {} changed; {} of {} procedure(s) replaced in {}ms", plan.tablesChecked, plan.tables.size(),
+                                 plan.procedures.size(), migration.GetProcedureNames().size(), elapsedMs);
 }
 
 void Migrator::Migrate(DB &db) {
@@ -61,7 +166,178 @@ void Migrator::Migrate(DB &db) {
     Migrator::Migrate(db, db.GetMigration());
 }
 
-// Helper builders to reduce cognitive complexity in ApplyBlueprint
+auto Migrator::PlanPartitions(DB &db, std::vector<std::pair<Blueprint const *, std::string>> const &blueprints) -> std::vector<TablePlan> {
+    std::vector<TablePlan> plans;
+    if (blueprints.empty()) { return plans; }
+    std::unordered_map<std::string, TableEstimate> const estimates = EstimateTables(db);
+    std::unordered_map<std::string, std::vector<std::string>> const partitions = db.GetTablePartitions();
+    std::vector<std::string> const noPartitions;
+    auto const today = std::chrono::floor<std::chrono::days>(std::chrono::system_clock::now());
+    for (auto const &[pBp, hash] : blueprints) {
+        std::string const key = Utils::StringToLower(pBp->GetTableName());
+        auto estimateIt = estimates.find(key);
+        // missing or not partitioned (yet): PlanBlueprint creates or reports it
+        if (estimateIt == estimates.end() || !estimateIt->second.partitioned) { continue; }
+        auto partitionsIt = partitions.find(key);
+        TablePlan tablePlan{.tableName = pBp->GetTableName(),
+                            .create = false,
+                            .estimatedRows = estimateIt->second.rows,
+                            .estimatedBytes = estimateIt->second.bytes,
+                            .statements = {},
+                            .hash = hash};
+        try {
+            CollectPartitionStatements(*pBp, partitionsIt == partitions.end() ? noPartitions : partitionsIt->second, today, true, tablePlan.statements);
+        } catch (std::exception const &e) {
+            Logger::Err() << "Migrator::PlanPartitions: Error: " + std::string(e.what());
+            continue;
+        }
+        if (!tablePlan.statements.empty()) { plans.push_back(std::move(tablePlan)); }
+    }
+    return plans;
+}
+
+void Migrator::MaintainPartitions(DB &db, Migration const &migration, MigrationOptions const &options) {
+    std::vector<std::pair<Blueprint const *, std::string>> partitioned;
+    for (std::string const &key : migration.GetTableNames()) {
+        Blueprint const &bp = migration.GetBlueprints().at(key);
+        if (bp.GetPartition().Enabled() && bp.GetPartition().interval) { partitioned.emplace_back(&bp, std::string{}); }
+    }
+    std::vector<TablePlan> plans;
+    try {
+        plans = PlanPartitions(db, partitioned);
+    } catch (std::exception const &e) {
+        Logger::Err() << "Migrator::MaintainPartitions: Error: " + std::string(e.what());
+        return;
+    }
+    for (TablePlan const &plan : plans) {
+        try {
+            ApplyTablePlan(db, plan, options);
+        } catch (std::exception const &e) { Logger::Err() << "Migrator::MaintainPartitions: Error: " + std::string(e.what()); }
+    }
+}
+
+void Migrator::MaintainPartitions(DB &db) {
+    MaintainPartitions(db, db.GetMigration(), MigrationOptions::FromConfig("database.migrations"));
+}
+
+static auto FormatBytes(int64_t bytes) -> std::string {
+    static constexpr std::array<char const *, 5> UNITS{"B", "KiB", "MiB", "GiB", "TiB"};
+    auto value = static_cast<double>(bytes);
+    size_t unit = 0;
+    while (value >= 1024.0 && unit + 1 < UNITS.size()) {
+        value /= 1024.0;
+        ++unit;
+    }
+    return unit == 0 ? std::format("{} B", bytes) : std::format("{:.1f} {}", value, UNITS[unit]);
+}
+
+auto MigrationPlan::Empty() const -> bool {
+    return tables.empty() && procedures.empty();
+}
+
+auto MigrationPlan::Render() const -> std::string {
+    std::string out = std::format("{} table(s) with changes ({} checked, {} up to date), {} procedure(s)\n", tables.size(), tablesChecked, upToDate.size(),
+                                  procedures.size());
+    for (TablePlan const &table : tables) {
+        out += std::format("\ntable {} ({}; ~{} rows, {})\n", table.tableName, table.create ? "new" : "existing", table.estimatedRows,
+                           FormatBytes(table.estimatedBytes));
+        size_t n = 0;
+        for (MigrationStatement const &statement : table.statements) {
+            char const *lock = statement.lock == LockLevel::AccessExclusive ? "ACCESS EXCLUSIVE" : "SHARE UPDATE EXCLUSIVE";
+            std::string cost = "catalog only";
+            if (statement.backfill) {
+                cost = std::format("backfill, updates ~{} rows in batches", table.estimatedRows);
+            } else if (statement.concurrent && statement.sql.starts_with("DROP")) {
+                cost = "index drop outside a transaction";
+            } else if (statement.concurrent && statement.sql.find("DETACH PARTITION") != std::string::npos) {
+                cost = "partition detach outside a transaction";
+            } else if (statement.concurrent) {
+                cost = std::format("index build outside a transaction, reads ~{}", FormatBytes(table.estimatedBytes));
+            } else if (statement.rewrite) {
+                cost = std::format("{} ~{} rows / {} under the lock", statement.lock == LockLevel::AccessExclusive ? "rewrites or scans" : "scans",
+                                   table.estimatedRows, FormatBytes(table.estimatedBytes));
+            } else if (table.create) {
+                cost = "new table";
+            }
+            out += std::format("  {}. [{}] {}\n", ++n, lock, cost);
+            std::istringstream lines(Utils::FixIndent(statement.sql));
+            for (std::string line; std::getline(lines, line);) {
+                if (!Utils::Trim(line).empty()) { out += "       " + line + '\n'; }
+            }
+        }
+    }
+    for (ProcedurePlan const &procedure : procedures) { out += std::format("\nprocedure {}: CREATE OR REPLACE\n", procedure.name); }
+    return out;
+}
+
+// Bump when the SQL generated for an unchanged blueprint changes, so every entry is re-checked once.
+static constexpr char const *FINGERPRINT_VERSION = "1";
+
+auto Migrator::Fingerprint(Blueprint const &bp) -> std::string {
+    // the generated DDL covers every property the migrator acts on (types, constraints, indexes)
+    return std::format("{:016x}", Utils::Fnv1a64(std::format("{}\n{}", FINGERPRINT_VERSION, GenerateCreateSQL(bp))));
+}
+
+auto Migrator::Fingerprint(SrBlueprint const &srBp) -> std::string {
+    return std::format("{:016x}", Utils::Fnv1a64(std::format("{}\n{}", FINGERPRINT_VERSION, GenerateProcedureSQL(srBp))));
+}
+
+void Migrator::EnsureBookkeepingTable(DB &db) {
+    std::string createSQL = std::format(R"(
+        CREATE TABLE IF NOT EXISTS {} (
+            kind VARCHAR(16) NOT NULL,
+            name VARCHAR(255) NOT NULL,
+            hash CHAR(16) NOT NULL,
+            applied_at TIMESTAMP(3) WITH TIME ZONE NOT NULL DEFAULT now(),
+            PRIMARY KEY (kind, name)
+        );
+    )",
+                                        BOOKKEEPING_TABLE);
+    QResult r = db.Exec(Utils::FixIndent(createSQL), DB::Intent::Primary);
+    if (!r.ok) { throw std::runtime_error(std::format("Migrator: Failed to create {}: {}", BOOKKEEPING_TABLE, r.msg)); }
+}
+
+auto Migrator::LoadAppliedHashes(DB &db) -> AppliedHashes {
+    // read from the primary: a lagging replica would hide what was just applied
+    QResult r = db.Exec(std::format("SELECT to_regclass('{}') IS NOT NULL", BOOKKEEPING_TABLE), DB::Intent::Primary);
+    if (!r.ok) { throw std::runtime_error(std::format("Migrator: Failed to look up {}: {}", BOOKKEEPING_TABLE, r.msg)); }
+    AppliedHashes applied;
+    if (r.data.empty() || !r.data[0][0].as<bool>()) { return applied; } // nothing applied yet (or a dry run before the first migration)
+    r = db.Exec(std::format("SELECT kind, name, hash FROM {}", BOOKKEEPING_TABLE), DB::Intent::Primary);
+    if (!r.ok) { throw std::runtime_error(std::format("Migrator: Failed to read {}: {}", BOOKKEEPING_TABLE, r.msg)); }
+    for (pqxx::row const &row : r.data) { applied[row[0].as<std::string>()][row[1].as<std::string>()] = row[2].as<std::string>(); }
+    return applied;
+}
+
+void Migrator::RecordApplied(DB &db, std::string const &kind, std::string const &name, std::string const &hash) {
+    pqxx::params params{kind, Utils::StringToLower(name), hash};
+    QResult r = db.ExecSQLCmd("sql_cmd_stnl_record_migration",
+                              std::format("INSERT INTO {} (kind, name, hash, applied_at) VALUES ($1, $2, $3, now()) "
+                                          "ON CONFLICT (kind, name) DO UPDATE SET hash = EXCLUDED.hash, applied_at = EXCLUDED.applied_at",
+                                          BOOKKEEPING_TABLE),
+                              params, DB::Intent::Write);
+    // not fatal: the entry is simply diffed again on the next start
+    if (!r.ok) { Logger::Wrn() << std::format("Migrator: Failed to record {} '{}': {}", kind, name, r.msg); }
+}
+
+auto Migrator::EstimateTables(DB &db) -> std::unordered_map<std::string, TableEstimate> {
+    // reltuples is -1 until a table was vacuumed or analyzed for the first time
+    QResult r = db.Exec(R"(
+        SELECT LOWER(c.relname), GREATEST(c.reltuples, 0)::bigint, pg_total_relation_size(c.oid), c.relkind = 'p'
+        FROM pg_class c JOIN pg_namespace n ON n.oid = c.relnamespace
+        WHERE n.nspname = current_schema() AND c.relkind IN ('r', 'p')
+    )",
+                        DB::Intent::Primary);
+    if (!r.ok) { throw std::runtime_error("Migrator: Failed to read table statistics: " + r.msg); }
+    std::unordered_map<std::string, TableEstimate> estimates;
+    for (pqxx::row const &row : r.data) {
+        estimates.emplace(row[0].as<std::string>(),
+                          TableEstimate{.rows = row[1].as<int64_t>(), .bytes = row[2].as<int64_t>(), .partitioned = row[3].as<bool>()});
+    }
+    return estimates;
+}
+
+// Helper builders to reduce cognitive complexity in PlanBlueprint
 auto Migrator::BuildAddColumnSQL(std::string const &tableName, Column const &desiredCol) -> std::string {
     return Utils::FixIndent(std::format(
         R"(
@@ -70,12 +346,14 @@ auto Migrator::BuildAddColumnSQL(std::string const &tableName, Column const &des
         tableName, desiredCol.realName, GenerateSQLType(desiredCol), GenerateSQLConstraints(desiredCol)));
 }
 
-auto Migrator::BuildAlterTypeSQL(std::string const &tableName, Column const &desiredCol) -> std::string {
+auto Migrator::BuildAlterTypeSQL(std::string const &tableName, Column const &desiredCol, bool cast) -> std::string {
+    // no implicit cast exists between e.g. text and jsonb, or an element type and its array
+    std::string const sqlType = GenerateSQLType(desiredCol);
     return Utils::FixIndent(std::format(
         R"(
-            ALTER TABLE {} ALTER COLUMN {} TYPE {};
+            ALTER TABLE {} ALTER COLUMN {} TYPE {}{};
         )",
-        tableName, desiredCol.realName, GenerateSQLType(desiredCol)));
+        tableName, desiredCol.realName, sqlType, cast ? std::format(" USING {}::{}", desiredCol.realName, sqlType) : ""));
 }
 
 auto Migrator::BuildIdentitySQL(std::string const &tableName, Column const &desiredCol) -> std::string {
@@ -103,58 +381,223 @@ auto Migrator::BuildDefaultValueSQL(std::string const &tableName, Column const &
     return std::format("ALTER TABLE {} ALTER COLUMN {} SET DEFAULT {};", tableName, desiredCol.realName, desiredDefaultValue);
 }
 
-auto Migrator::BuildUniqueIndexSQL(Column const &currentCol, Column const &desiredCol) -> std::string {
-    if (desiredCol.unique) {
-        return std::format("CREATE UNIQUE INDEX CONCURRENTLY {} ON {} ({})", GetConstraintName(desiredCol, "key"), desiredCol.tableName, desiredCol.realName);
-    }
-    return std::format("DROP INDEX CONCURRENTLY IF EXISTS {}", GetConstraintName(currentCol, "key"));
+// Builders for the statement kinds ApplyTablePlan schedules differently
+static auto Quick(std::string sql) -> MigrationStatement {
+    MigrationStatement statement;
+    statement.sql = std::move(sql);
+    return statement;
+}
+
+static auto FullScan(std::string sql, LockLevel lock) -> MigrationStatement {
+    MigrationStatement statement = Quick(std::move(sql));
+    statement.lock = lock;
+    statement.rewrite = true;
+    return statement;
+}
+
+static auto Concurrent(std::string sql, std::string beforeRetry) -> MigrationStatement {
+    MigrationStatement statement = Quick(std::move(sql));
+    statement.lock = LockLevel::ShareUpdateExclusive;
+    statement.concurrent = true;
+    statement.beforeRetry = std::move(beforeRetry);
+    return statement;
+}
+
+static auto Backfill(std::string sql) -> MigrationStatement {
+    MigrationStatement statement = Quick(std::move(sql));
+    statement.lock = LockLevel::ShareUpdateExclusive;
+    statement.backfill = true;
+    return statement;
 }
 
-auto Migrator::BuildIndexSQL(Column const &currentCol, Column const &desiredCol) -> std::string {
-    if (desiredCol.index && !desiredCol.unique) {
-        return std::format("CREATE INDEX CONCURRENTLY IF NOT EXISTS {} ON {} ({})", GetConstraintName(desiredCol, "idx"), desiredCol.tableName,
-                           desiredCol.realName);
+auto Migrator::IsRewriteFreeTypeChange(Column const &currentCol, Column const &desiredCol) -> bool {
+    // binary coercible changes only touch the catalog; for arrays the element cast is applied per row
+    if (currentCol.array || desiredCol.array) { return false; }
+    if (currentCol.type == SQLDataType::Timestamp && desiredCol.type == SQLDataType::Timestamp) { return desiredCol.precision >= currentCol.precision; }
+    if (currentCol.type == SQLDataType::Varchar && desiredCol.type == SQLDataType::Varchar) { return desiredCol.length >= currentCol.length; }
+    if (currentCol.type == SQLDataType::Varchar && desiredCol.type == SQLDataType::Text) { return true; }
+    if (currentCol.type == SQLDataType::Numeric && desiredCol.type == SQLDataType::Numeric) {
+        return desiredCol.scale == currentCol.scale && desiredCol.precision >= currentCol.precision;
     }
-    if (currentCol.index) { return std::format("DROP INDEX CONCURRENTLY IF EXISTS {}", GetConstraintName(currentCol, "idx")); }
-    return std::string{};
+    return false;
 }
 
-void Migrator::CollectAlterStatementsForColumn(std::string const &tableName, Column const &currentCol, Column const &desiredCol,
-                                               std::vector<std::string> &alterStatements) {
+auto Migrator::CollectAlterStatementsForColumn(std::string const &tableName, Column const &currentCol, Column const &desiredCol, bool largeTable,
+                                               std::vector<MigrationStatement> &alterStatements) -> bool {
     if (!SQLDataTypeAndParamsMatch(currentCol, desiredCol)) {
-        std::string typeSQL = BuildAlterTypeSQL(tableName, desiredCol);
-        alterStatements.emplace_back(typeSQL);
+        // a timestamp altered for another reason, e.g. into an array, keeps its precision unless lowering it was asked for
+        Column targetCol = desiredCol;
+        if (targetCol.type == SQLDataType::Timestamp && currentCol.type == SQLDataType::Timestamp && targetCol.precision < currentCol.precision &&
+            !targetCol.narrowPrecision) {
+            targetCol.precision = currentCol.precision;
+        }
+        bool const rewrite = !IsRewriteFreeTypeChange(currentCol, targetCol);
+        if (rewrite && largeTable && !currentCol.identity && !targetCol.identity) {
+            CollectExpandContractStatements(tableName, targetCol, alterStatements);
+            return true;
+        }
+        bool const cast = currentCol.type != targetCol.type || currentCol.array != targetCol.array;
+        std::string typeSQL = BuildAlterTypeSQL(tableName, targetCol, rewrite && cast);
+        alterStatements.push_back(rewrite ? FullScan(typeSQL, LockLevel::AccessExclusive) : Quick(typeSQL));
         Logger::Inf() << std::format("Migrator: {}", typeSQL);
     }
 
     if (currentCol.identity != desiredCol.identity) {
         std::string identitySQL = BuildIdentitySQL(tableName, desiredCol);
-        alterStatements.emplace_back(identitySQL);
+        alterStatements.push_back(Quick(identitySQL));
         Logger::Inf() << std::format("Migrator: {}", identitySQL);
     }
 
     if (currentCol.nullable != desiredCol.nullable) {
-        std::string nullSQL = BuildNullabilitySQL(tableName, desiredCol);
-        alterStatements.emplace_back(nullSQL);
-        Logger::Inf() << std::format("Migrator: {}", nullSQL);
+        if (!desiredCol.nullable && largeTable) {
+            /* SET NOT NULL scans the table under ACCESS EXCLUSIVE unless a validated CHECK
+             * already proves it; VALIDATE only takes SHARE UPDATE EXCLUSIVE */
+            std::string checkName = GetConstraintName(desiredCol, "not_null");
+            alterStatements.push_back(
+                Quick(std::format("ALTER TABLE {} ADD CONSTRAINT {} CHECK ({} IS NOT NULL) NOT VALID;", tableName, checkName, desiredCol.realName)));
+            alterStatements.push_back(FullScan(std::format("ALTER TABLE {} VALIDATE CONSTRAINT {};", tableName, checkName), LockLevel::ShareUpdateExclusive));
+            alterStatements.push_back(Quick(BuildNullabilitySQL(tableName, desiredCol)));
+            alterStatements.push_back(Quick(std::format("ALTER TABLE {} DROP CONSTRAINT {};", tableName, checkName)));
+            Logger::Inf() << std::format("Migrator: {} (validated online)", BuildNullabilitySQL(tableName, desiredCol));
+        } else {
+            std::string nullSQL = BuildNullabilitySQL(tableName, desiredCol);
+            alterStatements.push_back(desiredCol.nullable ? Quick(nullSQL) : FullScan(nullSQL, LockLevel::AccessExclusive));
+            Logger::Inf() << std::format("Migrator: {}", nullSQL);
+        }
     }
 
     std::string desiredDefaultValue = std::string(desiredCol.defaultValue);
     if (desiredCol.type == SQLDataType::UUID && desiredCol.identity && desiredCol.defaultValue.empty()) { desiredDefaultValue = std::string("uuidv7()"); }
     if (currentCol.defaultValue != desiredDefaultValue) {
         std::string defaultSQL = BuildDefaultValueSQL(tableName, desiredCol, desiredDefaultValue);
-        alterStatements.emplace_back(defaultSQL);
+        alterStatements.push_back(Quick(defaultSQL));
         Logger::Inf() << std::format("Migrator: {}", defaultSQL);
     }
 
-    if (currentCol.unique != desiredCol.unique) {
-        std::string uniqueIndexSQL = BuildUniqueIndexSQL(currentCol, desiredCol);
-        alterStatements.emplace_back(uniqueIndexSQL);
+    return false;
+}
+
+void Migrator::CollectExpandContractStatements(std::string const &tableName, Column const &desiredCol, std::vector<MigrationStatement> &alterStatements) {
+    std::string const shadow = std::format("{}__stnl_new", desiredCol.realName);
+    std::string const syncFn = GetConstraintName(desiredCol, "stnl_sync");
+    std::string const sqlType = GenerateSQLType(desiredCol);
+    Logger::Inf() << std::format("Migrator: {}.{} -> {} via expand/backfill/contract", tableName, desiredCol.realName, sqlType);
+
+    // expand: shadow column kept in sync with every write from now on
+    alterStatements.push_back(Quick(std::format("ALTER TABLE {} ADD COLUMN IF NOT EXISTS {} {};", tableName, shadow, sqlType)));
+    alterStatements.push_back(Quick(std::format(R"(
+            CREATE OR REPLACE FUNCTION {0}() RETURNS trigger LANGUAGE plpgsql AS $$
+            BEGIN
+                NEW.{1} := NEW.{2}::{3};
+                RETURN NEW;
+            END
+            $$;
+            DROP TRIGGER IF EXISTS {0} ON {4};
+            CREATE TRIGGER {0} BEFORE INSERT OR UPDATE ON {4} FOR EACH ROW EXECUTE FUNCTION {0}();
+        )",
+                                                syncFn, shadow, desiredCol.realName, sqlType, tableName)));
+
+    // backfill: rows written before the trigger existed, in short batches
+    alterStatements.push_back(
+        Backfill(std::format("UPDATE {0} SET {1} = {2}::{3} WHERE ctid = ANY(ARRAY(SELECT ctid FROM {0} WHERE {1} IS NULL AND {2} IS NOT NULL LIMIT {{}}))",
+                             tableName, shadow, desiredCol.realName, sqlType)));
+
+    // contract: swap the columns, metadata only
+    alterStatements.push_back(Quick(std::format(R"(
+            DROP TRIGGER IF EXISTS {0} ON {1};
+            DROP FUNCTION IF EXISTS {0}();
+            ALTER TABLE {1} DROP COLUMN {2};
+            ALTER TABLE {1} RENAME COLUMN {3} TO {2};
+        )",
+                                                syncFn, tableName, desiredCol.realName, shadow)));
+
+    // constraints went away with the old column, rebuild them online (indexes: CollectIndexStatements)
+    Column bare = desiredCol;
+    bare.nullable = true;
+    bare.defaultValue.clear();
+    CollectAlterStatementsForColumn(tableName, bare, desiredCol, true, alterStatements);
+}
+
+void Migrator::CollectIndexStatements(std::string const &tableName, std::vector<IndexDef> const &desired, std::deque<IndexDef> const &current,
+                                      std::vector<std::string> const &rebuiltColumns, std::vector<std::string> const *pPartitions,
+                                      std::vector<MigrationStatement> &alterStatements) {
+    auto isGone = [&rebuiltColumns](IndexDef const &index) {
+        return std::ranges::any_of(rebuiltColumns, [&index](std::string const &column) { return index.References(column); });
+    };
+    std::unordered_map<std::string, IndexDef const *> currentByName;
+    for (IndexDef const &index : current) {
+        if (!isGone(index)) { currentByName.emplace(Utils::StringToLower(index.name), &index); }
+    }
+
+    // Build new and changed indexes first, so queries are never left without one
+    std::unordered_set<std::string> desiredNames;
+    for (IndexDef const &index : desired) {
+        index.Validate();
+        std::string const name = Utils::StringToLower(index.ResolvedName(tableName));
+        std::string const comment = std::format("COMMENT ON INDEX {} IS '{}';", name, index.Fingerprint());
+        desiredNames.insert(name);
+        auto it = currentByName.find(name);
+        if (it != currentByName.end() && index.Matches(*it->second)) {
+            // built before fingerprints: record one so later runs compare the full definition
+            if (it->second->fingerprint.empty()) { alterStatements.push_back(Quick(comment)); }
+            continue;
+        }
+        if (pPartitions != nullptr) {
+            /* CONCURRENTLY is not supported on a partitioned table: create the parent index on the
+             * parent alone (invalid, catalog only), build one per partition concurrently and attach
+             * them; the parent index becomes valid with the last one. A changed definition cannot
+             * be swapped in by name, so the old index is dropped first; an invalid one with the
+             * same fingerprint is a build that did not attach every partition yet and is resumed */
+            if (it != currentByName.end() && (it->second->valid || it->second->fingerprint != index.Fingerprint())) {
+                alterStatements.push_back(Quick(std::format("DROP INDEX IF EXISTS {}", name)));
+            }
+            alterStatements.push_back(Quick(std::format("{};\n{}", index.CreateSQL("ONLY " + tableName, name, false, true), comment)));
+            for (std::string const &partition : *pPartitions) {
+                IndexDef partitionIndex = index;
+                partitionIndex.name.clear();
+                std::string const partitionIndexName = Utils::StringToLower(partitionIndex.ResolvedName(partition));
+                alterStatements.push_back(Concurrent(partitionIndex.CreateSQL(partition, partitionIndexName, true, true),
+                                                     std::format("DROP INDEX CONCURRENTLY IF EXISTS {}", partitionIndexName)));
+                alterStatements.push_back(Quick(std::format("ALTER INDEX {} ATTACH PARTITION {}", name, partitionIndexName)));
+            }
+            Logger::Inf() << std::format("Migrator: {} (per partition)", index.CreateSQL(tableName, name, false));
+            continue;
+        }
+        std::string const dropSQL = std::format("DROP INDEX CONCURRENTLY IF EXISTS {}", name);
+        if (it == currentByName.end()) {
+            alterStatements.push_back(Concurrent(index.CreateSQL(tableName, name, true), dropSQL));
+            alterStatements.push_back(Quick(comment));
+        } else if (!it->second->valid) {
+            // leftover of a failed concurrent build
+            alterStatements.push_back(Concurrent(dropSQL, ""));
+            alterStatements.push_back(Concurrent(index.CreateSQL(tableName, name, true), dropSQL));
+            alterStatements.push_back(Quick(comment));
+        } else {
+            // definition changed: build the replacement next to the old index, then swap names
+            std::string const tmpName = name.substr(0, std::min<size_t>(name.size(), 54)) + "_stnl_new";
+            alterStatements.push_back(Concurrent(index.CreateSQL(tableName, tmpName, true), std::format("DROP INDEX CONCURRENTLY IF EXISTS {}", tmpName)));
+            alterStatements.push_back(Concurrent(dropSQL, ""));
+            alterStatements.push_back(Quick(std::format("ALTER INDEX {} RENAME TO {};\n{}", tmpName, name, comment)));
+        }
+        Logger::Inf() << std::format("Migrator: {}", index.CreateSQL(tableName, name, true));
     }
 
-    if (currentCol.index != desiredCol.index || desiredCol.unique) {
-        std::string indexSQL = BuildIndexSQL(currentCol, desiredCol);
-        if (!indexSQL.empty()) { alterStatements.emplace_back(indexSQL); }
+    // Drop the indexes the migrator owns that are no longer declared; others are left alone
+    std::string const prefix = Utils::StringToLower(tableName) + '_';
+    for (auto const &[name, pIndex] : currentByName) {
+        if (desiredNames.contains(name)) { continue; }
+        bool const managed = pIndex->fingerprint.starts_with("stnl:") || (name.starts_with(prefix) && (name.ends_with("_idx") || name.ends_with("_key")));
+        if (!managed) { continue; }
+        if (pPartitions != nullptr) {
+            // dropping a partitioned index drops its partitions' indexes too, never concurrently
+            std::string dropSQL = std::format("DROP INDEX IF EXISTS {}", name);
+            alterStatements.push_back(Quick(dropSQL));
+            Logger::Inf() << std::format("Migrator: {}", dropSQL);
+            continue;
+        }
+        std::string dropSQL = std::format("DROP INDEX CONCURRENTLY IF EXISTS {}", name);
+        alterStatements.push_back(Concurrent(dropSQL, ""));
+        Logger::Inf() << std::format("Migrator: {}", dropSQL);
     }
 }
 
@@ -162,21 +605,27 @@ auto Migrator::GenerateSQLType(Column const &col) -> std::string {
     // Note: IDENTITY is handled here as it is part of the type declaration in
     // PostgreSQL
     if (col.type == SQLDataType::Undefined) { throw std::invalid_argument("Undefined parameter type"); }
+    if (col.array && col.identity) { throw std::invalid_argument("Array column " + col.realName + " cannot be an identity"); }
+    std::string const arraySuffix = col.array ? "[]" : "";
     switch (col.type) {
-    case SQLDataType::BigInt: return col.identity ? "BIGINT GENERATED ALWAYS AS IDENTITY" : "BIGINT";
-    case SQLDataType::Integer: return col.identity ? "INTEGER GENERATED ALWAYS AS IDENTITY" : "INTEGER";
-    case SQLDataType::SmallInt: return col.identity ? "SMALLINT GENERATED ALWAYS AS IDENTITY" : "SMALLINT";
-    case SQLDataType::Numeric: return std::format("NUMERIC({},{})", col.precision, col.scale);
-    case SQLDataType::Varchar: return std::format("VARCHAR({})", col.length);
-    case SQLDataType::Char: return std::format("CHAR({})", col.length);
-    case SQLDataType::Text: return "TEXT";
-    case SQLDataType::Boolean: return "BOOLEAN";
-    case SQLDataType::Date: return "DATE";
-    case SQLDataType::Timestamp:
-        // Use col.length for fractional second precision (0-6)
-        return std::format("TIMESTAMP({}) WITH TIME ZONE", col.precision);
-    case SQLDataType::UUID: return "UUID";
-    case SQLDataType::Bit: return std::format("BIT({})", col.length);
+    case SQLDataType::BigInt: return col.identity ? "BIGINT GENERATED ALWAYS AS IDENTITY" : "BIGINT" + arraySuffix;
+    case SQLDataType::Integer: return col.identity ? "INTEGER GENERATED ALWAYS AS IDENTITY" : "INTEGER" + arraySuffix;
+    case SQLDataType::SmallInt: return col.identity ? "SMALLINT GENERATED ALWAYS AS IDENTITY" : "SMALLINT" + arraySuffix;
+    case SQLDataType::Numeric: return std::format("NUMERIC({},{}){}", col.precision, col.scale, arraySuffix);
+    case SQLDataType::Varchar: return std::format("VARCHAR({}){}", col.length, arraySuffix);
+    case SQLDataType::Char: return std::format("CHAR({}){}", col.length, arraySuffix);
+    case SQLDataType::Text: return "TEXT" + arraySuffix;
+    case SQLDataType::Boolean: return "BOOLEAN" + arraySuffix;
+    case SQLDataType::Date: return "DATE" + arraySuffix;
+    // col.precision: fractional second digits (0-6)
+    case SQLDataType::Timestamp: return std::format("TIMESTAMP({}) WITH TIME ZONE{}", col.precision, arraySuffix);
+    case SQLDataType::UUID: return "UUID" + arraySuffix;
+    case SQLDataType::Bit: return std::format("BIT({}){}", col.length, arraySuffix);
+    case SQLDataType::Real: return "REAL" + arraySuffix;
+    case SQLDataType::DoublePrecision: return "DOUBLE PRECISION" + arraySuffix;
+    case SQLDataType::Json: return "JSON" + arraySuffix;
+    case SQLDataType::Jsonb: return "JSONB" + arraySuffix;
+    case SQLDataType::Bytea: return "BYTEA" + arraySuffix;
     default: throw std::invalid_argument("Unsupported column type");
     }
 }
@@ -206,8 +655,14 @@ auto Migrator::GenerateSrParamSQL(SrParam const &spParam) -> std::string {
     case SQLDataType::Timestamp: ss << std::format("TIMESTAMP({}) WITH TIME ZONE", spParam.precision); break;
     case SQLDataType::UUID: ss << "UUID"; break;
     case SQLDataType::Bit: ss << std::format("BIT({})", spParam.length); break;
+    case SQLDataType::Real: ss << "REAL"; break;
+    case SQLDataType::DoublePrecision: ss << "DOUBLE PRECISION"; break;
+    case SQLDataType::Json: ss << "JSON"; break;
+    case SQLDataType::Jsonb: ss << "JSONB"; break;
+    case SQLDataType::Bytea: ss << "BYTEA"; break;
     default: throw std::invalid_argument("Unsupported parameter type");
     }
+    if (spParam.array) { ss << "[]"; }
 
     if (!spParam.defaultValue.empty()) { ss << " DEFAULT " << spParam.defaultValue; }
     return ss.str();
@@ -220,134 +675,372 @@ auto Migrator::GenerateSQLConstraints(const Column &col) -> std::string {
     return constraints;
 }
 
+static auto PartitionOfSQL(std::string const &tableName, StaticPartition const &partition) -> std::string {
+    std::string const name = std::format("{}_{}", Utils::StringToLower(tableName), Utils::StringToLower(partition.suffix));
+    if (partition.boundSQL == "DEFAULT") { return std::format("CREATE TABLE IF NOT EXISTS {} PARTITION OF {} DEFAULT", name, tableName); }
+    return std::format("CREATE TABLE IF NOT EXISTS {} PARTITION OF {} FOR VALUES {}", name, tableName, partition.boundSQL);
+}
+
 auto Migrator::GenerateCreateSQL(Blueprint const &bp) -> std::string {
     std::stringstream ss;
     ss << std::format("CREATE TABLE {} (\n", bp.GetTableName());
     std::vector<std::string> const &columnNames = bp.GetColumnNames();
     std::unordered_map<std::string, Column> const &columns = bp.GetColumns();
 
-    // Single pass: build CREATE TABLE and collect index statements
-    std::vector<std::string> indexStatements;
-    indexStatements.reserve(columnNames.size()); // worst case: all columns have indexes
-    
     for (size_t i = 0; i < columnNames.size(); ++i) {
         std::string const &key = columnNames[i];
         Column const &col = columns.at(key);
-        
+
         ss << std::format("  {} {}{}", col.realName, GenerateSQLType(col), GenerateSQLConstraints(col));
         if (i < columnNames.size() - 1) { ss << ','; }
         ss << '\n';
-        
-        // Collect index statements during the same iteration
-        if (col.unique) {
-            indexStatements.emplace_back(std::format("CREATE UNIQUE INDEX {} ON {} ({});", 
-                                                      GetConstraintName(col, "key"), col.tableName, col.realName));
-        } else if (col.index) {
-            indexStatements.emplace_back(std::format("CREATE INDEX {} ON {} ({});", 
-                                                      GetConstraintName(col, "idx"), col.tableName, col.realName));
-        }
-    }
-    
-    ss << ");\n";
-    
-    // Append index statements
-    for (const auto &indexStmt : indexStatements) {
-        ss << indexStmt << '\n';
-    }
-    
+    }
+
+    PartitionDef const &partition = bp.GetPartition();
+    if (partition.Enabled()) {
+        ValidatePartitioning(bp);
+        ss << ") " << partition.ClauseSQL() << ";\n";
+        // rolling range partitions depend on the date, CollectPartitionStatements adds them
+        for (StaticPartition const &sp : partition.StaticPartitions()) { ss << PartitionOfSQL(bp.GetTableName(), sp) << ";\n"; }
+    } else {
+        ss << ");\n";
+    }
+
+    // A new table is empty, its indexes are built in the same transaction (on a partitioned
+    // table they cascade to every partition, present and future)
+    for (IndexDef const &index : bp.GetEffectiveIndexes()) {
+        index.Validate();
+        std::string name = Utils::StringToLower(index.ResolvedName(bp.GetTableName()));
+        ss << index.CreateSQL(bp.GetTableName(), name, false) << ";\n";
+        ss << std::format("COMMENT ON INDEX {} IS '{}';\n", name, index.Fingerprint());
+    }
+
     return Utils::FixIndent(ss.str());
 }
 
+void Migrator::ValidatePartitioning(Blueprint const &bp) {
+    PartitionDef const &partition = bp.GetPartition();
+    std::string const &tableName = bp.GetTableName();
+    for (std::string const &column : partition.columns) {
+        if (!bp.GetColumns().contains(Utils::StringToLower(column))) {
+            throw std::invalid_argument(std::format("Partition column '{}' is not a column of table {}", column, tableName));
+        }
+    }
+    if (partition.strategy == PartitionStrategy::Hash && partition.modulus == 0) {
+        throw std::invalid_argument(std::format("Hash partitioned table {} needs Modulus(n) with n > 0", tableName));
+    }
+    if (partition.strategy == PartitionStrategy::List && partition.partitions.empty()) {
+        throw std::invalid_argument(std::format("List partitioned table {} declares no partition", tableName));
+    }
+    if (partition.interval) {
+        if (partition.strategy != PartitionStrategy::Range || partition.columns.size() != 1) {
+            throw std::invalid_argument(std::format("Rolling partitions of table {} need range partitioning on a single column", tableName));
+        }
+        SQLDataType const type = bp.GetColumns().at(Utils::StringToLower(partition.columns.front())).type;
+        if (type != SQLDataType::Date && type != SQLDataType::Timestamp) {
+            throw std::invalid_argument(std::format("Rolling partitions of table {} need a Date or Timestamp partition column", tableName));
+        }
+    }
+    // PostgreSQL can only enforce uniqueness per partition, so the key must decide the partition
+    for (IndexDef const &index : bp.GetEffectiveIndexes()) {
+        if (!index.unique) { continue; }
+        for (std::string const &column : partition.columns) {
+            if (!std::ranges::any_of(index.columns, [&column](std::string const &c) { return Utils::StringToLower(c) == Utils::StringToLower(column); })) {
+                throw std::invalid_argument(
+                    std::format("Unique index {} of partitioned table {} must include partition column '{}'", index.ResolvedName(tableName), tableName, column));
+            }
+        }
+    }
+}
+
+void Migrator::CollectPartitionStatements(Blueprint const &bp, std::vector<std::string> const &existing, std::chrono::sys_days today, bool withStatic,
+                                          std::vector<MigrationStatement> &alterStatements) {
+    PartitionDef const &partition = bp.GetPartition();
+    std::string const &tableName = bp.GetTableName();
+    std::unordered_set<std::string> const existingNames(existing.begin(), existing.end());
+    std::vector<StaticPartition> const staticPartitions = partition.StaticPartitions();
+    if (withStatic) {
+        for (StaticPartition const &sp : staticPartitions) {
+            if (existingNames.contains(std::format("{}_{}", Utils::StringToLower(tableName), Utils::StringToLower(sp.suffix)))) { continue; }
+            alterStatements.push_back(Quick(PartitionOfSQL(tableName, sp)));
+            Logger::Inf() << std::format("Migrator: {}", alterStatements.back().sql);
+        }
+    }
+    if (!partition.interval) { return; }
+
+    /* one partition per period, named after its first day (UTC); the current one and `premake`
+     * ahead are kept ready so inserts never hit a missing partition */
+    PartitionInterval const interval = *partition.interval;
+    bool const timestamp = bp.GetColumns().at(Utils::StringToLower(partition.columns.front())).type == SQLDataType::Timestamp;
+    auto literal = [timestamp](std::chrono::sys_days day) {
+        return timestamp ? std::format("'{:%Y-%m-%d} 00:00:00+00'", day) : std::format("'{:%Y-%m-%d}'", day);
+    };
+    std::chrono::sys_days const current = PartitionDef::PeriodStart(today, interval);
+    std::chrono::sys_days start = current;
+    for (size_t i = 0; i <= partition.premake; ++i) {
+        std::chrono::sys_days const end = PartitionDef::NextPeriod(start, interval);
+        std::string const name = PartitionDef::RollingName(tableName, start);
+        if (!existingNames.contains(name)) {
+            alterStatements.push_back(
+                Quick(std::format("CREATE TABLE IF NOT EXISTS {} PARTITION OF {} FOR VALUES FROM ({}) TO ({})", name, tableName, literal(start), literal(end))));
+            Logger::Inf() << std::format("Migrator: {}", alterStatements.back().sql);
+        }
+        start = end;
+    }
+
+    if (partition.retention == 0) { return; }
+    // keep the current period and `retention` before it
+    std::chrono::sys_days cutoff = current;
+    for (size_t i = 0; i < partition.retention; ++i) { cutoff = PartitionDef::PeriodStart(cutoff - std::chrono::days{1}, interval); }
+    // DETACH ... CONCURRENTLY is not allowed while the table has a default partition
+    bool const hasDefault = std::ranges::any_of(staticPartitions, [](StaticPartition const &sp) { return sp.boundSQL == "DEFAULT"; });
+    for (std::string const &name : existing) {
+        std::optional<std::chrono::sys_days> partitionStart = PartitionDef::ParseRollingName(tableName, name);
+        if (!partitionStart || PartitionDef::NextPeriod(*partitionStart, interval) > cutoff) { continue; }
+        if (hasDefault) {
+            alterStatements.push_back(Quick(std::format("ALTER TABLE {} DETACH PARTITION {}", tableName, name)));
+        } else {
+            alterStatements.push_back(Concurrent(std::format("ALTER TABLE {} DETACH PARTITION {} CONCURRENTLY", tableName, name), ""));
+        }
+        Logger::Inf() << std::format("Migrator: {}", alterStatements.back().sql);
+        if (partition.dropExpired) { alterStatements.push_back(Quick(std::format("DROP TABLE IF EXISTS {}", name))); }
+    }
+}
+
 // Helper to check if type and type parameters match (Length, Precision,
 // Identity)
 static auto SQLDataTypeAndParamsMatch(const Column &current, const Column &desired) -> bool {
-    if (current.type != desired.type) {
-        Logger::Dbg() << "type-mismatch: " << current.name;
+    if (current.type != desired.type || current.array != desired.array) {
+        STNL_LOG_DBG("type-mismatch: {}", current.name);
         return false;
     }
     if (desired.type == SQLDataType::Numeric) {
         if (current.precision != desired.precision || current.scale != desired.scale) {
-            Logger::Dbg() << "numberic-precision-mismatch: " << current.name;
+            STNL_LOG_DBG("numberic-precision-mismatch: {}", current.name);
             return false;
         }
     } else if (desired.type == SQLDataType::Varchar || desired.type == SQLDataType::Char || desired.type == SQLDataType::Bit) {
         if (current.length != desired.length) {
-            Logger::Dbg() << "(varchar|char|bit)-length-mismatch: " << current.name;
+            STNL_LOG_DBG("(varchar|char|bit)-length-mismatch: {}", current.name);
             return false;
         }
+    } else if (desired.type == SQLDataType::Timestamp && desired.explicitPrecision && current.precision != desired.precision) {
+        // introspection reports 6 for a plain TIMESTAMPTZ, which a blueprint without Precision() must not turn into TIMESTAMP(0)
+        if (desired.precision < current.precision && !desired.narrowPrecision) {
+            Logger::Wrn() << std::format("Migrator: keeping {} at precision {}, lowering it to {} truncates stored values and needs Precision({}, true)",
+                                         current.name, current.precision, desired.precision, desired.precision);
+            return true;
+        }
+        STNL_LOG_DBG("timestamp-precision-mismatch: {}", current.name);
+        return false;
     }
     return true;
 }
 
-// --- Core ApplyBlueprint Logic ---
+// --- Core migration logic ---
 
-void Migrator::ApplyBlueprint(DB &db, Blueprint const &bp) {
-    // NOTE: Removed previous Dbg/QExec calls to focus on migration logic.
-    std::string const &tableName = bp.GetTableName();
+auto Migrator::PlanBlueprint(Blueprint const &bp, Blueprint const *pCurrent, TableEstimate const &estimate, std::vector<std::string> const &partitions,
+                             MigrationOptions const &options) -> TablePlan {
+    TablePlan plan{.tableName = bp.GetTableName(),
+                   .create = pCurrent == nullptr,
+                   .estimatedRows = estimate.rows,
+                   .estimatedBytes = estimate.bytes,
+                   .statements = {},
+                   .hash = {}};
+    std::string const &tableName = plan.tableName;
 
-    // 1. Check for table existence
-    bool bTableExists = db.TableExists(tableName);
+    auto const today = std::chrono::floor<std::chrono::days>(std::chrono::system_clock::now());
+    bool const partitioned = bp.GetPartition().Enabled();
 
     // If table does not exist, create the full table
-    if (!bTableExists) {
+    if (pCurrent == nullptr) {
         Logger::Inf() << std::format("Migrator: Table '{}' does not exist. Creating.", tableName);
-        std::string createSQL = GenerateCreateSQL(bp);
-        QResult r = db.Exec(createSQL);
-        if (!r.ok) {
-            Logger::Err() << std::format("Migrator: Failed to create table {}: {}", tableName, r.msg);
-            throw std::runtime_error("Migration failed (CREATE TABLE) on " + tableName);
-        }
-        return; // Table created, migration complete for this blueprint
+        plan.statements.push_back(Quick(GenerateCreateSQL(bp)));
+        if (partitioned) { CollectPartitionStatements(bp, {}, today, false, plan.statements); }
+        return plan;
     }
+    // turning a table into a partitioned one (or back) means copying it; that is left to the application
+    if (partitioned != estimate.partitioned) {
+        Logger::Wrn() << std::format("Migrator: Table '{}' is {}partitioned in the database but {}in its blueprint, partitioning left unchanged.", tableName,
+                                     estimate.partitioned ? "" : "not ", partitioned ? "" : "not ");
+    }
+    bool const managePartitions = partitioned && estimate.partitioned;
+    if (managePartitions) { ValidatePartitioning(bp); }
 
-    // 2. Table exists, retrieve current schema
-    Blueprint oldBp = db.QueryBlueprint(tableName);
-
-    // 3. Compare blueprints and generate ALTER SQL
-    std::vector<std::string> alterStatements;
-
+    // Table exists: compare blueprints and generate ALTER SQL
+    bool const largeTable = options.largeTableRows > 0 && estimate.rows >= options.largeTableRows;
     std::vector<std::string> const &desiredColumnNames = bp.GetColumnNames();
     auto const &desiredColumns = bp.GetColumns();
-    auto const &currentColumns = oldBp.GetColumns();
+    auto const &currentColumns = pCurrent->GetColumns();
+    std::vector<std::string> rebuiltColumns; // swapped by expand/contract, their indexes are gone
 
-    // for (const auto& pair : desiredColumns) {
     for (std::string const &desiredNameLower : desiredColumnNames) {
         Column const &desiredCol = desiredColumns.at(desiredNameLower);
         auto it = currentColumns.find(desiredNameLower);
         // A. Column does not exist -> ADD COLUMN
         if (it == currentColumns.end()) {
             std::string addSQL = BuildAddColumnSQL(tableName, desiredCol);
-            alterStatements.emplace_back(addSQL);
+            plan.statements.push_back(Quick(addSQL));
             Logger::Inf() << std::format("Migrator: {}", addSQL);
             continue;
         }
 
         // B. Column exists -> Check for MODIFICATIONS (extracted to helper)
         Column const &currentCol = it->second;
-        CollectAlterStatementsForColumn(tableName, currentCol, desiredCol, alterStatements);
+        if (CollectAlterStatementsForColumn(tableName, currentCol, desiredCol, largeTable, plan.statements)) { rebuiltColumns.push_back(desiredCol.realName); }
+    }
+    if (managePartitions) { CollectPartitionStatements(bp, partitions, today, true, plan.statements); }
+    CollectIndexStatements(tableName, bp.GetEffectiveIndexes(), pCurrent->GetIndexes(), rebuiltColumns, estimate.partitioned ? &partitions : nullptr,
+                           plan.statements);
+    for (MigrationStatement &statement : plan.statements) {
+        if (statement.backfill) { statement.sql = std::vformat(statement.sql, std::make_format_args(options.backfillBatchSize)); }
     }
+    return plan;
+}
 
-    // 4. Execute ALTER statements
-    if (alterStatements.empty()) {
-        Logger::Inf() << std::format("Migrator: Table '{}' is already up to date.", tableName);
-        return;
+void Migrator::RunBackfill(DB &db, MigrationStatement const &statement, TxOptions const &txOptions) {
+    size_t total = 0;
+    for (;;) {
+        QResult r = db.ExecAutocommit(statement.sql, txOptions);
+        if (!r.ok) { throw std::runtime_error("Migration failed (backfill): " + r.msg); }
+        auto const affected = static_cast<size_t>(r.data.affected_rows());
+        if (affected == 0) { break; }
+        total += affected;
+    }
+    Logger::Inf() << std::format("Migrator: Backfilled {} row(s)", total);
+}
+
+void Migrator::ApplyTablePlan(DB &db, TablePlan const &plan, MigrationOptions const &options) {
+    if (!plan.create) { Logger::Inf() << std::format("Migrator: Applying {} change(s) to table '{}'.", plan.statements.size(), plan.tableName); }
+    TxOptions const txOptions{.maxRetries = options.maxRetries, .retryBackoff = options.retryBackoff, .lockTimeout = options.lockTimeout};
+    auto fail = [&plan](std::string const &sql, std::string const &msg) {
+        if (plan.create) {
+            Logger::Err() << std::format("Migrator: Failed to create table {}: {}", plan.tableName, msg);
+            throw std::runtime_error("Migration failed (CREATE TABLE) on " + plan.tableName);
+        }
+        Logger::Err() << std::format("Migrator: Failed ALTER SQL: {} Error: {}", sql, msg);
+        throw std::runtime_error("Migration failed (ALTER TABLE) due to SQL error on table " + plan.tableName);
+    };
+    /* cheap statements share one short transaction, so the table is locked once; anything
+     * that rewrites or scans runs on its own so it does not extend the others' locks */
+    std::vector<std::string> batch;
+    auto flush = [&]() {
+        if (batch.empty()) { return; }
+        TxResult<void> r = db.Work<void>(
+            [&batch](pqxx::work &tx) {
+                for (std::string const &sql : batch) { tx.exec(sql); }
+            },
+            txOptions);
+        if (!r.ok) { fail(Utils::Join(batch, "\n"), r.msg); }
+        batch.clear();
+    };
+    for (MigrationStatement const &statement : plan.statements) {
+        std::string fixedSQL = Utils::FixIndent(statement.sql);
+        if (!statement.rewrite && !statement.concurrent && !statement.backfill) {
+            batch.emplace_back(std::move(fixedSQL));
+            continue;
+        }
+        flush();
+        if (statement.backfill) {
+            RunBackfill(db, statement, txOptions);
+        } else if (statement.concurrent) {
+            QResult r = db.ExecAutocommit(fixedSQL, txOptions, statement.beforeRetry);
+            if (!r.ok) { fail(fixedSQL, r.msg); }
+        } else {
+            batch.emplace_back(std::move(fixedSQL));
+            flush();
+        }
     }
+    flush();
+    if (!plan.create) { Logger::Inf() << std::format("Migrator: Change(s) applied to table {}", plan.tableName); }
+}
 
-    Logger::Inf() << std::format("Migrator: Applying {} change(s) to table '{}'.", alterStatements.size(), tableName);
-    // Execute all statements in order
-    for (const std::string &sql : alterStatements) {
-        std::string fixedSQL = Utils::FixIndent(sql);
-        QResult r = db.Exec(fixedSQL, true);
-        if (!r.ok) {
-            Logger::Err() << std::format("Migrator: Failed ALTER SQL: {} Error: {}", fixedSQL, r.msg);
-            throw std::runtime_error("Migration failed (ALTER TABLE) due to SQL error on table " + tableName);
+/* Tables a plan's statements point at with REFERENCES or PARTITION OF, lower-cased. */
+static auto ReferencedTables(TablePlan const &plan) -> std::unordered_set<std::string> {
+    std::unordered_set<std::string> tables;
+    for (MigrationStatement const &statement : plan.statements) {
+        std::string const sql = Utils::StringToLower(statement.sql);
+        for (std::string_view const keyword : {"references ", "partition of "}) {
+            for (size_t pos = sql.find(keyword); pos != std::string::npos; pos = sql.find(keyword, pos + 1)) {
+                size_t const start = sql.find_first_not_of(' ', pos + keyword.size());
+                if (start == std::string::npos) { break; }
+                size_t const end = sql.find_first_of(" (;,\n", start);
+                std::string name = sql.substr(start, end == std::string::npos ? std::string::npos : end - start);
+                if (size_t const dot = name.rfind('.'); dot != std::string::npos) { name.erase(0, dot + 1); }
+                tables.insert(std::move(name));
+            }
         }
     }
-    Logger::Inf() << std::format("Migrator: Change(s) applied to table {}", tableName);
+    return tables;
 }
 
-void Migrator::ApplyProcedureBlueprint(DB &db, SrBlueprint const &srBp) {
+/* Orders the plans into waves: a plan runs after every plan of a table it references and
+ * after earlier plans of its own table; plans in one wave are independent. A cycle, which
+ * PostgreSQL would reject anyway, leaves its plans to a final wave run one by one. */
+static auto DependencyWaves(std::vector<TablePlan> const &plans) -> std::vector<std::vector<size_t>> {
+    std::unordered_map<std::string, std::vector<size_t>> byTable;
+    for (size_t i = 0; i < plans.size(); ++i) { byTable[Utils::StringToLower(plans[i].tableName)].push_back(i); }
+    std::vector<std::vector<size_t>> dependsOn(plans.size());
+    for (size_t i = 0; i < plans.size(); ++i) {
+        std::string const own = Utils::StringToLower(plans[i].tableName);
+        for (size_t const j : byTable[own]) {
+            if (j < i) { dependsOn[i].push_back(j); }
+        }
+        for (std::string const &table : ReferencedTables(plans[i])) {
+            if (table == own) { continue; }
+            auto it = byTable.find(table);
+            if (it != byTable.end()) { dependsOn[i].insert(dependsOn[i].end(), it->second.begin(), it->second.end()); }
+        }
+    }
+    std::vector<std::vector<size_t>> waves;
+    std::vector<bool> scheduled(plans.size(), false);
+    size_t remaining = plans.size();
+    while (remaining > 0) {
+        std::vector<size_t> wave;
+        for (size_t i = 0; i < plans.size(); ++i) {
+            if (scheduled[i]) { continue; }
+            if (std::ranges::all_of(dependsOn[i], [&scheduled](size_t j) { return scheduled[j]; })) { wave.push_back(i); }
+        }
+        if (wave.empty()) {
+            Logger::Wrn() << "Migrator::Migrate: circular table dependencies, applying the rest one table at a time";
+            for (size_t i = 0; i < plans.size(); ++i) {
+                if (!scheduled[i]) { waves.push_back({i}); }
+            }
+            break;
+        }
+        for (size_t const i : wave) { scheduled[i] = true; }
+        remaining -= wave.size();
+        waves.push_back(std::move(wave));
+    }
+    return waves;
+}
 
+void Migrator::ApplyTablePlans(DB &db, std::vector<TablePlan> const &plans, MigrationOptions const &options) {
+    if (plans.empty()) { return; }
+    /* independent tables are applied in parallel, one worker per pooled connection pulling
+     * the next table of the wave; a wave starts once the tables it depends on are done */
+    size_t const maxWorkers = std::max<size_t>(1, db.GetPool().GetStats().maxSize);
+    for (std::vector<size_t> const &wave : DependencyWaves(plans)) {
+        size_t const workers = std::min(wave.size(), maxWorkers);
+        std::atomic<size_t> next{0};
+        std::vector<std::future<void>> futures;
+        futures.reserve(workers);
+        for (size_t w = 0; w < workers; ++w) {
+            futures.emplace_back(db.QFuture<void>([&db, &plans, &wave, &next, &options]() {
+                for (size_t i = next.fetch_add(1); i < wave.size(); i = next.fetch_add(1)) {
+                    TablePlan const &plan = plans[wave[i]];
+                    try {
+                        ApplyTablePlan(db, plan, options);
+                        RecordApplied(db, "table", plan.tableName, plan.hash);
+                    } catch (std::exception const &e) { Logger::Err() << "Migrator::Migrate: Error: " + std::string(e.what()); }
+                }
+            }));
+        }
+        for (std::future<void> &f : futures) { f.get(); }
+    }
+}
+
+auto Migrator::GenerateProcedureSQL(SrBlueprint const &srBp) -> std::string {
     std::stringstream ss;
     ss << std::format("CREATE OR REPLACE PROCEDURE {}", srBp.GetName());
     std::unordered_map<std::string, SrParam> const &params = srBp.GetParams();
@@ -366,14 +1059,17 @@ void Migrator::ApplyProcedureBlueprint(DB &db, SrBlueprint const &srBp) {
     ss << "AS " + bodyDelimiter + '\n';
     ss << std::string(srBp.GetBody());
     ss << '\n' + bodyDelimiter + ";\n";
-    std::string qSQL = Utils::FixIndent(ss.str());
-    QResult r = db.Exec(qSQL);
+    return Utils::FixIndent(ss.str());
+}
+
+void Migrator::ApplyProcedurePlan(DB &db, ProcedurePlan const &plan) {
+    QResult r = db.Exec(plan.sql);
     if (!r.ok) {
-        Logger::Err() << std::format("Migrator: Failed CREATE OR REPLACE PROCEDURE. SQL: {} Error: {}", qSQL, r.msg);
+        Logger::Err() << std::format("Migrator: Failed CREATE OR REPLACE PROCEDURE. SQL: {} Error: {}", plan.sql, r.msg);
         throw std::runtime_error("Migration failed (CREATE OR REPLACE PROCEDURE) due to SQL error. "
                                  "Procedure name: " +
-                                 std::string(srBp.GetName()));
+                                 plan.name);
     }
-    Logger::Inf() << std::format("Migrator: PROCEDURE CREATED/REPLACED: {}", srBp.GetName());
+    Logger::Inf() << std::format("Migrator: PROCEDURE CREATED/REPLACED: {}", plan.name);
 }
 } // namespace STNL
@@ -0,0 +1,166 @@
+#include "stnl/db/notification_listener.hpp"
+#include "stnl/core/logger.hpp"
+
+#include <boost/asio.hpp>
+#include <pqxx/pqxx>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR)
+#include <unistd.h>
+#endif
+
+namespace asio = boost::asio;
+
+namespace STNL {
+
+namespace {
+constexpr std::chrono::milliseconds RECONNECT_INITIAL{250};
+constexpr std::chrono::milliseconds RECONNECT_MAX{30000};
+[[maybe_unused]] constexpr std::chrono::milliseconds POLL_INTERVAL{100};
+} // namespace
+
+NotificationListener::NotificationListener(std::string connStr, asio::io_context &ioc)
+    : connStr_(std::move(connStr)), ioc_(ioc), strand_(asio::make_strand(ioc)), timer_(strand_), backoff_(RECONNECT_INITIAL) {}
+
+auto NotificationListener::Subscribe(std::string const &channel, NotificationHandler handler) -> size_t {
+    size_t const subscriptionId = nextSubscriptionId_.fetch_add(1, std::memory_order_relaxed);
+    /* the LISTEN itself happens on the strand; the caller never waits for the database */
+    asio::dispatch(strand_, [self = shared_from_this(), subscriptionId, channel, handler = std::move(handler)]() mutable {
+        bool const firstOnChannel = std::none_of(self->subscriptions_.begin(), self->subscriptions_.end(),
+                                                 [&channel](auto const &entry) { return entry.second.channel == channel; });
+        self->subscriptions_.emplace(subscriptionId, Subscription{.channel = channel, .handler = std::move(handler)});
+        if (self->stopped_) { return; }
+        if (!self->started_) {
+            self->started_ = true;
+            self->Connect();
+        } else if (firstOnChannel && self->conn_) {
+            try {
+                self->ListenOn(channel);
+            } catch (std::exception const &e) {
+                Logger::Err() << "NotificationListener::Subscribe: " << e.what();
+                self->Disconnect();
+                self->ScheduleReconnect();
+            }
+        }
+    });
+    return subscriptionId;
+}
+
+void NotificationListener::Unsubscribe(size_t subscriptionId) {
+    asio::dispatch(strand_, [self = shared_from_this(), subscriptionId]() {
+        auto it = self->subscriptions_.find(subscriptionId);
+        if (it == self->subscriptions_.end()) { return; }
+        std::string const channel = it->second.channel;
+        self->subscriptions_.erase(it);
+        bool const lastOnChannel = std::none_of(self->subscriptions_.begin(), self->subscriptions_.end(),
+                                                [&channel](auto const &entry) { return entry.second.channel == channel; });
+        if (!lastOnChannel || !self->conn_) { return; }
+        try {
+            self->conn_->listen(channel); // an empty handler UNLISTENs
+        } catch (std::exception const &e) { Logger::Wrn() << "NotificationListener::Unsubscribe: " << e.what(); }
+    });
+}
+
+void NotificationListener::Stop() {
+    asio::dispatch(strand_, [self = shared_from_this()]() {
+        self->stopped_ = true;
+        self->timer_.cancel();
+        self->Disconnect();
+    });
+}
+
+void NotificationListener::Connect() {
+    if (stopped_) { return; }
+    try {
+        conn_ = std::make_unique<pqxx::connection>(connStr_);
+        std::vector<std::string> channels;
+        for (auto const &[id, subscription] : subscriptions_) {
+            if (std::find(channels.begin(), channels.end(), subscription.channel) == channels.end()) { channels.push_back(subscription.channel); }
+        }
+        for (std::string const &channel : channels) { ListenOn(channel); }
+#if defined(BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR)
+        // asio owns (and closes) the descriptor it is given, libpq keeps its own
+        socket_.emplace(strand_, ::dup(conn_->sock()));
+#endif
+        backoff_ = RECONNECT_INITIAL;
+        Logger::Inf() << std::format("NotificationListener: listening on {} channel(s)", channels.size());
+        WaitForNotifications();
+    } catch (std::exception const &e) {
+        Logger::Err() << "NotificationListener::Connect: " << e.what();
+        Disconnect();
+        ScheduleReconnect();
+    }
+}
+
+void NotificationListener::Disconnect() {
+#if defined(BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR)
+    if (socket_) {
+        boost::system::error_code ignored;
+        socket_->close(ignored);
+        socket_.reset();
+    }
+#endif
+    conn_.reset();
+}
+
+void NotificationListener::ScheduleReconnect() {
+    if (stopped_) { return; }
+    Logger::Wrn() << std::format("NotificationListener: reconnecting in {}ms", backoff_.count());
+    timer_.expires_after(backoff_);
+    backoff_ = std::min(backoff_ * 2, RECONNECT_MAX);
+    timer_.async_wait([self = shared_from_this()](boost::system::error_code ec) {
+        if (!ec) { self->Connect(); }
+    });
+}
+
+void NotificationListener::WaitForNotifications() {
+    if (stopped_ || !conn_) { return; }
+#if defined(BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR)
+    socket_->async_wait(asio::posix::stream_descriptor::wait_read,
+                        asio::bind_executor(strand_, [self = shared_from_this()](boost::system::error_code ec) { self->OnReadable(ec); }));
+#else
+    /* no portable way to watch libpq's socket here: poll instead */
+    timer_.expires_after(POLL_INTERVAL);
+    timer_.async_wait([self = shared_from_this()](boost::system::error_code ec) { self->OnReadable(ec); });
+#endif
+}
+
+void NotificationListener::OnReadable(boost::system::error_code ec) {
+    if (stopped_ || ec == asio::error::operation_aborted) { return; }
+    try {
+        if (ec) { throw std::runtime_error(ec.message()); }
+        conn_->get_notifs(); // invokes Dispatch for every pending notification
+    } catch (std::exception const &e) {
+        Logger::Err() << "NotificationListener: connection lost: " << e.what();
+        Disconnect();
+        ScheduleReconnect();
+        return;
+    }
+    WaitForNotifications();
+}
+
+void NotificationListener::ListenOn(std::string const &channel) {
+    conn_->listen(channel, [this](pqxx::notification notification) { Dispatch(notification); });
+}
+
+void NotificationListener::Dispatch(pqxx::notification const &notification) {
+    auto delivered = std::make_shared<DBNotification const>(
+        DBNotification{.channel = std::string(notification.channel), .payload = std::string(notification.payload), .backendPid = notification.backend_pid});
+    for (auto const &[id, subscription] : subscriptions_) {
+        if (subscription.channel != delivered->channel) { continue; }
+        asio::post(ioc_, [handler = subscription.handler, delivered]() {
+            try {
+                handler(*delivered);
+            } catch (std::exception const &e) { Logger::Err() << "NotificationListener: handler for " << delivered->channel << " threw: " << e.what(); }
+        });
+    }
+}
+
+} // namespace STNL
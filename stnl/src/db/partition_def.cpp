@@ -0,0 +1,116 @@
+#include "stnl/db/partition_def.hpp"
+#include "stnl/core/utils.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace STNL {
+
+auto PartitionDef::Enabled() const -> bool {
+    return strategy != PartitionStrategy::None && !columns.empty();
+}
+
+auto PartitionDef::ClauseSQL() const -> std::string {
+    char const *kind = strategy == PartitionStrategy::List ? "LIST" : strategy == PartitionStrategy::Hash ? "HASH" : "RANGE";
+    return std::format("PARTITION BY {} ({})", kind, Utils::Join(columns, ", "));
+}
+
+auto PartitionDef::StaticPartitions() const -> std::vector<StaticPartition> {
+    std::vector<StaticPartition> all = partitions;
+    if (strategy == PartitionStrategy::Hash) {
+        for (std::size_t remainder = 0; remainder < modulus; ++remainder) {
+            all.push_back(StaticPartition{.suffix = std::format("h{}", remainder), .boundSQL = std::format("WITH (MODULUS {}, REMAINDER {})", modulus, remainder)});
+        }
+    }
+    return all;
+}
+
+auto PartitionDef::PeriodStart(std::chrono::sys_days day, PartitionInterval interval) -> std::chrono::sys_days {
+    using namespace std::chrono;
+    year_month_day const ymd{day};
+    switch (interval) {
+    case PartitionInterval::Day: return day;
+    case PartitionInterval::Week: return day - (weekday{day} - Monday); // ISO weeks start on Monday
+    case PartitionInterval::Month: return sys_days{ymd.year() / ymd.month() / 1};
+    case PartitionInterval::Year: return sys_days{ymd.year() / January / 1};
+    }
+    return day;
+}
+
+auto PartitionDef::NextPeriod(std::chrono::sys_days start, PartitionInterval interval) -> std::chrono::sys_days {
+    using namespace std::chrono;
+    year_month_day const ymd{start};
+    switch (interval) {
+    case PartitionInterval::Day: return start + days{1};
+    case PartitionInterval::Week: return start + weeks{1};
+    case PartitionInterval::Month: return sys_days{(ymd.year() / ymd.month() + months{1}) / 1};
+    case PartitionInterval::Year: return sys_days{(ymd.year() + years{1}) / January / 1};
+    }
+    return start + days{1};
+}
+
+auto PartitionDef::RollingName(std::string const &tableName, std::chrono::sys_days start) -> std::string {
+    std::chrono::year_month_day const ymd{start};
+    return std::format("{}_p{:04}{:02}{:02}", Utils::StringToLower(tableName), static_cast<int>(ymd.year()), static_cast<unsigned>(ymd.month()),
+                       static_cast<unsigned>(ymd.day()));
+}
+
+auto PartitionDef::ParseRollingName(std::string const &tableName, std::string const &partitionName) -> std::optional<std::chrono::sys_days> {
+    std::string const prefix = Utils::StringToLower(tableName) + "_p";
+    std::string const name = Utils::StringToLower(partitionName);
+    if (name.size() != prefix.size() + 8 || !name.starts_with(prefix)) { return std::nullopt; }
+    int y = 0;
+    unsigned m = 0;
+    unsigned d = 0;
+    char const *p = name.data() + prefix.size();
+    if (std::from_chars(p, p + 4, y).ptr != p + 4 || std::from_chars(p + 4, p + 6, m).ptr != p + 6 || std::from_chars(p + 6, p + 8, d).ptr != p + 8) {
+        return std::nullopt;
+    }
+    std::chrono::year_month_day const ymd{std::chrono::year{y}, std::chrono::month{m}, std::chrono::day{d}};
+    if (!ymd.ok()) { return std::nullopt; }
+    return std::chrono::sys_days{ymd};
+}
+
+PartitionProxy::PartitionProxy(PartitionDef &d) : def(d) {}
+
+auto PartitionProxy::Every(PartitionInterval interval) -> PartitionProxy & {
+    def.interval = interval;
+    return *this;
+}
+
+auto PartitionProxy::Premake(std::size_t n) -> PartitionProxy & {
+    def.premake = n;
+    return *this;
+}
+
+auto PartitionProxy::Retain(std::size_t n, bool dropExpired) -> PartitionProxy & {
+    def.retention = n;
+    def.dropExpired = dropExpired;
+    return *this;
+}
+
+auto PartitionProxy::Values(std::string suffix, std::vector<std::string> values) -> PartitionProxy & {
+    def.partitions.push_back(StaticPartition{.suffix = std::move(suffix), .boundSQL = std::format("IN ({})", Utils::Join(values, ", "))});
+    return *this;
+}
+
+auto PartitionProxy::Range(std::string suffix, std::string from, std::string to) -> PartitionProxy & {
+    def.partitions.push_back(StaticPartition{.suffix = std::move(suffix), .boundSQL = std::format("FROM ({}) TO ({})", from, to)});
+    return *this;
+}
+
+auto PartitionProxy::Default(std::string suffix) -> PartitionProxy & {
+    def.partitions.push_back(StaticPartition{.suffix = std::move(suffix), .boundSQL = "DEFAULT"});
+    return *this;
+}
+
+auto PartitionProxy::Modulus(std::size_t n) -> PartitionProxy & {
+    def.modulus = n;
+    return *this;
+}
+
+} // namespace STNL
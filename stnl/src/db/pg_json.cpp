@@ -0,0 +1,87 @@
+#include "stnl/db/pg_json.hpp"
+#include "stnl/core/utils.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <string>
+#include <system_error>
+
+namespace STNL {
+
+// "\x0a1b..." (bytea_output = hex) to base64; escape format output is passed through as text.
+static auto ByteaToJson(std::string_view text) -> boost::json::value {
+    if (!text.starts_with("\\x") || text.size() % 2 != 0) { return boost::json::string(text); }
+    std::string bytes;
+    bytes.reserve((text.size() - 2) / 2);
+    for (size_t i = 2; i + 1 < text.size(); i += 2) {
+        unsigned value = 0;
+        if (std::from_chars(text.data() + i, text.data() + i + 2, value, 16).ptr != text.data() + i + 2) { return boost::json::string(text); }
+        bytes += static_cast<char>(value);
+    }
+    return boost::json::string(Utils::Base64Encode(bytes));
+}
+
+// "2026-10-19 12:34:56.5+02" to ISO 8601 "2026-10-19T12:34:56.5+02:00"; infinity and the like stay as they are.
+static auto TimestampToJson(std::string_view text) -> boost::json::value {
+    constexpr size_t DATE_LENGTH = 10;
+    constexpr size_t TIME_END = 19;
+    if (text.size() < TIME_END || text[DATE_LENGTH] != ' ') { return boost::json::string(text); }
+    std::string iso{text};
+    iso[DATE_LENGTH] = 'T';
+    size_t const sign = iso.find_last_of("+-");
+    if (sign != std::string::npos && sign >= TIME_END && iso.size() - sign == 3) { iso += ":00"; }
+    return boost::json::string(iso);
+}
+
+auto PgTextToJson(std::string_view text, std::string_view typname) -> boost::json::value {
+    if (typname == "int2" || typname == "int4" || typname == "int8") {
+        long long value = 0;
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (ec == std::errc{} && end == text.data() + text.size()) { return value; }
+    } else if (typname == "numeric" || typname == "float4" || typname == "float8") {
+        double value = 0;
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        // NaN and Infinity have no JSON number
+        if (ec == std::errc{} && end == text.data() + text.size() && std::isfinite(value)) { return value; }
+    } else if (typname == "bool") {
+        return text == "t";
+    } else if (typname == "json" || typname == "jsonb") {
+        boost::system::error_code ec;
+        boost::json::value value = boost::json::parse(text, ec);
+        if (!ec) { return value; }
+    } else if (typname == "bytea") {
+        return ByteaToJson(text);
+    } else if (typname == "timestamptz" || typname == "timestamp") {
+        return TimestampToJson(text);
+    }
+    return boost::json::string(text);
+}
+
+auto PgArrayToJson(std::string_view text, size_t &pos, std::string_view elemTypname) -> boost::json::array {
+    boost::json::array out;
+    ++pos; // '{'
+    while (pos < text.size() && text[pos] != '}') {
+        if (text[pos] == '{') {
+            out.emplace_back(PgArrayToJson(text, pos, elemTypname));
+        } else if (text[pos] == '"') {
+            std::string item;
+            for (++pos; pos < text.size() && text[pos] != '"'; ++pos) {
+                if (text[pos] == '\\' && pos + 1 < text.size()) { ++pos; }
+                item += text[pos];
+            }
+            ++pos; // closing '"'
+            out.emplace_back(PgTextToJson(item, elemTypname));
+        } else {
+            size_t end = text.find_first_of(",}", pos);
+            if (end == std::string_view::npos) { end = text.size(); }
+            std::string_view const item = text.substr(pos, end - pos);
+            out.emplace_back(item == "NULL" ? boost::json::value(nullptr) : PgTextToJson(item, elemTypname));
+            pos = end;
+        }
+        if (pos < text.size() && text[pos] == ',') { ++pos; }
+    }
+    ++pos; // '}'
+    return out;
+}
+
+} // namespace STNL
@@ -0,0 +1,265 @@
+#include "stnl/db/query_cache.hpp"
+#include "stnl/core/utils.hpp"
+
+#include <cctype>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace STNL {
+
+auto QueryCache::Entry::Json(std::function<std::string(pqxx::result const &)> const &serialize) const -> std::shared_ptr<std::string const> {
+    std::call_once(jsonOnce_, [&]() { json_ = std::make_shared<std::string const>(serialize(data)); });
+    return json_;
+}
+
+QueryCache::QueryCache(size_t maxEntries) : maxEntries_(maxEntries) {}
+
+auto QueryCache::GetOrLoad(std::string const &key, CacheOptions const &options, std::string_view qSQL, Loader const &load)
+    -> std::shared_ptr<Entry const> {
+    // shared: a coalesced caller's promise is fulfilled by the loading thread
+    auto promise = std::make_shared<std::promise<std::shared_ptr<Entry const>>>();
+    std::future<std::shared_ptr<Entry const>> future = promise->get_future();
+    AsyncGetOrLoad(key, options, qSQL, load, [promise](std::shared_ptr<Entry const> entry) { promise->set_value(std::move(entry)); });
+    return future.get();
+}
+
+void QueryCache::AsyncGetOrLoad(std::string const &key, CacheOptions const &options, std::string_view qSQL, Loader const &load, Completion done) {
+    auto entry = std::make_shared<Entry>();
+    std::vector<uint64_t> startEpochs;
+    uint64_t startAllEpoch = 0;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            if (std::chrono::steady_clock::now() < it->second.entry->expiresAt) {
+                ++stats_.hits;
+                lru_.splice(lru_.begin(), lru_, it->second.lruIt);
+                std::shared_ptr<Entry const> hit = it->second.entry;
+                lock.unlock();
+                done(std::move(hit));
+                return;
+            }
+            EraseLocked(it);
+        }
+        if (auto flight = inFlight_.find(key); flight != inFlight_.end()) {
+            ++stats_.coalesced;
+            flight->second.push_back(std::move(done));
+            return;
+        }
+        ++stats_.misses;
+        inFlight_.emplace(key, std::vector<Completion>{});
+        tracked_.fetch_add(1, std::memory_order_relaxed);
+        entry->tables = options.tables.empty() ? TablesOf(qSQL) : options.tables;
+        if (entry->tables.empty()) { entry->tables.emplace_back(ANY_TABLE); }
+        startEpochs.reserve(entry->tables.size());
+        for (std::string &table : entry->tables) {
+            table = Utils::StringToLower(table);
+            auto epochIt = tableEpochs_.find(table);
+            startEpochs.push_back(epochIt == tableEpochs_.end() ? 0 : epochIt->second);
+        }
+        startAllEpoch = allEpoch_;
+    }
+
+    try {
+        load(*entry);
+    } catch (std::exception const &e) {
+        entry->ok = false;
+        entry->msg = e.what();
+    }
+    entry->expiresAt = std::chrono::steady_clock::now() + options.ttl;
+
+    std::vector<Completion> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto flight = inFlight_.find(key);
+        waiters = std::move(flight->second);
+        inFlight_.erase(flight);
+        tracked_.fetch_sub(1, std::memory_order_relaxed);
+        bool unchanged = allEpoch_ == startAllEpoch;
+        for (size_t i = 0; unchanged && i < entry->tables.size(); ++i) {
+            auto epochIt = tableEpochs_.find(entry->tables[i]);
+            unchanged = (epochIt == tableEpochs_.end() ? 0 : epochIt->second) == startEpochs[i];
+        }
+        if (entry->ok && unchanged && options.ttl.count() > 0 && maxEntries_ > 0) {
+            lru_.push_front(key);
+            entries_[key] = Slot{.entry = entry, .lruIt = lru_.begin()};
+            tracked_.fetch_add(1, std::memory_order_relaxed);
+            for (std::string const &table : entry->tables) { tableKeys_[table].insert(key); }
+            EvictLocked();
+        }
+    }
+    done(entry);
+    for (Completion const &waiter : waiters) { waiter(entry); }
+}
+
+void QueryCache::InvalidateTable(std::string_view tableName) {
+    if (tracked_.load(std::memory_order_relaxed) == 0) { return; }
+    std::string const table = Utils::StringToLower(tableName);
+    std::lock_guard<std::mutex> lock(mutex_);
+    InvalidateTableLocked(table);
+    InvalidateTableLocked(std::string(ANY_TABLE));
+}
+
+void QueryCache::InvalidateTableLocked(std::string const &table) {
+    ++tableEpochs_[table];
+    auto keysIt = tableKeys_.find(table);
+    if (keysIt == tableKeys_.end()) { return; }
+    std::unordered_set<std::string> const keys = std::move(keysIt->second);
+    tableKeys_.erase(keysIt);
+    for (std::string const &key : keys) {
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            ++stats_.invalidations;
+            EraseLocked(it);
+        }
+    }
+}
+
+void QueryCache::InvalidateAll() {
+    if (tracked_.load(std::memory_order_relaxed) == 0) { return; }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++allEpoch_;
+    stats_.invalidations += entries_.size();
+    tracked_.fetch_sub(entries_.size(), std::memory_order_relaxed);
+    entries_.clear();
+    lru_.clear();
+    tableKeys_.clear();
+}
+
+void QueryCache::SetMaxEntries(size_t maxEntries) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxEntries_ = maxEntries;
+    EvictLocked();
+}
+
+auto QueryCache::GetStats() -> Stats {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.size = entries_.size();
+    return stats;
+}
+
+void QueryCache::EraseLocked(std::unordered_map<std::string, Slot>::iterator it) {
+    for (std::string const &table : it->second.entry->tables) {
+        auto keysIt = tableKeys_.find(table);
+        if (keysIt == tableKeys_.end()) { continue; }
+        keysIt->second.erase(it->first);
+        if (keysIt->second.empty()) { tableKeys_.erase(keysIt); }
+    }
+    lru_.erase(it->second.lruIt);
+    entries_.erase(it);
+    tracked_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void QueryCache::EvictLocked() {
+    while (entries_.size() > maxEntries_ && !lru_.empty()) {
+        auto it = entries_.find(lru_.back());
+        if (it == entries_.end()) {
+            lru_.pop_back();
+            continue;
+        }
+        ++stats_.evictions;
+        EraseLocked(it);
+    }
+}
+
+auto QueryCache::TablesOf(std::string_view qSQL) -> std::vector<std::string> {
+    /* a small scanner: skips literals and comments, tracks parentheses so a subquery in a
+     * FROM list does not end the list, and keeps expecting a table after every comma of it */
+    enum class Expect { None, Table, AfterTable };
+    struct Level {
+        Expect expect = Expect::None;
+        bool fromList = false; // commas at this level separate FROM items
+    };
+    static std::unordered_set<std::string_view> const endsList{"where",  "group", "order",  "limit",  "having", "window", "union",     "except",
+                                                               "intersect", "returning", "set", "values", "select", "offset", "fetch", "for"};
+    std::vector<std::string> tables;
+    std::string previous; // last keyword or name outside of a table position
+    std::vector<Level> levels(1);
+    size_t i = 0;
+    while (i < qSQL.size()) {
+        Level &level = levels.back();
+        char const c = qSQL[i];
+        if (std::isspace(static_cast<unsigned char>(c)) != 0) {
+            ++i;
+        } else if (c == '\'') {
+            i = qSQL.find('\'', i + 1);
+            if (i == std::string_view::npos) { break; }
+            ++i;
+        } else if (qSQL.substr(i, 2) == "--") {
+            i = qSQL.find('\n', i);
+        } else if (qSQL.substr(i, 2) == "/*") {
+            i = qSQL.find("*/", i + 2);
+            if (i != std::string_view::npos) { i += 2; }
+        } else if (std::isalpha(static_cast<unsigned char>(c)) != 0 || c == '_' || c == '"') {
+            /* a possibly qualified name; the last part counts, quoted parts may hold anything */
+            std::string part;
+            bool quoted = false;
+            while (i < qSQL.size()) {
+                if (qSQL[i] == '"') {
+                    size_t const close = qSQL.find('"', i + 1);
+                    if (close == std::string_view::npos) { return {}; }
+                    part = Utils::StringToLower(qSQL.substr(i + 1, close - i - 1));
+                    quoted = true;
+                    i = close + 1;
+                } else {
+                    size_t const start = i;
+                    while (i < qSQL.size() && (std::isalnum(static_cast<unsigned char>(qSQL[i])) != 0 || qSQL[i] == '_' || qSQL[i] == '$')) { ++i; }
+                    part = Utils::StringToLower(qSQL.substr(start, i - start));
+                    quoted = false;
+                }
+                if (i < qSQL.size() && qSQL[i] == '.') {
+                    ++i;
+                    continue;
+                }
+                break;
+            }
+            if (level.expect == Expect::Table) {
+                if (!quoted && (part == "only" || part == "lateral" || part == "if" || part == "not" || part == "exists")) { continue; }
+                tables.push_back(std::move(part));
+                level.expect = Expect::AfterTable;
+                continue;
+            }
+            if (quoted) { continue; }
+            // FOR [NO KEY] UPDATE and ON CONFLICT DO UPDATE name no table
+            bool const lockOrUpsert = part == "update" && (previous == "for" || previous == "key" || previous == "do");
+            if (part == "from" || part == "using") {
+                level = Level{.expect = Expect::Table, .fromList = true};
+            } else if (part == "join") {
+                level.expect = Expect::Table;
+            } else if ((part == "into" || part == "update" || part == "table") && !lockOrUpsert) {
+                level = Level{.expect = Expect::Table, .fromList = false};
+            } else if (endsList.contains(part)) {
+                level = Level{};
+            } // anything else is an alias, a join keyword or part of an expression
+            previous = std::move(part);
+        } else if (c == '(') {
+            if (level.expect == Expect::Table) { level.expect = Expect::AfterTable; } // subquery or function in a FROM list
+            levels.emplace_back();
+            ++i;
+        } else if (c == ')') {
+            if (levels.size() > 1) { levels.pop_back(); }
+            ++i;
+        } else if (c == ',') {
+            if (level.fromList) {
+                level.expect = Expect::Table;
+            } else if (level.expect == Expect::Table) {
+                return {};
+            }
+            ++i;
+        } else {
+            // nothing else may stand where a table is expected
+            if (level.expect == Expect::Table) { return {}; }
+            if (!level.fromList) { level.expect = Expect::None; }
+            ++i;
+        }
+    }
+    for (Level const &level : levels) {
+        if (level.expect == Expect::Table) { return {}; }
+    }
+    return tables;
+}
+
+} // namespace STNL
@@ -109,4 +109,29 @@ auto SrBlueprint::Text(const std::string &name) -> TextParamProxy {
     SrParam &param = GetOrAddParam(name);
     return {param};
 }
+
+auto SrBlueprint::Real(const std::string &name) -> RealParamProxy {
+    SrParam &param = GetOrAddParam(name);
+    return RealParamProxy{param};
+}
+
+auto SrBlueprint::DoublePrecision(const std::string &name) -> DoublePrecisionParamProxy {
+    SrParam &param = GetOrAddParam(name);
+    return DoublePrecisionParamProxy{param};
+}
+
+auto SrBlueprint::Json(const std::string &name) -> JsonParamProxy {
+    SrParam &param = GetOrAddParam(name);
+    return JsonParamProxy{param};
+}
+
+auto SrBlueprint::Jsonb(const std::string &name) -> JsonbParamProxy {
+    SrParam &param = GetOrAddParam(name);
+    return JsonbParamProxy{param};
+}
+
+auto SrBlueprint::Bytea(const std::string &name) -> ByteaParamProxy {
+    SrParam &param = GetOrAddParam(name);
+    return ByteaParamProxy{param};
+}
 } // namespace STNL
\ No newline at end of file
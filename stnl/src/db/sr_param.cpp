@@ -12,7 +12,7 @@ constexpr std::size_t DEFAULT_VARCHAR_LENGTH = 255;
 
 namespace STNL {
 SrParam::SrParam(std::string paramName, SQLDataType const &paramType)
-    : name(std::move(paramName)), type(paramType), length(0), nullable(false), out(false), in(false), precision(0), scale(0) {}
+    : name(std::move(paramName)), type(paramType), length(0), nullable(false), out(false), in(false), array(false), precision(0), scale(0) {}
 
 BigIntParamProxy::BigIntParamProxy(SrParam &param) : SrParamProxy(param) {
     param.type = SQLDataType::BigInt;
@@ -100,6 +100,11 @@ auto TimestampParamProxy::Default(std::string const &v) -> TimestampParamProxy &
     return SrParamProxy<TimestampParamProxy>::Default(v);
 }
 
+auto TimestampParamProxy::Precision(unsigned short v) -> TimestampParamProxy & {
+    param.precision = v;
+    return *this;
+}
+
 UUIDParamProxy::UUIDParamProxy(SrParam &param) : SrParamProxy(param) {
     param.type = SQLDataType::UUID;
 }
@@ -112,4 +117,24 @@ TextParamProxy::TextParamProxy(SrParam &param) : SrParamProxy(param) {
     param.type = SQLDataType::Text;
 }
 
+RealParamProxy::RealParamProxy(SrParam &param) : SrParamProxy(param) {
+    param.type = SQLDataType::Real;
+}
+
+DoublePrecisionParamProxy::DoublePrecisionParamProxy(SrParam &param) : SrParamProxy(param) {
+    param.type = SQLDataType::DoublePrecision;
+}
+
+JsonParamProxy::JsonParamProxy(SrParam &param) : SrParamProxy(param) {
+    param.type = SQLDataType::Json;
+}
+
+JsonbParamProxy::JsonbParamProxy(SrParam &param) : SrParamProxy(param) {
+    param.type = SQLDataType::Jsonb;
+}
+
+ByteaParamProxy::ByteaParamProxy(SrParam &param) : SrParamProxy(param) {
+    param.type = SQLDataType::Bytea;
+}
+
 } // namespace STNL
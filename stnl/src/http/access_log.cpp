@@ -0,0 +1,121 @@
+#include "stnl/http/access_log.hpp"
+#include "stnl/core/config.hpp"
+#include "stnl/core/logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <format>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace STNL {
+namespace {
+
+// Appends `s` as a JSON string literal.
+void AppendJsonString(std::string &out, std::string_view s) {
+    out += '"';
+    for (char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out += std::format("\\u{:04x}", static_cast<unsigned>(c));
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+constexpr uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ULL;
+
+// splitmix64 output for the state after an increment
+auto Mix(uint64_t z) -> uint64_t {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// per-thread state: sampling must not contend between sessions
+auto NextRandom() -> uint64_t {
+    thread_local uint64_t state = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()) ^
+                                  reinterpret_cast<uintptr_t>(&state);
+    return Mix(state += GOLDEN_GAMMA);
+}
+
+} // namespace
+
+auto AccessRecord::ToJson(std::chrono::system_clock::time_point time) const -> std::string {
+    std::time_t const seconds = std::chrono::system_clock::to_time_t(time);
+    auto const millis = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count() % 1000;
+    std::tm tm{};
+    gmtime_r(&seconds, &tm);
+    char ts[24];
+    std::strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S", &tm);
+
+    std::string out;
+    out.reserve(200 + route.size() + userAgent.size());
+    out += std::format(R"({{"ts":"{}.{:03}Z","method":)", ts, millis);
+    AppendJsonString(out, method);
+    out += ",\"route\":";
+    AppendJsonString(out, route);
+    out += ",\"ua\":";
+    AppendJsonString(out, userAgent);
+    out += std::format(R"(,"status":{},"in":{},"out":{},"parse_us":{},"middleware_us":{},"handler_us":{},"write_us":{},"total_us":{}}})", status, bytesIn,
+                       bytesOut, parse.count(), middleware.count(), handler.count(), write.count(), total.count());
+    return out;
+}
+
+auto AccessLogOptions::FromConfig(std::string const &keyPath) -> AccessLogOptions {
+    AccessLogOptions options;
+    options.sink = LoggerOptions::FromConfig(keyPath);
+    auto enabled = Config::Value<bool>(keyPath + ".enabled");
+    auto sampleRate = Config::Value<double>(keyPath + ".sampleRate");
+    auto slowMs = Config::Value<int64_t>(keyPath + ".slowMs");
+    auto seed = Config::Value<int64_t>(keyPath + ".seed");
+    if (enabled) { options.enabled = *enabled; }
+    if (sampleRate) { options.sampleRate = std::clamp(*sampleRate, 0.0, 1.0); }
+    if (slowMs && *slowMs >= 0) { options.slow = std::chrono::milliseconds(*slowMs); }
+    if (seed) { options.seed = static_cast<uint64_t>(*seed); }
+    return options;
+}
+
+AccessLog::AccessLog(AccessLogOptions options) : options_(std::move(options)), seeded_(options_.seed) {
+    double const rate = std::clamp(options_.sampleRate, 0.0, 1.0);
+    sampleThreshold_ = rate >= 1.0 ? std::numeric_limits<uint64_t>::max() : static_cast<uint64_t>(rate * 18446744073709551616.0);
+    if (!options_.sink.file.empty()) { channel_ = std::make_unique<LogChannel>(options_.sink); }
+}
+
+auto AccessLog::Keep(AccessRecord const &record) const -> bool {
+    if (record.status >= 500) { return true; }
+    if (options_.slow.count() > 0 && record.total >= options_.slow) { return true; }
+    if (sampleThreshold_ == std::numeric_limits<uint64_t>::max()) { return true; }
+    uint64_t const random = options_.seed != 0 ? Mix(seeded_.fetch_add(GOLDEN_GAMMA, std::memory_order_relaxed) + GOLDEN_GAMMA) : NextRandom();
+    return random < sampleThreshold_;
+}
+
+void AccessLog::Write(AccessRecord const &record) {
+    if (!Keep(record)) { return; }
+    std::string line = record.ToJson(std::chrono::system_clock::now());
+    if (channel_) {
+        channel_->Write(line);
+    } else {
+        Logger::Log(line);
+    }
+}
+
+auto AccessLog::Dropped() const -> uint64_t {
+    return channel_ ? channel_->Dropped() : 0;
+}
+
+} // namespace STNL
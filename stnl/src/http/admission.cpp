@@ -0,0 +1,73 @@
+#include "stnl/http/admission.hpp"
+#include "stnl/core/config.hpp"
+
+#include <format>
+#include <string>
+
+namespace STNL {
+
+auto AdmissionOptions::FromConfig(std::string const &keyPath) -> AdmissionOptions {
+    AdmissionOptions options;
+    auto maxConnections = Config::Value<int64_t>(keyPath + ".maxConnections");
+    auto maxInFlight = Config::Value<int64_t>(keyPath + ".maxInFlight");
+    auto retryAfterSeconds = Config::Value<int64_t>(keyPath + ".retryAfterSeconds");
+    if (maxConnections && *maxConnections >= 0) { options.maxConnections = static_cast<size_t>(*maxConnections); }
+    if (maxInFlight && *maxInFlight >= 0) { options.maxInFlight = static_cast<size_t>(*maxInFlight); }
+    if (retryAfterSeconds && *retryAfterSeconds >= 0) { options.retryAfter = std::chrono::seconds(*retryAfterSeconds); }
+    return options;
+}
+
+Admission::Admission(AdmissionOptions const &options) {
+    Reconfigure(options);
+}
+
+void Admission::Reconfigure(AdmissionOptions const &options) {
+    maxConnections_.store(options.maxConnections);
+    maxInFlight_.store(options.maxInFlight);
+    retryAfterSeconds_.store(options.retryAfter.count(), std::memory_order_relaxed);
+}
+
+auto Admission::TryAcquire(std::atomic<size_t> &count, size_t limit) -> bool {
+    /* optimistic increment: under the limit, the common case, this is a single atomic
+     * add; above it the increment is undone, so `count` may overshoot only briefly */
+    size_t const previous = count.fetch_add(1);
+    if (limit == 0 || previous < limit) { return true; }
+    count.fetch_sub(1);
+    return false;
+}
+
+auto Admission::TryOpenConnection() -> bool {
+    return TryAcquire(connections_, maxConnections_.load());
+}
+
+void Admission::CloseConnection() {
+    connections_.fetch_sub(1);
+}
+
+auto Admission::ConnectionsFull() const -> bool {
+    size_t const limit = maxConnections_.load();
+    return limit != 0 && connections_.load() >= limit;
+}
+
+auto Admission::TryBeginRequest() -> bool {
+    return TryAcquire(inFlight_, maxInFlight_.load(std::memory_order_relaxed));
+}
+
+void Admission::EndRequest() {
+    inFlight_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void Admission::RenderPrometheus(std::string &out) const {
+    out += std::format("# HELP stnl_http_connections_max Limit on open client connections, 0 when unlimited.\n"
+                       "# TYPE stnl_http_connections_max gauge\n"
+                       "stnl_http_connections_max {}\n"
+                       "# HELP stnl_http_requests_in_flight Requests being handled or written.\n"
+                       "# TYPE stnl_http_requests_in_flight gauge\n"
+                       "stnl_http_requests_in_flight {}\n"
+                       "# HELP stnl_http_requests_in_flight_max Limit on requests in flight, 0 when unlimited.\n"
+                       "# TYPE stnl_http_requests_in_flight_max gauge\n"
+                       "stnl_http_requests_in_flight_max {}\n",
+                       maxConnections_.load(std::memory_order_relaxed), InFlight(), maxInFlight_.load(std::memory_order_relaxed));
+}
+
+} // namespace STNL
@@ -0,0 +1,78 @@
+#include "stnl/http/http_metrics.hpp"
+
+#include <boost/beast/http.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <string>
+#include <string_view>
+
+namespace STNL {
+namespace {
+
+// Label values are quoted, so backslashes, quotes and newlines must be escaped.
+auto EscapeLabel(std::string_view value) -> std::string {
+    std::string out;
+    out.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+void RouteMetrics::Record(unsigned status, std::chrono::microseconds total) {
+    if (status >= 100 && status < 600) { requests[(status / 100) - 1]->Inc(); }
+    duration->RecordMicros(static_cast<uint64_t>(std::max<int64_t>(0, total.count())));
+}
+
+HttpMetrics::HttpMetrics(Metrics &metrics)
+    : sessionsActive(metrics.AddGauge("stnl_http_sessions_active", "Open client connections.")),
+      accepts(metrics.AddCounter("stnl_http_accepts_total", "Accepted connections.")),
+      acceptErrors(metrics.AddCounter("stnl_http_accept_errors_total", "Failed accepts.")),
+      bytesReceived(metrics.AddCounter("stnl_http_received_bytes_total", "Request bytes read, headers included.")),
+      bytesSent(metrics.AddCounter("stnl_http_sent_bytes_total", "Response bytes written, headers included.")),
+      timeouts(metrics.AddCounter("stnl_http_timeouts_total", "Connections closed because a request was not read in time.")),
+      payloadTooLarge(metrics.AddCounter("stnl_http_payload_too_large_total", "Requests rejected with 413 for exceeding http.maxBodySize.")),
+      connectionsRejected(metrics.AddCounter("stnl_http_connections_rejected_total", "Connections answered with 503 and closed, over the connection limit.")),
+      requestsShed(metrics.AddCounter("stnl_http_requests_shed_total", "Requests answered with 503, over the in-flight limit.")),
+      acceptPauses(metrics.AddCounter("stnl_http_accept_pauses_total", "Times an acceptor stopped accepting at the connection limit.")),
+      metrics_(metrics), unmatched_(Register("*")) {}
+
+void HttpMetrics::AddRoute(Route const &route) {
+    if (routes_.contains(route)) { return; }
+    auto const method = http::to_string(route.first);
+    routes_.emplace(route, Register(std::format("{} {}", std::string_view(method.data(), method.size()), route.second)));
+}
+
+auto HttpMetrics::ForRoute(Route const &route) -> RouteMetrics & {
+    auto it = routes_.find(route);
+    return it == routes_.end() ? unmatched_ : it->second;
+}
+
+auto HttpMetrics::Unmatched() -> RouteMetrics & {
+    return unmatched_;
+}
+
+auto HttpMetrics::Register(std::string const &label) -> RouteMetrics {
+    std::string const route = EscapeLabel(label);
+    RouteMetrics routeMetrics;
+    for (size_t i = 0; i < routeMetrics.requests.size(); ++i) {
+        routeMetrics.requests[i] =
+            &metrics_.AddCounter("stnl_http_requests_total", "Requests served, by route and status class.", std::format(R"(route="{}",status="{}xx")", route, i + 1));
+    }
+    routeMetrics.duration = &metrics_.AddHistogram("stnl_http_request_duration_seconds", "Time from a request being read to its response being sent.",
+                                                   std::format(R"(route="{}")", route));
+    return routeMetrics;
+}
+
+} // namespace STNL
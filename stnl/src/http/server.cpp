@@ -1,7 +1,9 @@
 #include "stnl/http/server.hpp"
+#include "stnl/core/config.hpp"
 #include "stnl/core/logger.hpp"
 #include "stnl/core/stnl_module.hpp"
 #include "stnl/db/db.hpp"
+#include "stnl/db/db_stats.hpp"
 #include "stnl/db/migration.hpp"
 #include "stnl/db/migrator.hpp"
 #include "stnl/http/core.hpp"
@@ -14,11 +16,24 @@
 #include <boost/beast/version.hpp>
 #include <boost/filesystem.hpp>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 
 namespace beast = boost::beast;
@@ -29,14 +44,89 @@ namespace fs = boost::filesystem;
 using tcp = boost::asio::ip::tcp;
 namespace STNL {
 
-Server::Server(asio::io_context &ioc, const tcp::endpoint &endpoint, fs::path rootDirPath)
-    : ioc_(ioc), acceptor_(ioc, endpoint), rootDirPath_(std::move(std::move(rootDirPath))) {} // Fixed: acceptor needs ioc
+namespace {
+
+#ifdef SO_REUSEPORT
+using ReusePort = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+void PinThisThread(size_t cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); rc != 0) {
+        Logger::Wrn() << std::format("Server: could not pin thread to CPU {}: error {}", cpu, rc);
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+} // namespace
+
+auto ListenerOptions::FromConfig(std::string const &keyPath) -> ListenerOptions {
+    ListenerOptions options;
+    auto shards = Config::Value<int64_t>(keyPath + ".shards");
+    auto pinThreads = Config::Value<bool>(keyPath + ".pinThreads");
+    if (shards && *shards > 0) { options.shards = static_cast<size_t>(*shards); }
+    if (shards && *shards < 0) { options.shards = std::max<size_t>(std::thread::hardware_concurrency(), 1); }
+    if (pinThreads) { options.pinThreads = *pinThreads; }
+    return options;
+}
+
+Server::Server(asio::io_context &ioc, const tcp::endpoint &endpoint, fs::path rootDirPath, ListenerOptions listenerOptions)
+    : ioc_(ioc), drainStrand_(asio::make_strand(ioc)), partitionTimer_(drainStrand_), configTimer_(drainStrand_), reloadSignals_(drainStrand_),
+      stopSignals_(drainStrand_), drainTimer_(drainStrand_), acceptor_(drainStrand_), listenerOptions_(listenerOptions),
+      rootDirPath_(std::move(rootDirPath)) {
+#ifndef SO_REUSEPORT
+    if (listenerOptions_.shards > 0) {
+        Logger::Wrn() << "Server: SO_REUSEPORT is not available on this platform, accepting on a single acceptor";
+        listenerOptions_.shards = 0;
+    }
+#endif
+    if (listenerOptions_.shards > 0) {
+        OpenShards(endpoint);
+    } else {
+        acceptor_ = tcp::acceptor(drainStrand_, endpoint);
+        size_t const wheels = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        timerWheels_.reserve(wheels);
+        for (size_t i = 0; i < wheels; ++i) { timerWheels_.push_back(std::make_unique<TimerWheel>(ioc_.get_executor())); }
+    }
+}
+
+Server::~Server() {
+    {
+        // sessions released below must not re-arm an acceptor that is going away
+        std::scoped_lock lock(pausedMutex_);
+        pausedAccepts_.clear();
+        acceptPaused_.store(false);
+    }
+    for (std::unique_ptr<Shard> &shard : shards_) { shard->ioc.stop(); }
+    for (std::unique_ptr<Shard> &shard : shards_) {
+        if (shard->thread.joinable()) { shard->thread.join(); }
+    }
+    // sessions still queued on a shard are released here, while the metrics they update exist
+    shards_.clear();
+}
 
 void Server::AddDatabase(std::string const &keyAlias, std::string const &connectionString, size_t poolSize, size_t numThreads) {
     auto [it, inserted] = databases_.emplace(keyAlias, std::make_shared<DB>(connectionString, ioc_, poolSize, numThreads));
     if (inserted) { databaseKeyAliases_.emplace_back(keyAlias); }
 }
 
+void Server::AddDatabase(std::string const &keyAlias, std::string const &connectionString, PoolOptions const &poolOptions, size_t numThreads) {
+    auto [it, inserted] = databases_.emplace(keyAlias, std::make_shared<DB>(connectionString, ioc_, poolOptions, numThreads));
+    if (inserted) { databaseKeyAliases_.emplace_back(keyAlias); }
+}
+
+void Server::AddDatabase(std::string const &keyAlias, std::string const &primaryConnectionString, std::vector<std::string> const &replicaConnectionStrings,
+                         PoolOptions const &poolOptions, size_t numThreads) {
+    auto [it, inserted] =
+        databases_.emplace(keyAlias, std::make_shared<DB>(primaryConnectionString, replicaConnectionStrings, ioc_, poolOptions, numThreads));
+    if (inserted) { databaseKeyAliases_.emplace_back(keyAlias); }
+}
+
 auto Server::GetDatabase(std::string const &keyAlias) -> std::shared_ptr<DB> {
     auto it = databases_.find(keyAlias);
     if (it == databases_.end()) {
@@ -92,8 +182,19 @@ auto Server::Response(Request const &req, const boost::json::value &data, http::
     return http::message_generator{std::move(res)};
 }
 
+auto Server::ResponseJson(Request const &req, std::string body, http::status status_code) -> http::message_generator {
+    http::response<http::string_body> res{status_code, req.GetHttpReq().version()};
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    res.set(http::field::content_type, "application/json");
+    res.body() = std::move(body);
+    res.prepare_payload();
+    return http::message_generator{std::move(res)};
+}
+
 void Server::AddRoute(http::verb method, std::string path, RouteHandler handler) {
-    router_.emplace(Route{method, std::move(path)}, std::move(handler));
+    Route route{method, std::move(path)};
+    httpMetrics_.AddRoute(route);
+    router_.emplace(std::move(route), std::move(handler));
 }
 
 void Server::Get(std::string path, RouteHandler handler) {
@@ -127,18 +228,123 @@ auto Server::GetRouter() const -> const Router & {
     return router_;
 }
 
+void Server::OpenShards(tcp::endpoint const &endpoint) {
+#ifdef SO_REUSEPORT
+    /* every shard binds the same endpoint; the kernel spreads incoming connections
+     * over the acceptors, so shards share neither a reactor nor an accept queue */
+    shards_.reserve(listenerOptions_.shards);
+    for (size_t i = 0; i < listenerOptions_.shards; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->acceptor.open(endpoint.protocol());
+        shard->acceptor.set_option(asio::socket_base::reuse_address(true));
+        shard->acceptor.set_option(ReusePort(true));
+        shard->acceptor.bind(endpoint);
+        shard->acceptor.listen(asio::socket_base::max_listen_connections);
+        shards_.push_back(std::move(shard));
+    }
+    Logger::Inf() << std::format("Server: accepting on {} SO_REUSEPORT shard(s){}", shards_.size(), listenerOptions_.pinThreads ? ", threads pinned" : "");
+#else
+    (void)endpoint;
+#endif
+}
+
+void Server::StartShards() {
+    size_t const cpus = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        Shard &shard = *shards_[i];
+        shard.timerWheel.Start();
+        DoAccept(shard);
+        shard.thread = std::thread([&shard, i, cpus, pin = listenerOptions_.pinThreads]() {
+            if (pin) { PinThisThread(i % cpus); }
+            shard.ioc.run();
+        });
+    }
+}
+
 void Server::DoAccept() {
     acceptor_.async_accept(asio::make_strand(ioc_), // Fixed: was beast::bind_front_handler in wrong place
-                           beast::bind_front_handler(&Server::OnAccept, this));
+                           [this](beast::error_code ec, tcp::socket socket) {
+                               if (draining_.load()) { return; }
+                               OnAccept(ec, std::move(socket), *timerWheels_[nextTimerWheel_++ % timerWheels_.size()]);
+                               if (!PauseAccept([this]() { asio::post(drainStrand_, [this]() { DoAccept(); }); })) { DoAccept(); }
+                           });
 }
 
-void Server::OnAccept(beast::error_code ec, tcp::socket socket) {
-    if (!ec) {
-        std::make_shared<Session>(std::move(socket), *this)->Run();
-    } else {
+void Server::DoAccept(Shard &shard) {
+    // a shard is run by one thread, its sessions need no strand
+    shard.acceptor.async_accept(shard.ioc, [this, &shard](beast::error_code ec, tcp::socket socket) {
+        if (draining_.load()) { return; }
+        OnAccept(ec, std::move(socket), shard.timerWheel);
+        if (!PauseAccept([this, &shard]() { asio::post(shard.ioc, [this, &shard]() { DoAccept(shard); }); })) { DoAccept(shard); }
+    });
+}
+
+void Server::OnAccept(beast::error_code ec, tcp::socket socket, TimerWheel &timerWheel) {
+    if (ec) {
+        httpMetrics_.acceptErrors.Inc();
         Logger::Err() << "Server::OnAccept: " << ec.message();
+        return;
+    }
+    httpMetrics_.accepts.Inc();
+    if (!admission_.TryOpenConnection()) {
+        /* only reached when several acceptors raced past the limit: answer right away
+         * rather than letting the client wait for a timeout */
+        httpMetrics_.connectionsRejected.Inc();
+        std::string const response = std::format("HTTP/1.1 503 Service Unavailable\r\nRetry-After: {}\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+                                                 admission_.RetryAfter().count());
+        /* best effort on a non-blocking socket: a fresh socket's send buffer takes the few
+         * bytes at once, and a client that does not read must not stall the acceptor */
+        beast::error_code ignored;
+        socket.non_blocking(true, ignored);
+        socket.write_some(asio::buffer(response), ignored);
+        socket.shutdown(tcp::socket::shutdown_both, ignored);
+        socket.close(ignored);
+        return;
+    }
+    std::make_shared<Session>(std::move(socket), *this, timerWheel)->Run();
+}
+
+auto Server::PauseAccept(std::function<void()> resume) -> bool {
+    /* publish the parked loop before checking the limit, ReleaseConnection does the
+     * opposite; one of the two sees the other's update so a pause is never missed */
+    std::scoped_lock lock(pausedMutex_);
+    pausedAccepts_.push_back(std::move(resume));
+    acceptPaused_.store(true);
+    if (admission_.ConnectionsFull()) {
+        httpMetrics_.acceptPauses.Inc();
+        return true;
+    }
+    pausedAccepts_.pop_back();
+    acceptPaused_.store(!pausedAccepts_.empty());
+    return false;
+}
+
+auto Server::ResumeAccept() -> bool {
+    if (!acceptPaused_.load()) { return false; }
+    std::function<void()> resume;
+    {
+        std::scoped_lock lock(pausedMutex_);
+        if (pausedAccepts_.empty() || admission_.ConnectionsFull()) { return false; }
+        resume = std::move(pausedAccepts_.back());
+        pausedAccepts_.pop_back();
+        acceptPaused_.store(!pausedAccepts_.empty());
+    }
+    resume();
+    return true;
+}
+
+void Server::TrackSession(std::shared_ptr<Session> const &session) {
+    std::scoped_lock lock(sessionsMutex_);
+    sessions_.emplace(session.get(), session);
+}
+
+void Server::ReleaseConnection(Session *session) {
+    {
+        std::scoped_lock lock(sessionsMutex_);
+        sessions_.erase(session);
     }
-    DoAccept();
+    admission_.CloseConnection();
+    ResumeAccept();
 }
 
 auto Server::GetRootDirPath() -> fs::path {
@@ -147,7 +353,10 @@ auto Server::GetRootDirPath() -> fs::path {
 
 void Server::SetupModules() {
     for (const std::shared_ptr<STNLModule> &m : modulesVec_) {
-        if (m) { m->Setup(); }
+        if (m) {
+            m->SetupMetrics(metrics_);
+            m->Setup();
+        }
     }
 }
 
@@ -157,18 +366,122 @@ void Server::SetupMiddlewares() {
     }
 }
 
-void Server::RunDatabaseMigrations() {
-    /* call the modules setupMigrations() method before runing the migrations
-     * for each configured database */
+void Server::WarmUpDatabases() {
+    /* open the pools' minIdle connections up front so the first requests after
+     * a deploy do not pay the connection handshake */
+    for (std::string &dbKeyAlias : databaseKeyAliases_) {
+        try {
+            databases_.at(dbKeyAlias)->WarmUp();
+        } catch (std::exception const &e) { Logger::Err() << "Server::WarmUpDatabases: " << std::string(e.what()); }
+    }
+}
+
+void Server::SetupModuleMigrations() {
+    if (moduleMigrationsSetUp_) { return; }
+    moduleMigrationsSetUp_ = true;
     for (const std::shared_ptr<STNLModule> &m : modulesVec_) {
         if (m) { m->SetupMigrations(); }
     }
-    for (std::string &dbKeyAlias : databaseKeyAliases_) {
+}
+
+auto Server::PlanDatabaseMigrations() -> std::string {
+    SetupModuleMigrations();
+    std::string out;
+    for (std::string const &dbKeyAlias : databaseKeyAliases_) {
+        out += std::format("== database '{}' ==\n", dbKeyAlias);
         try {
-            std::shared_ptr<DB> pDB = databases_.at(dbKeyAlias);
-            Migrator::Migrate(*pDB);
-        } catch (std::exception const &e) { Logger::Err() << "Server::RunDatabaseMigrations: " << std::string(e.what()); }
+            out += Migrator::Plan(*databases_.at(dbKeyAlias)).Render();
+        } catch (std::exception const &e) { out += std::format("failed to plan: {}\n", e.what()); }
+        out += '\n';
     }
+    return out;
+}
+
+void Server::RunDatabaseMigrations() {
+    /* call the modules setupMigrations() method before runing the migrations
+     * for each configured database */
+    SetupModuleMigrations();
+    /* databases are independent of each other, migrate them concurrently; each Migrate
+     * blocks on its own DB's thread pool so these run on plain threads, not the ioc */
+    std::vector<std::future<void>> futures;
+    futures.reserve(databaseKeyAliases_.size());
+    for (std::string &dbKeyAlias : databaseKeyAliases_) {
+        std::shared_ptr<DB> pDB = databases_.at(dbKeyAlias);
+        futures.emplace_back(std::async(std::launch::async, [pDB, dbKeyAlias]() {
+            try {
+                Migrator::Migrate(*pDB);
+            } catch (std::exception const &e) { Logger::Err() << "Server::RunDatabaseMigrations: " << dbKeyAlias << ": " << std::string(e.what()); }
+        }));
+    }
+    for (std::future<void> &f : futures) { f.get(); }
+}
+
+void Server::SchedulePartitionMaintenance() {
+    int64_t const intervalMs = Config::Value<int64_t>("database.partitions.maintenanceIntervalMs", int64_t{3600000}).value_or(3600000);
+    if (intervalMs <= 0) { return; }
+    partitionTimer_.expires_after(std::chrono::milliseconds(intervalMs));
+    partitionTimer_.async_wait([this](beast::error_code ec) {
+        if (ec || draining_.load()) { return; }
+        /* maintenance blocks on locks and DDL, so like RunDatabaseMigrations it gets plain threads
+         * of its own instead of the io threads serving requests; a run still busy is not doubled */
+        bool const idle = std::ranges::all_of(partitionMaintenanceRuns_, [](std::future<void> const &f) {
+            return !f.valid() || f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        });
+        if (idle) {
+            partitionMaintenanceRuns_.clear();
+            for (std::string const &dbKeyAlias : databaseKeyAliases_) {
+                std::shared_ptr<DB> pDB = databases_.at(dbKeyAlias);
+                partitionMaintenanceRuns_.push_back(std::async(std::launch::async, [pDB, dbKeyAlias]() {
+                    try {
+                        Migrator::MaintainPartitions(*pDB);
+                    } catch (std::exception const &e) { Logger::Err() << "Server::SchedulePartitionMaintenance: " << dbKeyAlias << ": " << e.what(); }
+                }));
+            }
+        } else {
+            Logger::Wrn() << "Server: Previous partition maintenance still running, skipped this round";
+        }
+        SchedulePartitionMaintenance();
+    });
+}
+
+auto Server::RenderMetrics() -> std::string {
+    std::vector<DBStats::Entry> entries;
+    entries.reserve(databaseKeyAliases_.size());
+    for (std::string const &dbKeyAlias : databaseKeyAliases_) {
+        std::shared_ptr<DB> const &pDB = databases_.at(dbKeyAlias);
+        entries.push_back(DBStats::Entry{.dbAlias = dbKeyAlias, .stats = &pDB->GetStats(), .pools = pDB->GetPoolStats()});
+    }
+    std::string out;
+    DBStats::RenderPrometheus(out, entries);
+    metrics_.RenderPrometheus(out);
+    out += std::format("# HELP stnl_logger_dropped_total Log records dropped because the logger queue was full.\n"
+                       "# TYPE stnl_logger_dropped_total counter\n"
+                       "stnl_logger_dropped_total{{log=\"app\"}} {}\n",
+                       Logger::Dropped());
+    if (accessLog_) { out += std::format("stnl_logger_dropped_total{{log=\"access\"}} {}\n", accessLog_->Dropped()); }
+    admission_.RenderPrometheus(out);
+    return out;
+}
+
+auto Server::GetMetrics() -> Metrics & {
+    return metrics_;
+}
+
+auto Server::GetHttpMetrics() -> HttpMetrics & {
+    return httpMetrics_;
+}
+
+void Server::SetupMetricsRoute() {
+    if (!Config::Value<bool>("metrics.enabled", true).value_or(true)) { return; }
+    std::string route = Config::Value<std::string>("metrics.route", std::string("/metrics")).value_or("/metrics");
+    Get(route, [this](Request const &req) {
+        http::response<http::string_body> res{http::status::ok, req.GetHttpReq().version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "text/plain; version=0.0.4; charset=utf-8");
+        res.body() = RenderMetrics();
+        res.prepare_payload();
+        return http::message_generator{std::move(res)};
+    });
 }
 
 void Server::LaunchModules() {
@@ -184,15 +497,205 @@ void Server::LaunchModules() {
 }
 
 void Server::Run() {
+    WarmUpDatabases();
     RunDatabaseMigrations();
     SetupModules();
     SetupMiddlewares();
+    SetupMetricsRoute();
+    SetupAccessLog();
     LaunchModules();
-    DoAccept();
+    admission_.Reconfigure(AdmissionOptions::FromConfig("http.admission"));
+    int64_t const shutdownTimeoutMs = Config::Value<int64_t>("server.shutdownTimeoutMs", int64_t{30000}).value_or(30000);
+    // the timers, signal sets and acceptor_ are armed on drainStrand_, like everything else touching them
+    asio::post(drainStrand_, [this, timeout = std::chrono::milliseconds(std::max<int64_t>(shutdownTimeoutMs, 0))]() {
+        if (draining_.load()) { return; }
+        SchedulePartitionMaintenance();
+        WatchConfig();
+        stopSignals_.add(SIGINT);
+        stopSignals_.add(SIGTERM);
+        WaitStopSignal(timeout);
+        if (shards_.empty()) {
+            for (std::unique_ptr<TimerWheel> &wheel : timerWheels_) { wheel->Start(); }
+            DoAccept();
+        } else {
+            StartShards();
+        }
+    });
+}
+
+void Server::WatchConfig() {
+    Config::OnChange([](ConfigSnapshot const &snapshot) {
+        auto level = snapshot.Get<std::string>("logger.level");
+        if (level) { Logger::SetLevel(Logger::LevelFromName(*level, Logger::Level())); }
+    });
+    Config::OnChange([this](ConfigSnapshot const & /*snapshot*/) {
+        admission_.Reconfigure(AdmissionOptions::FromConfig("http.admission"));
+        // a raised limit lets the paused acceptors go again
+        while (ResumeAccept()) {}
+    });
+    /* the file's mtime is polled rather than watched with inotify, which keeps this
+     * portable; a reload costs nothing until the file actually changes */
+    int64_t const pollMs = Config::Value<int64_t>("config.reloadPollMs", int64_t{2000}).value_or(2000);
+    if (pollMs > 0) { ScheduleConfigPoll(std::chrono::milliseconds(pollMs)); }
+#ifdef SIGHUP
+    reloadSignals_.add(SIGHUP);
+    WaitReloadSignal();
+#endif
+}
+
+void Server::ScheduleConfigPoll(std::chrono::milliseconds interval) {
+    configTimer_.expires_after(interval);
+    configTimer_.async_wait([this, interval](beast::error_code ec) {
+        if (ec || draining_.load()) { return; }
+        Config::ReloadIfChanged();
+        ScheduleConfigPoll(interval);
+    });
+}
+
+void Server::WaitReloadSignal() {
+    reloadSignals_.async_wait([this](beast::error_code ec, int /*signal*/) {
+        if (ec) { return; }
+        Logger::Inf() << "Server: SIGHUP received, reloading config";
+        Config::Reload();
+        WaitReloadSignal();
+    });
+}
+
+void Server::WaitStopSignal(std::chrono::milliseconds timeout) {
+    stopSignals_.async_wait([this, timeout](beast::error_code ec, int signal) {
+        if (ec) { return; }
+        Logger::Inf() << std::format("Server: signal {} received, {}", signal, draining_.load() ? "closing the remaining connections" : "draining");
+        Stop(timeout);
+        // a second signal forces the drain; FinishDrain cancels the wait
+        WaitStopSignal(timeout);
+    });
+}
+
+void Server::Stop(std::chrono::milliseconds timeout) {
+    auto const deadline = std::chrono::steady_clock::now() + timeout;
+    asio::post(drainStrand_, [this, deadline]() { BeginDrain(deadline); });
+}
+
+auto Server::IsDraining() const -> bool {
+    return draining_.load();
+}
+
+void Server::BeginDrain(std::chrono::steady_clock::time_point deadline) {
+    if (drainFinished_) { return; }
+    if (draining_.exchange(true)) {
+        // stopping again: do not wait for the first deadline
+        drainDeadline_ = std::min(drainDeadline_, std::chrono::steady_clock::now());
+        return;
+    }
+    drainDeadline_ = deadline;
+    Logger::Inf() << std::format("Server: draining {} connection(s), {} request(s) in flight", admission_.Connections(), admission_.InFlight());
+    /* 1. stop accepting; clients now get connection refused and go to another instance */
+    beast::error_code ec;
+    if (acceptor_.is_open()) { acceptor_.close(ec); }
+    for (std::unique_ptr<Shard> &shard : shards_) {
+        asio::post(shard->ioc, [&shard = *shard]() {
+            beast::error_code closeEc;
+            shard.acceptor.close(closeEc);
+        });
+    }
+    {
+        std::scoped_lock lock(pausedMutex_);
+        pausedAccepts_.clear();
+        acceptPaused_.store(false);
+    }
+    partitionTimer_.cancel();
+    configTimer_.cancel();
+    reloadSignals_.cancel(ec);
+    /* 2. close idle keep-alive connections, the others close after their response */
+    DrainSessions(false);
+    PollDrain();
+}
+
+void Server::PollDrain() {
+    static constexpr std::chrono::milliseconds DRAIN_POLL{50};
+    static constexpr std::chrono::seconds FORCED_GRACE{2};
+    size_t const open = admission_.Connections();
+    auto const now = std::chrono::steady_clock::now();
+    if (open == 0) {
+        FinishDrain();
+        return;
+    }
+    if (!drainForced_ && now >= drainDeadline_) {
+        Logger::Wrn() << std::format("Server: shutdown timeout reached, closing {} connection(s)", open);
+        drainForced_ = true;
+        DrainSessions(true);
+    } else if (drainForced_ && now >= drainDeadline_ + FORCED_GRACE) {
+        /* a handler that never returns cannot be interrupted: close the sockets once more and
+         * finish without it. ioc_ is not stopped, its queue runs empty so no handler is left
+         * holding a session (which calls back into this server) when the io_context goes;
+         * the threads running it return once the stuck handler does */
+        Logger::Err() << std::format("Server: {} connection(s) did not close, finishing the drain without them", open);
+        DrainSessions(true);
+        FinishDrain();
+        return;
+    }
+    drainTimer_.expires_after(DRAIN_POLL);
+    drainTimer_.async_wait([this](beast::error_code ec) {
+        if (!ec) { PollDrain(); }
+    });
+}
+
+void Server::FinishDrain() {
+    drainFinished_ = true;
+    beast::error_code ec;
+    stopSignals_.cancel(ec);
+    /* 3. no request is left: stop the modules, then let the databases release the
+     * io_context; queries already queued still run before its threads return */
+    for (const std::shared_ptr<STNLModule> &m : modulesVec_) {
+        if (!m) { continue; }
+        try {
+            m->Stop();
+        } catch (std::exception const &e) { Logger::Err() << "Server::FinishDrain: " << e.what(); }
+    }
+    for (std::string const &dbKeyAlias : databaseKeyAliases_) { databases_.at(dbKeyAlias)->Shutdown(); }
+    for (std::unique_ptr<TimerWheel> &wheel : timerWheels_) { wheel->Stop(); }
+    for (std::unique_ptr<Shard> &shard : shards_) {
+        shard->timerWheel.Stop();
+        shard->ioc.stop();
+    }
+    Logger::Inf() << "Server: stopped";
+}
+
+void Server::DrainSessions(bool force) {
+    std::vector<std::shared_ptr<Session>> sessions;
+    {
+        std::scoped_lock lock(sessionsMutex_);
+        sessions.reserve(sessions_.size());
+        for (auto const &[ptr, weak] : sessions_) {
+            if (std::shared_ptr<Session> session = weak.lock()) { sessions.push_back(std::move(session)); }
+        }
+    }
+    // each session is drained on its own executor, its state is not synchronized otherwise
+    for (std::shared_ptr<Session> &session : sessions) {
+        asio::post(session->GetExecutor(), [session, force]() { session->Drain(force); });
+    }
+}
+
+void Server::SetupAccessLog() {
+    AccessLogOptions options = AccessLogOptions::FromConfig("http.accessLog");
+    if (!options.enabled) { return; }
+    accessLog_ = std::make_unique<AccessLog>(std::move(options));
+}
+
+auto Server::GetAccessLog() -> AccessLog * {
+    return accessLog_.get();
+}
+
+auto Server::GetAdmission() -> Admission & {
+    return admission_;
 }
 
 auto Server::GetIOC() -> asio::io_context & {
     return ioc_;
 }
 
+auto Server::GetShardCount() const -> size_t {
+    return shards_.size();
+}
+
 } // namespace STNL
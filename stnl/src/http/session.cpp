@@ -14,6 +14,7 @@
 #include <boost/filesystem.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <string>
 
@@ -22,36 +23,160 @@ namespace http = beast::http;
 namespace asio = boost::asio;
 namespace fs = boost::filesystem;
 using tcp = boost::asio::ip::tcp;
+using SteadyClock = std::chrono::steady_clock;
 
 namespace STNL {
 
-Session::Session(tcp::socket socket, Server &server) : stream_(std::move(socket)), server_(server), keepAlive_(false) {}
+static auto _MicrosSince(SteadyClock::time_point start, SteadyClock::time_point end = SteadyClock::now()) -> std::chrono::microseconds {
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+}
+
+// Status code of a response from its serialized status line ("HTTP/1.1 200 OK"). The
+// serializer hands out the same header buffers until they are consumed, so this does
+// not disturb the write that follows.
+static auto _PeekStatus(http::message_generator &res) -> unsigned {
+    beast::error_code ec;
+    char line[12];
+    std::size_t const n = asio::buffer_copy(asio::buffer(line), res.prepare(ec));
+    if (ec || n < sizeof(line) || line[8] != ' ') { return 0; }
+    unsigned status = 0;
+    for (std::size_t i = 9; i < sizeof(line); ++i) {
+        if (line[i] < '0' || line[i] > '9') { return 0; }
+        status = (status * 10) + static_cast<unsigned>(line[i] - '0');
+    }
+    return status;
+}
+
+Session::Session(tcp::socket socket, Server &server, TimerWheel &timerWheel)
+    : stream_(std::move(socket)), server_(server), keepAlive_(false), metrics_(server.GetHttpMetrics()), accessLog_(server.GetAccessLog()),
+      admission_(server.GetAdmission()), timerWheel_(timerWheel) {
+    metrics_.sessionsActive.Add();
+}
+
+Session::~Session() {
+    timerWheel_.Cancel(timeout_);
+    EndRequest();
+    metrics_.sessionsActive.Sub();
+    server_.ReleaseConnection(this);
+}
+
+// Per phase timeouts from "http.timeouts", shared by all sessions and updated on reload; 0 disables one.
+struct _Timeouts {
+    ConfigValue<int64_t> idleMs{"http.timeouts.idleMs", 15000};
+    ConfigValue<int64_t> headerMs{"http.timeouts.headerMs", 10000};
+    ConfigValue<int64_t> bodyMs{"http.timeouts.bodyMs", 30000};
+    ConfigValue<int64_t> writeMs{"http.timeouts.writeMs", 30000};
+};
+
+static auto _GetTimeouts() -> _Timeouts const & {
+    static _Timeouts const timeouts;
+    return timeouts;
+}
 
 void Session::Run() {
+    server_.TrackSession(shared_from_this());
+    // the wheel ticks on its own executor; the expiry is handled on the session's
+    timeout_.callback = [weak = weak_from_this(), executor = stream_.get_executor()](uint64_t sequence) {
+        asio::post(executor, [weak, sequence]() {
+            if (std::shared_ptr<Session> self = weak.lock()) { self->OnTimeout(sequence); }
+        });
+    };
     DoRead();
 }
 
+void Session::ArmTimeout(ConfigValue<int64_t> const &timeoutMs) {
+    if (timeoutMs.Get() <= 0) {
+        CancelTimeout();
+        return;
+    }
+    timeoutSequence_ = timerWheel_.Arm(timeout_, std::chrono::milliseconds(timeoutMs.Get()));
+    timeoutArmed_ = true;
+}
+
+void Session::CancelTimeout() {
+    if (!timeoutArmed_) { return; }
+    timeoutArmed_ = false;
+    timerWheel_.Cancel(timeout_);
+}
+
+void Session::OnTimeout(uint64_t sequence) {
+    // a callback for an earlier arming lost the race with a re-arm or cancel
+    if (!timeoutArmed_ || sequence != timeoutSequence_) { return; }
+    timeoutArmed_ = false;
+    metrics_.timeouts.Inc();
+    Close();
+}
+
+void Session::Close() {
+    if (closing_) { return; }
+    closing_ = true;
+    CancelTimeout();
+    // the pending read, wait or write completes with operation_aborted
+    beast::error_code ec;
+    stream_.socket().shutdown(tcp::socket::shutdown_both, ec);
+    stream_.socket().close(ec);
+}
+
+auto Session::GetExecutor() -> asio::any_io_executor {
+    return stream_.get_executor();
+}
+
+void Session::Drain(bool force) {
+    // a request being read, handled or written is let finish; OnWrite then closes
+    if (force || idle_) { Close(); }
+}
+
 void Session::DoRead() {
     // Reset parser for new request
     parser_.emplace();
     
-    // Get body limit from config or use default
-    size_t bodyLimit = DEFAULT_BODY_LIMIT;
-    auto configLimit = Config::Value<int64_t>("http.maxBodySize");
-    if (configLimit.has_value() && configLimit.value() > 0) {
-        bodyLimit = static_cast<size_t>(configLimit.value());
-    }
-    parser_->body_limit(bodyLimit);
-    
-    // Set request timeout
-    stream_.expires_after(REQUEST_TIMEOUT);
+    // Get body limit from config or use default, shared by all sessions and updated on reload
+    static ConfigValue<int64_t> const maxBodySize("http.maxBodySize", static_cast<int64_t>(DEFAULT_BODY_LIMIT));
+    parser_->body_limit(maxBodySize.Get() > 0 ? static_cast<size_t>(maxBodySize.Get()) : DEFAULT_BODY_LIMIT);
     
+    if (server_.IsDraining() && keepAlive_ && buffer_.size() == 0) {
+        Close();
+        return;
+    }
+    if (!keepAlive_ || buffer_.size() > 0) {
+        // a new connection, or a pipelined request already buffered, is held to the header timeout
+        ReadHeader();
+        return;
+    }
+    // keep-alive: wait for the next request without a buffer, under the idle timeout
+    ArmTimeout(_GetTimeouts().idleMs);
+    idle_ = true;
+    stream_.socket().async_wait(tcp::socket::wait_read, beast::bind_front_handler(&Session::OnIdleReady, shared_from_this()));
+}
+
+void Session::OnIdleReady(beast::error_code ec) {
+    idle_ = false;
+    if (ec) {
+        if (!closing_) { Logger::Err() << "Session::OnIdleReady: " << ec.message(); }
+        return;
+    }
+    ReadHeader();
+}
+
+void Session::ReadHeader() {
+    ArmTimeout(_GetTimeouts().headerMs);
+    http::async_read_header(stream_, buffer_, *parser_, beast::bind_front_handler(&Session::OnReadHeader, shared_from_this()));
+}
+
+void Session::OnReadHeader(beast::error_code ec, std::size_t bytes_transferred) {
+    headerBytes_ = bytes_transferred;
+    if (ec) {
+        OnRead(ec, 0);
+        return;
+    }
+    // a header read in time moves the request to the body timeout
+    ArmTimeout(_GetTimeouts().bodyMs);
     http::async_read(stream_, buffer_, *parser_, beast::bind_front_handler(&Session::OnRead, shared_from_this()));
 }
 
-void Session::OnRead(beast::error_code ec, std::size_t /*bytes_transferred*/) {
-    // Cancel timeout
-    beast::get_lowest_layer(stream_).expires_never();
+void Session::OnRead(beast::error_code ec, std::size_t bytes_transferred) {
+    CancelTimeout();
+    bytes_transferred += headerBytes_;
     
     if (ec == http::error::end_of_stream) {
         beast::error_code ec2;
@@ -61,6 +186,9 @@ void Session::OnRead(beast::error_code ec, std::size_t /*bytes_transferred*/) {
     
     if (ec == http::error::body_limit) {
         Logger::Wrn() << "Session::OnRead: Request body too large";
+        metrics_.payloadTooLarge.Inc();
+        BeginExchange(bytes_transferred);
+        access_.status = static_cast<unsigned>(http::status::payload_too_large);
         // Send 413 Payload Too Large
         auto makeResponse = [&]() -> http::message_generator {
             http::response<http::string_body> res{http::status::payload_too_large, 11};
@@ -70,28 +198,48 @@ void Session::OnRead(beast::error_code ec, std::size_t /*bytes_transferred*/) {
             res.prepare_payload();
             return res;
         };
-        beast::async_write(stream_, makeResponse(), beast::bind_front_handler(&Session::OnWrite, shared_from_this()));
+        keepAlive_ = false;
+        DoWrite(makeResponse());
         return;
     }
     
     if (ec) {
-        Logger::Err() << "Session::OnRead: " << ec.message();
+        if (!closing_) { Logger::Err() << "Session::OnRead: " << ec.message(); }
         return;
     }
     
+    if (!admission_.TryBeginRequest()) {
+        Shed();
+        return;
+    }
+    inFlight_ = true;
+    BeginExchange(bytes_transferred);
     Request req = Request::parse(parser_->get());
+    SteadyClock::time_point const handleStart = SteadyClock::now();
     http::message_generator res = HandleRequest(req);
     keepAlive_ = res.keep_alive();
+    writeStart_ = SteadyClock::now();
+    access_.parse = _MicrosSince(readDone_, handleStart);
+    access_.handler = _MicrosSince(handleStart, writeStart_) - access_.middleware;
+    access_.status = _PeekStatus(res);
+    DoWrite(std::move(res));
+}
+
+void Session::DoWrite(http::message_generator res) {
+    ArmTimeout(_GetTimeouts().writeMs);
     beast::async_write(stream_, std::move(res), beast::bind_front_handler(&Session::OnWrite, shared_from_this()));
 }
 
-void Session::OnWrite(beast::error_code ec, std::size_t /*bytes_transferred*/) {
+void Session::OnWrite(beast::error_code ec, std::size_t bytes_transferred) {
+    CancelTimeout();
+    EndExchange(bytes_transferred);
+    EndRequest();
     if (ec) {
-        Logger::Err() << "Session::OnWrite: " << ec.message();
+        if (!closing_) { Logger::Err() << "Session::OnWrite: " << ec.message(); }
         return;
     }
-    if (!keepAlive_) { // Fixed: was "need_eof()" which isn't standard; use
-                       // keep_alive check
+    if (!keepAlive_ || server_.IsDraining()) { // Fixed: was "need_eof()" which isn't standard; use
+                                               // keep_alive check
         beast::error_code ec2;
         stream_.socket().shutdown(tcp::socket::shutdown_send, ec2);
     } else {
@@ -99,6 +247,55 @@ void Session::OnWrite(beast::error_code ec, std::size_t /*bytes_transferred*/) {
     }
 }
 
+void Session::BeginExchange(std::size_t bytesIn) {
+    readDone_ = SteadyClock::now();
+    writeStart_ = readDone_;
+    exchangePending_ = true;
+    routeMetrics_ = &metrics_.Unmatched();
+    metrics_.bytesReceived.Inc(bytesIn);
+    access_ = AccessRecord{};
+    access_.bytesIn = bytesIn;
+    if (accessLog_ == nullptr) { return; }
+    auto const &httpReq = parser_->get();
+    auto const method = http::to_string(httpReq.method());
+    std::string_view const target(httpReq.target().data(), httpReq.target().size());
+    access_.method = std::string_view(method.data(), method.size());
+    access_.route = std::string(target.substr(0, target.find('?')));
+    auto const userAgent = httpReq[http::field::user_agent];
+    access_.userAgent.assign(userAgent.data(), userAgent.size());
+}
+
+void Session::EndExchange(std::size_t bytesOut) {
+    if (!exchangePending_) { return; }
+    exchangePending_ = false;
+    auto const now = SteadyClock::now();
+    access_.bytesOut = bytesOut;
+    access_.write = _MicrosSince(writeStart_, now);
+    access_.total = _MicrosSince(readDone_, now);
+    metrics_.bytesSent.Inc(bytesOut);
+    routeMetrics_->Record(access_.status, access_.total);
+    if (accessLog_ != nullptr) { accessLog_->Write(access_); }
+}
+
+void Session::Shed() {
+    // not timed nor access logged: under overload these are many and must stay cheap
+    metrics_.requestsShed.Inc();
+    auto const &httpReq = parser_->get();
+    http::response<http::empty_body> res{http::status::service_unavailable, httpReq.version()};
+    res.set(http::field::server, "STNL");
+    res.set(http::field::retry_after, std::to_string(admission_.RetryAfter().count()));
+    res.keep_alive(httpReq.keep_alive());
+    res.prepare_payload();
+    keepAlive_ = res.keep_alive();
+    DoWrite(http::message_generator{std::move(res)});
+}
+
+void Session::EndRequest() {
+    if (!inFlight_) { return; }
+    inFlight_ = false;
+    admission_.EndRequest();
+}
+
 auto Session::ApplyMiddlewares(Request &req) -> boost::optional<http::message_generator> {
     for (const std::unique_ptr<Middleware> &mdw : server_.GetMiddlewares()) {
         boost::optional<http::message_generator> result = mdw->invoke(req);
@@ -162,7 +359,7 @@ static auto _GetFileMimeType(fs::path const& filePath) -> std::string {
         return it->second;
     }
     
-    Logger::Dbg() << "GetFileMimeType: Unknown extension: " << ext;
+    STNL_LOG_DBG("GetFileMimeType: Unknown extension: {}", ext);
     return "application/octet-stream";
 }
 
@@ -178,7 +375,9 @@ static bool _IsLexicalSubpath(const fs::path& base_path, const fs::path& child_p
 
 auto Session::HandleRequest(Request &req) -> http::message_generator {
     // Run middleware chain FIRST (before route matching)
+    SteadyClock::time_point const middlewareStart = SteadyClock::now();
     boost::optional<http::message_generator> middlewareResult = ApplyMiddlewares(req);
+    access_.middleware = _MicrosSince(middlewareStart);
     if (middlewareResult.has_value()) { 
         return std::move(middlewareResult.value()); 
     }
@@ -191,6 +390,7 @@ auto Session::HandleRequest(Request &req) -> http::message_generator {
     
     Route key{parser_->get().method(), std::string(path)};
     auto it = server_.GetRouter().find(key); 
+    if (it != server_.GetRouter().end()) { routeMetrics_ = &metrics_.ForRoute(key); }
     
     if (it == server_.GetRouter().end()) {
         // Handle API routes
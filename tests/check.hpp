@@ -0,0 +1,16 @@
+// Assertion helper shared by the tests: prints PASS/FAIL for each check and counts the
+// failures, which main turns into its exit code.
+#ifndef STNL_TESTS_CHECK_HPP
+#define STNL_TESTS_CHECK_HPP
+
+#include <iostream>
+#include <string>
+
+inline int failures = 0;
+
+inline void Check(bool condition, std::string const &what) {
+    std::cout << (condition ? "  PASS  " : "  FAIL  ") << what << std::endl;
+    if (!condition) { ++failures; }
+}
+
+#endif // STNL_TESTS_CHECK_HPP
@@ -0,0 +1,75 @@
+// Test the JSON lines access log written by Session
+#include "stnl/http/access_log.hpp"
+#include "check.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static std::vector<bool> Decisions(STNL::AccessLog const &log, STNL::AccessRecord const &record, size_t count) {
+    std::vector<bool> kept;
+    kept.reserve(count);
+    for (size_t i = 0; i < count; ++i) { kept.push_back(log.Keep(record)); }
+    return kept;
+}
+
+int main() {
+    std::cout << "=== Testing AccessLog ===" << std::endl << std::endl;
+
+    // Test 1: one JSON object per record, strings escaped
+    std::cout << "Test 1: AccessRecord::ToJson" << std::endl;
+    STNL::AccessRecord record;
+    record.method = "GET";
+    record.route = "/files/a\"b\\c\n\x01";
+    record.userAgent = "Mozilla/5.0 \"quoted\"\t";
+    record.status = 200;
+    record.bytesIn = 312;
+    record.bytesOut = 1840;
+    record.handler = std::chrono::microseconds(840);
+    record.total = std::chrono::microseconds(890);
+    auto const time = std::chrono::system_clock::time_point{} + std::chrono::seconds(1700000000) + std::chrono::milliseconds(123);
+    std::string const json = record.ToJson(time);
+    Check(json == R"({"ts":"2023-11-14T22:13:20.123Z","method":"GET","route":"/files/a\"b\\c\n\u0001","ua":"Mozilla/5.0 \"quoted\"\t",)"
+                  R"("status":200,"in":312,"out":1840,"parse_us":0,"middleware_us":0,"handler_us":840,"write_us":0,"total_us":890})",
+          "quotes, backslashes and control characters escaped in route and user agent");
+    record.userAgent.clear();
+    Check(record.ToJson(time).find(R"("ua":"",)") != std::string::npos, "a missing user agent is an empty string");
+    std::cout << std::endl;
+
+    // Test 2: errors and slow requests bypass sampling
+    std::cout << "Test 2: Always kept" << std::endl;
+    STNL::AccessLog none(STNL::AccessLogOptions{.enabled = true, .sampleRate = 0.0, .slow = std::chrono::milliseconds(500)});
+    STNL::AccessRecord fast;
+    fast.status = 200;
+    fast.total = std::chrono::milliseconds(10);
+    Check(!none.Keep(fast), "fast 2xx dropped at sample rate 0");
+    STNL::AccessRecord failed = fast;
+    failed.status = 503;
+    Check(none.Keep(failed), "5xx kept at sample rate 0");
+    STNL::AccessRecord slow = fast;
+    slow.total = std::chrono::milliseconds(500);
+    Check(none.Keep(slow), "requests at the slow threshold kept");
+    STNL::AccessLog all(STNL::AccessLogOptions{.enabled = true});
+    Check(all.Keep(fast), "everything kept at sample rate 1");
+    std::cout << std::endl;
+
+    // Test 3: sampling follows the rate, reproducibly for a fixed seed
+    std::cout << "Test 3: Sampling" << std::endl;
+    constexpr size_t SAMPLES = 20000;
+    STNL::AccessLogOptions options{.enabled = true, .sampleRate = 0.25};
+    options.seed = 42;
+    STNL::AccessLog first(options);
+    STNL::AccessLog second(options);
+    std::vector<bool> const kept = Decisions(first, fast, SAMPLES);
+    size_t const count = static_cast<size_t>(std::count(kept.begin(), kept.end(), true));
+    Check(count > SAMPLES * 23 / 100 && count < SAMPLES * 27 / 100, "about a quarter kept (" + std::to_string(count) + ")");
+    Check(Decisions(second, fast, SAMPLES) == kept, "the same seed keeps the same requests");
+    options.seed = 43;
+    STNL::AccessLog other(options);
+    Check(Decisions(other, fast, SAMPLES) != kept, "another seed keeps others");
+    std::cout << std::endl;
+
+    std::cout << (failures == 0 ? "All access log tests passed" : "Access log tests failed") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+// Test the connection and in-flight limits applied by Server and Session
+#include "stnl/http/admission.hpp"
+#include "check.hpp"
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main() {
+    std::cout << "=== Testing Admission ===" << std::endl << std::endl;
+
+    // Test 1: limits are enforced and released
+    std::cout << "Test 1: Connection and in-flight limits" << std::endl;
+    STNL::Admission admission(STNL::AdmissionOptions{.maxConnections = 2, .maxInFlight = 1, .retryAfter = std::chrono::seconds(3)});
+    Check(admission.TryOpenConnection() && admission.TryOpenConnection(), "connections up to the limit are admitted");
+    Check(admission.ConnectionsFull(), "full at the limit");
+    Check(!admission.TryOpenConnection() && admission.Connections() == 2, "over the limit is refused and not counted");
+    admission.CloseConnection();
+    Check(!admission.ConnectionsFull() && admission.TryOpenConnection(), "a closed connection frees its slot");
+    Check(admission.TryBeginRequest() && !admission.TryBeginRequest(), "in-flight limit");
+    admission.EndRequest();
+    Check(admission.InFlight() == 0 && admission.RetryAfter().count() == 3, "in-flight released, Retry-After kept");
+    std::cout << std::endl;
+
+    // Test 2: reconfiguring while serving, 0 means unlimited
+    std::cout << "Test 2: Reconfigure" << std::endl;
+    admission.Reconfigure(STNL::AdmissionOptions{});
+    Check(!admission.ConnectionsFull() && admission.TryOpenConnection() && admission.Connections() == 3, "unlimited connections");
+    admission.Reconfigure(STNL::AdmissionOptions{.maxConnections = 1});
+    Check(admission.ConnectionsFull() && !admission.TryOpenConnection(), "lowered limit applies to new connections only");
+    std::cout << std::endl;
+
+    // Test 3: concurrent acquires never exceed the limit
+    std::cout << "Test 3: Concurrent requests" << std::endl;
+    STNL::Admission shared(STNL::AdmissionOptions{.maxInFlight = 4});
+    std::atomic<size_t> peak{0};
+    std::atomic<size_t> admitted{0};
+    std::atomic<size_t> current{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 20000; ++i) {
+                if (!shared.TryBeginRequest()) { continue; }
+                size_t const now = current.fetch_add(1) + 1;
+                size_t seen = peak.load();
+                while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+                admitted.fetch_add(1);
+                current.fetch_sub(1);
+                shared.EndRequest();
+            }
+        });
+    }
+    for (std::thread &t : threads) { t.join(); }
+    Check(peak.load() <= 4, "never more than maxInFlight admitted at once");
+    Check(admitted.load() > 0 && shared.InFlight() == 0, "every admitted request released");
+    std::cout << std::endl;
+
+    // Test 4: Prometheus rendering
+    std::cout << "Test 4: Prometheus text" << std::endl;
+    std::string out;
+    shared.RenderPrometheus(out);
+    Check(out.find("stnl_http_requests_in_flight 0\n") != std::string::npos, "in-flight gauge line");
+    Check(out.find("stnl_http_requests_in_flight_max 4\n") != std::string::npos, "in-flight limit line");
+    std::cout << std::endl;
+
+    std::cout << (failures == 0 ? "All admission tests passed" : "Admission tests failed") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+// Test config snapshots, ConfigValue and reloading the config file
+#include "stnl/core/config.hpp"
+#include "check.hpp"
+#include <boost/dll.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/json.hpp>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace fs = boost::filesystem;
+
+static void WriteFile(fs::path const &path, std::string const &content) {
+    std::ofstream out(path.string(), std::ios::trunc);
+    out << content;
+}
+
+int main() {
+    std::cout << "=== Testing Config ===" << std::endl << std::endl;
+
+    // Test 1: key paths of a snapshot
+    std::cout << "Test 1: ConfigSnapshot::Find" << std::endl;
+    STNL::ConfigSnapshot const snapshot(boost::json::parse(R"({"database": {"pool": {"maxSize": 8}, "name": "app"}, "flat": true})"));
+    boost::json::value const *maxSize = snapshot.Find("database.pool.maxSize");
+    Check(maxSize != nullptr && maxSize->is_int64() && maxSize->as_int64() == 8, "nested key path");
+    Check(snapshot.Find("database.pool") != nullptr && snapshot.Find("database.pool")->is_object(), "intermediate objects are indexed too");
+    Check(snapshot.Get<std::string>("database.name").value_or("") == "app" && snapshot.Get<bool>("flat").value_or(false), "typed lookups");
+    Check(snapshot.Find("database.user") == nullptr && snapshot.Find("database.pool.maxSize.x") == nullptr, "missing keys");
+    Check(snapshot.Find("") == nullptr && snapshot.Find("pool.maxSize") == nullptr, "empty and partial key paths");
+    Check(!snapshot.Get<int64_t>("database.name"), "a value that does not convert is none");
+    std::cout << std::endl;
+
+    // Config loads config.local.json from the directory of the executable on first use
+    fs::path const configPath = boost::dll::program_location().parent_path() / "config.local.json";
+    WriteFile(configPath, R"({"test": {"limit": 10}})");
+
+    // Test 2: ConfigValue follows the published generation
+    std::cout << "Test 2: ConfigValue" << std::endl;
+    STNL::ConfigValue<int64_t> const limit("test.limit", 0);
+    STNL::ConfigValue<int64_t> const missing("test.missing", 7);
+    Check(limit.Get() == 10 && missing.Get() == 7, "initial value and default");
+    uint64_t const generation = STNL::Config::Generation();
+    WriteFile(configPath, R"({"test": {"limit": 20}})");
+    Check(limit.Get() == 10 && STNL::Config::Generation() == generation, "a changed file is not seen before a reload");
+    Check(STNL::Config::Reload() && STNL::Config::Generation() == generation + 1, "reload publishes a new generation");
+    Check(limit.Get() == 20 && missing.Get() == 7, "refreshed after the generation bump");
+    std::cout << std::endl;
+
+    // Test 3: ReloadIfChanged compares modification time and size
+    std::cout << "Test 3: ReloadIfChanged" << std::endl;
+    Check(!STNL::Config::ReloadIfChanged(), "unchanged file is not reloaded");
+    WriteFile(configPath, R"({"test": {"limit": 300}})");
+    Check(STNL::Config::ReloadIfChanged() && limit.Get() == 300, "a size change reloads");
+    WriteFile(configPath, R"({"test": {"limit": 400}})");
+    fs::last_write_time(configPath, fs::last_write_time(configPath) + 10);
+    Check(STNL::Config::ReloadIfChanged() && limit.Get() == 400, "a modification time change reloads");
+    std::cout << std::endl;
+
+    // Test 4: a file that does not parse keeps the current snapshot
+    std::cout << "Test 4: Failed reload" << std::endl;
+    std::shared_ptr<STNL::ConfigSnapshot const> const before = STNL::Config::Snapshot();
+    uint64_t const generationBefore = STNL::Config::Generation();
+    WriteFile(configPath, R"({"test": {"limit": )");
+    Check(!STNL::Config::Reload(), "reload fails");
+    Check(STNL::Config::Snapshot() == before && STNL::Config::Generation() == generationBefore, "snapshot and generation kept");
+    Check(limit.Get() == 400 && STNL::Config::Value<int64_t>("test.limit", 0).value_or(0) == 400, "values kept");
+    std::cout << std::endl;
+
+    // Test 5: change handlers
+    std::cout << "Test 5: OnChange and Unsubscribe" << std::endl;
+    WriteFile(configPath, R"({"test": {"limit": 500}})");
+    int calls = 0;
+    int64_t seen = 0;
+    size_t const id = STNL::Config::OnChange([&calls, &seen](STNL::ConfigSnapshot const &changed) {
+        ++calls;
+        seen = changed.Get<int64_t>("test.limit").value_or(0);
+    });
+    STNL::Config::Reload();
+    Check(calls == 1 && seen == 500, "called with the new snapshot");
+    STNL::Config::Unsubscribe(id);
+    STNL::Config::Reload();
+    Check(calls == 1, "not called after Unsubscribe");
+    std::cout << std::endl;
+
+    fs::remove(configPath);
+    std::cout << (failures == 0 ? "All config tests passed" : "Config tests failed") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
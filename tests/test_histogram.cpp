@@ -0,0 +1,50 @@
+// Test the latency histogram used by the database metrics
+#include "stnl/core/histogram.hpp"
+#include "check.hpp"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+int main() {
+    std::cout << "=== Testing LatencyHistogram ===" << std::endl << std::endl;
+
+    // Test 1: bucket boundaries are contiguous and monotonic
+    std::cout << "Test 1: Bucket layout" << std::endl;
+    bool contiguous = true;
+    for (uint64_t v = 0; v < (uint64_t{1} << 20); ++v) {
+        size_t const i = STNL::LatencyHistogram::BucketIndex(v);
+        uint64_t const upper = STNL::LatencyHistogram::BucketUpperBound(i);
+        uint64_t const lower = i == 0 ? 0 : STNL::LatencyHistogram::BucketUpperBound(i - 1);
+        if (v < lower || v >= upper) {
+            contiguous = false;
+            break;
+        }
+    }
+    Check(contiguous, "every value falls into [lower, upper) of its bucket");
+    Check(STNL::LatencyHistogram::BucketIndex(~uint64_t{0}) == STNL::LatencyHistogram::BUCKET_COUNT - 1, "huge values land in the last bucket");
+    std::cout << std::endl;
+
+    // Test 2: percentiles stay within the sub-bucket error
+    std::cout << "Test 2: Percentiles" << std::endl;
+    STNL::LatencyHistogram histogram;
+    for (int i = 1; i <= 1000; ++i) { histogram.Record(std::chrono::microseconds(i)); }
+    Check(histogram.Count() == 1000, "count is 1000");
+    Check(histogram.SumMicros() == 500500, "sum is 500500us");
+    auto p50 = histogram.Percentile(0.5).count();
+    auto p99 = histogram.Percentile(0.99).count();
+    Check(p50 >= 500 && p50 <= 500 * 9 / 8 + 1, "p50 ~ 500us (" + std::to_string(p50) + ")");
+    Check(p99 >= 990 && p99 <= 990 * 9 / 8 + 1, "p99 ~ 990us (" + std::to_string(p99) + ")");
+    std::cout << std::endl;
+
+    // Test 3: Prometheus rendering
+    std::cout << "Test 3: Prometheus text" << std::endl;
+    std::string out;
+    histogram.RenderPrometheus(out, "stnl_test_seconds", "db=\"default\"");
+    std::cout << out;
+    Check(out.find("stnl_test_seconds_bucket{db=\"default\",le=\"+Inf\"} 1000") != std::string::npos, "+Inf bucket holds every sample");
+    Check(out.find("stnl_test_seconds_count{db=\"default\"} 1000") != std::string::npos, "count line present");
+    std::cout << std::endl;
+
+    std::cout << (failures == 0 ? "All histogram tests passed" : "Histogram tests failed") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
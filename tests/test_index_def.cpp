@@ -0,0 +1,82 @@
+// Test the index definitions the migrator diffs against pg_index
+#include "stnl/db/index_def.hpp"
+#include "check.hpp"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+int main() {
+    std::cout << "=== Testing IndexDef ===" << std::endl << std::endl;
+
+    // Test 1: derived names
+    std::cout << "Test 1: Names" << std::endl;
+    STNL::IndexDef composite;
+    composite.columns = {"customer_id", "lower(email)"};
+    Check(composite.ResolvedName("Orders") == "orders_customer_id_lower_email_idx", "composite and expression keys");
+    composite.unique = true;
+    Check(composite.ResolvedName("orders") == "orders_customer_id_lower_email_key", "unique indexes end in _key");
+    STNL::IndexDef wide;
+    wide.columns = {"a_really_long_column_name", "another_really_long_column_name", "and_one_more"};
+    std::string const wideName = wide.ResolvedName("some_table");
+    Check(wideName.size() == 63, "long names are cut to 63 bytes");
+    wide.columns.back() = "and_one_other";
+    Check(wide.ResolvedName("some_table") != wideName, "cut names keep a hash of the full name");
+    std::cout << std::endl;
+
+    // Test 2: SQL
+    std::cout << "Test 2: SQL" << std::endl;
+    STNL::IndexDef covering;
+    covering.columns = {"customer_id", "created_at"};
+    covering.include = {"total"};
+    covering.where = "deleted_at IS NULL";
+    Check(covering.CreateSQL("orders", "orders_cov", true) ==
+              "CREATE INDEX CONCURRENTLY orders_cov ON orders USING btree (customer_id, created_at) INCLUDE (total) WHERE deleted_at IS NULL",
+          "covering partial index");
+    STNL::IndexDef brin;
+    brin.columns = {"created_at"};
+    brin.method = STNL::IndexMethod::Brin;
+    Check(brin.CreateSQL("events", "events_created_at_idx", false) == "CREATE INDEX events_created_at_idx ON events USING brin (created_at)", "brin index");
+    std::cout << std::endl;
+
+    // Test 3: validation
+    std::cout << "Test 3: Validation" << std::endl;
+    auto throws = [](STNL::IndexDef const &index) {
+        try {
+            index.Validate();
+        } catch (std::invalid_argument const &) { return true; }
+        return false;
+    };
+    STNL::IndexDef uniqueGin;
+    uniqueGin.columns = {"tags"};
+    uniqueGin.method = STNL::IndexMethod::Gin;
+    uniqueGin.unique = true;
+    Check(throws(uniqueGin), "unique gin is rejected");
+    brin.include = {"id"};
+    Check(throws(brin), "INCLUDE on brin is rejected");
+    Check(!throws(covering), "covering btree is accepted");
+    std::cout << std::endl;
+
+    // Test 4: matching introspected indexes
+    std::cout << "Test 4: Matching" << std::endl;
+    STNL::IndexDef plain;
+    plain.columns = {"Email"};
+    STNL::IndexDef legacy;
+    legacy.columns = {"\"email\""};
+    Check(plain.Matches(legacy), "unfingerprinted plain index compares structurally");
+    legacy.unique = true;
+    Check(!plain.Matches(legacy), "uniqueness differs");
+    STNL::IndexDef built = covering;
+    built.where = "(deleted_at IS NULL)"; // as pg_get_expr renders it
+    built.fingerprint = covering.Fingerprint();
+    Check(covering.Matches(built), "fingerprinted index matches its definition");
+    STNL::IndexDef changed = covering;
+    changed.include = {"total", "status"};
+    Check(!changed.Matches(built), "changed INCLUDE list does not match");
+    built.valid = false;
+    Check(!covering.Matches(built), "invalid index never matches");
+    Check(covering.References("CREATED_AT") && covering.References("total") && !covering.References("status"), "References keys and INCLUDE columns");
+    std::cout << std::endl;
+
+    std::cout << (failures == 0 ? "All index definition tests passed" : "Index definition tests failed") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -1,11 +1,20 @@
 // Test multi-line logging functionality
 #include "stnl/core/logger.hpp"
-#include <boost/asio.hpp>
+#include "check.hpp"
+
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <string>
 
 int main() {
-    boost::asio::io_context ioc;
-    STNL::Logger::Init(ioc);
+    // records go to a file so Test 6 can check what the logger thread wrote
+    std::string const logFile = "test_logger.log";
+    std::remove(logFile.c_str());
+    STNL::LoggerOptions options;
+    options.file = logFile;
+    STNL::Logger::Start(options);
     
     std::cout << "=== Testing Logger Multi-line Support ===" << std::endl << std::endl;
     
@@ -50,6 +59,33 @@ ORDER BY users.created_at DESC)";
     STNL::Logger::Wrn() << "Connection pool size is low: 2/10 connections available";
     std::cout << std::endl;
     
-    std::cout << "=== All tests completed! ===" << std::endl;
-    return 0;
+    // Test 6: Formatted on the logger thread, debug filtered at runtime
+    std::cout << "Test 6: Deferred formatting and level filtering" << std::endl;
+    STNL_LOG_INF("Pool {}: {}/{} connections in use", "primary", 6, 8);
+    {
+        // the caller's buffer is reused before the logger thread formats the record
+        std::string replica = "replica-1";
+        STNL_LOG_WRN("Pool {} lagging by {:.1f}s", replica, 2.5);
+        replica.assign("overwritten");
+    }
+    STNL::Logger::SetLevel(STNL::LogLevel::Info);
+    STNL_LOG_DBG("This debug record is filtered out: {}", 42);
+    STNL::Logger::Dbg() << "This debug stream is filtered out too";
+
+    STNL::Logger::Stop();
+    std::ifstream in(logFile);
+    std::stringstream written;
+    written << in.rdbuf();
+    std::string const log = written.str();
+    std::cout << log << std::endl;
+    Check(!STNL::Logger::Enabled(STNL::LogLevel::Debug) && STNL::Logger::Enabled(STNL::LogLevel::Info), "runtime level Info disables Debug only");
+    Check(log.find("INF   Pool primary: 6/8 connections in use") != std::string::npos, "deferred arguments rendered by the logger thread");
+    Check(log.find("WRN   Pool replica-1 lagging by 2.5s") != std::string::npos, "string arguments copied when the record is queued");
+    Check(log.find("overwritten") == std::string::npos, "later changes to the caller's buffer not logged");
+    Check(log.find("filtered out") == std::string::npos, "records below the runtime level dropped");
+    Check(log.find("Server started successfully on port 3777") != std::string::npos, "stream records written before Stop returns");
+    std::remove(logFile.c_str());
+
+    std::cout << (failures == 0 ? "=== All tests completed! ===" : "=== Some tests FAILED ===") << std::endl;
+    return failures == 0 ? 0 : 1;
 }
@@ -0,0 +1,66 @@
+// Test the sharded metrics registry behind the `/metrics` endpoint
+#include "stnl/core/metrics.hpp"
+#include "check.hpp"
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main() {
+    std::cout << "=== Testing Metrics ===" << std::endl << std::endl;
+
+    // Test 1: shards add up across threads
+    std::cout << "Test 1: Sharded counters and gauges" << std::endl;
+    STNL::Metrics metrics;
+    STNL::Counter &requests = metrics.AddCounter("stnl_test_requests_total", "Requests.", "route=\"/a\"");
+    STNL::Gauge &active = metrics.AddGauge("stnl_test_active", "Active.");
+    STNL::Histogram &latency = metrics.AddHistogram("stnl_test_latency_seconds", "Latency.");
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 10000; ++i) {
+                requests.Inc();
+                active.Add();
+                latency.RecordMicros(100);
+            }
+            active.Sub(10000);
+        });
+    }
+    for (std::thread &t : threads) { t.join(); }
+    Check(requests.Value() == 80000, "counter sums every shard");
+    Check(active.Value() == 0, "gauge adds and subtracts across shards");
+    active.Set(5);
+    Check(active.Value() == 5, "gauge set");
+    STNL::LatencyHistogram merged;
+    latency.Snapshot(merged);
+    Check(merged.Count() == 80000 && merged.SumMicros() == 8000000, "histogram shards merge");
+    std::cout << std::endl;
+
+    // Test 2: registration returns the same metric and checks types
+    std::cout << "Test 2: Registration" << std::endl;
+    Check(&metrics.AddCounter("stnl_test_requests_total", "Requests.", "route=\"/a\"") == &requests, "same name and labels, same counter");
+    Check(&metrics.AddCounter("stnl_test_requests_total", "Requests.", "route=\"/b\"") != &requests, "other labels, other counter");
+    bool threw = false;
+    try {
+        metrics.AddGauge("stnl_test_requests_total", "Requests.");
+    } catch (std::invalid_argument const &) { threw = true; }
+    Check(threw, "registering a name with another type throws");
+    std::cout << std::endl;
+
+    // Test 3: Prometheus rendering
+    std::cout << "Test 3: Prometheus text" << std::endl;
+    std::string out;
+    metrics.RenderPrometheus(out);
+    std::cout << out.substr(0, out.find("stnl_test_latency_seconds_bucket")) << "..." << std::endl;
+    Check(out.find("# TYPE stnl_test_requests_total counter\n") != std::string::npos, "one TYPE line per family");
+    Check(out.find("stnl_test_requests_total{route=\"/a\"} 80000\n") != std::string::npos, "labelled counter line");
+    Check(out.find("stnl_test_requests_total{route=\"/b\"} 0\n") != std::string::npos, "second series of the family");
+    Check(out.find("stnl_test_active 5\n") != std::string::npos, "unlabelled gauge line");
+    Check(out.find("stnl_test_latency_seconds_count{} 80000\n") != std::string::npos, "histogram count line");
+    std::cout << std::endl;
+
+    std::cout << (failures == 0 ? "All metrics tests passed" : "Metrics tests failed") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+// Test the partition definitions behind rolling range partitions
+#include "stnl/db/partition_def.hpp"
+#include "check.hpp"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+int main() {
+    using namespace std::chrono;
+    std::cout << "=== Testing PartitionDef ===" << std::endl << std::endl;
+
+    // Test 1: periods
+    std::cout << "Test 1: Periods" << std::endl;
+    sys_days const day{2026y / October / 15}; // a Thursday
+    Check(STNL::PartitionDef::PeriodStart(day, STNL::PartitionInterval::Day) == day, "a day starts on itself");
+    Check(STNL::PartitionDef::PeriodStart(day, STNL::PartitionInterval::Week) == sys_days{2026y / October / 12}, "weeks start on Monday");
+    Check(STNL::PartitionDef::PeriodStart(day, STNL::PartitionInterval::Month) == sys_days{2026y / October / 1}, "months start on the 1st");
+    Check(STNL::PartitionDef::PeriodStart(day, STNL::PartitionInterval::Year) == sys_days{2026y / January / 1}, "years start on January 1st");
+    Check(STNL::PartitionDef::NextPeriod(sys_days{2026y / December / 1}, STNL::PartitionInterval::Month) == sys_days{2027y / January / 1},
+          "the month after December is next January");
+    Check(STNL::PartitionDef::NextPeriod(sys_days{2024y / February / 28}, STNL::PartitionInterval::Day) == sys_days{2024y / February / 29}, "leap day");
+    std::cout << std::endl;
+
+    // Test 2: rolling partition names
+    std::cout << "Test 2: Names" << std::endl;
+    std::string const name = STNL::PartitionDef::RollingName("Events", sys_days{2026y / October / 1});
+    Check(name == "events_p20261001", "named after the first day of the period");
+    auto parsed = STNL::PartitionDef::ParseRollingName("events", name);
+    Check(parsed && *parsed == sys_days{2026y / October / 1}, "names parse back");
+    Check(!STNL::PartitionDef::ParseRollingName("events", "events_eu"), "static partitions are not rolling");
+    Check(!STNL::PartitionDef::ParseRollingName("events", "events_p20261340"), "invalid dates are ignored");
+    Check(!STNL::PartitionDef::ParseRollingName("event", "events_p20261001"), "other tables' partitions are ignored");
+    std::cout << std::endl;
+
+    // Test 3: SQL
+    std::cout << "Test 3: SQL" << std::endl;
+    STNL::PartitionDef list;
+    list.strategy = STNL::PartitionStrategy::List;
+    list.columns = {"region"};
+    STNL::PartitionProxy(list).Values("eu", {"'de'", "'fr'"}).Default();
+    Check(list.ClauseSQL() == "PARTITION BY LIST (region)", "list clause");
+    auto listPartitions = list.StaticPartitions();
+    Check(listPartitions.size() == 2 && listPartitions[0].boundSQL == "IN ('de', 'fr')" && listPartitions[1].boundSQL == "DEFAULT", "list partitions");
+    STNL::PartitionDef hash;
+    hash.strategy = STNL::PartitionStrategy::Hash;
+    hash.columns = {"tenant_id"};
+    STNL::PartitionProxy(hash).Modulus(4);
+    auto hashPartitions = hash.StaticPartitions();
+    Check(hashPartitions.size() == 4 && hashPartitions[3].suffix == "h3" && hashPartitions[3].boundSQL == "WITH (MODULUS 4, REMAINDER 3)",
+          "hash partitions");
+    std::cout << std::endl;
+
+    std::cout << (failures == 0 ? "All partition definition tests passed" : "Partition definition tests failed") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,62 @@
+// Test the conversion of PostgreSQL text format values to JSON behind DB::RowToJson
+#include "stnl/core/utils.hpp"
+#include "stnl/db/pg_json.hpp"
+#include "check.hpp"
+#include <boost/json.hpp>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+static std::string Json(boost::json::value const &value) {
+    return boost::json::serialize(value);
+}
+
+static std::string ArrayJson(std::string_view text, std::string_view elemTypname) {
+    size_t pos = text.find('{');
+    std::string json = boost::json::serialize(STNL::PgArrayToJson(text, pos, elemTypname));
+    // the whole literal has to be consumed
+    return pos == text.size() ? json : "stopped at " + std::to_string(pos);
+}
+
+int main() {
+    std::cout << "=== Testing PgTextToJson / PgArrayToJson ===" << std::endl << std::endl;
+
+    // Test 1: base64
+    std::cout << "Test 1: Base64Encode" << std::endl;
+    Check(STNL::Utils::Base64Encode("").empty(), "empty input");
+    Check(STNL::Utils::Base64Encode("f") == "Zg==" && STNL::Utils::Base64Encode("fo") == "Zm8=", "one and two padding characters");
+    Check(STNL::Utils::Base64Encode("foobar") == "Zm9vYmFy", "no padding on whole groups");
+    Check(STNL::Utils::Base64Encode(std::string_view("\xff\x00\x10", 3)) == "/wAQ", "binary bytes, including NUL");
+    std::cout << std::endl;
+
+    // Test 2: scalars
+    std::cout << "Test 2: Scalars" << std::endl;
+    boost::json::value const int8 = STNL::PgTextToJson("-9000000000", "int8");
+    Check(int8.is_int64() && int8.as_int64() == -9000000000LL, "int8 becomes a number");
+    Check(Json(STNL::PgTextToJson("12abc", "int4")) == R"("12abc")", "malformed integers stay strings");
+    boost::json::value const float8 = STNL::PgTextToJson("1.5", "float8");
+    Check(float8.is_double() && float8.as_double() == 1.5, "float8 becomes a number");
+    Check(Json(STNL::PgTextToJson("NaN", "numeric")) == R"("NaN")", "NaN has no JSON number and stays a string");
+    Check(Json(STNL::PgTextToJson("t", "bool")) == "true" && Json(STNL::PgTextToJson("f", "bool")) == "false", "booleans");
+    boost::json::value const jsonb = STNL::PgTextToJson(R"({"a": [1, null]})", "jsonb");
+    Check(jsonb.is_object() && Json(jsonb) == R"({"a":[1,null]})", "jsonb is embedded, not quoted");
+    Check(Json(STNL::PgTextToJson("{broken", "json")) == R"("{broken")", "invalid json stays a string");
+    Check(Json(STNL::PgTextToJson("\\x0001ff", "bytea")) == R"("AAH/")", "hex bytea becomes base64");
+    Check(Json(STNL::PgTextToJson("2026-10-19 12:34:56.5+02", "timestamptz")) == R"("2026-10-19T12:34:56.5+02:00")", "timestamptz to ISO 8601");
+    Check(Json(STNL::PgTextToJson("infinity", "timestamptz")) == R"("infinity")", "infinity is kept");
+    Check(Json(STNL::PgTextToJson("hello", "text")) == R"("hello")", "other types stay strings");
+    std::cout << std::endl;
+
+    // Test 3: arrays
+    std::cout << "Test 3: Arrays" << std::endl;
+    Check(ArrayJson("{1,2,NULL}", "int4") == "[1,2,null]", "NULL elements become null");
+    Check(ArrayJson(R"({"a b","c\"d",NULL,"NULL"})", "text") == R"(["a b","c\"d",null,"NULL"])", "quoted elements are unescaped, a quoted NULL is text");
+    Check(ArrayJson("{{1,2},{3,4}}", "int8") == "[[1,2],[3,4]]", "nested dimensions");
+    Check(ArrayJson("[0:1]={t,f}", "bool") == "[true,false]", "explicit bounds are skipped");
+    Check(ArrayJson("{}", "text") == "[]", "empty array");
+    Check(ArrayJson(R"({"{\"k\":1}"})", "jsonb") == R"([{"k":1}])", "jsonb elements are embedded");
+    std::cout << std::endl;
+
+    std::cout << (failures == 0 ? "All PostgreSQL JSON conversion tests passed" : "PostgreSQL JSON conversion tests failed") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
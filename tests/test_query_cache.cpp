@@ -0,0 +1,72 @@
+// Test the query result cache behind DB::ExecCached
+#include "stnl/db/query_cache.hpp"
+#include "check.hpp"
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static bool Tables(std::string_view qSQL, std::vector<std::string> const &expected) {
+    return STNL::QueryCache::TablesOf(qSQL) == expected;
+}
+
+int main() {
+    std::cout << "=== Testing QueryCache ===" << std::endl << std::endl;
+
+    // Test 1: tables a statement reads
+    std::cout << "Test 1: TablesOf" << std::endl;
+    Check(Tables("SELECT * FROM users WHERE id = $1", {"users"}), "single table");
+    Check(Tables("SELECT * FROM a, b WHERE a.id = b.id", {"a", "b"}), "every table of a comma join");
+    Check(Tables("SELECT * FROM a x, b AS y, c", {"a", "b", "c"}), "aliases inside a comma join");
+    Check(Tables("SELECT * FROM public.users u JOIN app.orders o ON o.user_id = u.id", {"users", "orders"}), "schema-qualified names");
+    Check(Tables(R"(SELECT * FROM "Sales"."Order Lines" JOIN "Users" ON true)", {"order lines", "users"}), "quoted names");
+    Check(Tables("SELECT * FROM (SELECT id FROM a) s, b WHERE s.id IN (SELECT id FROM c)", {"a", "b", "c"}), "subqueries, the list goes on after one");
+    Check(Tables("SELECT * FROM a -- FROM b\nWHERE x = 'FROM c' /* JOIN d */", {"a"}), "comments and literals are skipped");
+    Check(Tables("SELECT * FROM a FOR UPDATE", {"a"}), "FOR UPDATE names no table");
+    Check(Tables("INSERT INTO a (id) VALUES (1) ON CONFLICT (id) DO UPDATE SET id = 2", {"a"}), "DO UPDATE names no table");
+    Check(Tables("SELECT 1", {}), "no table at all");
+    Check(Tables("SELECT * FROM", {}), "a dangling FROM is not trusted");
+    std::cout << std::endl;
+
+    // Test 2: LRU eviction
+    std::cout << "Test 2: LRU eviction" << std::endl;
+    STNL::QueryCache cache(2);
+    STNL::CacheOptions const options{.ttl = std::chrono::seconds(60), .tables = {}};
+    int loads = 0;
+    auto load = [&loads](STNL::QueryCache::Entry &entry) {
+        ++loads;
+        entry.ok = true;
+    };
+    auto get = [&](std::string const &sql) { cache.GetOrLoad(sql, options, sql, load); };
+    get("SELECT * FROM a");
+    get("SELECT * FROM b");
+    get("SELECT * FROM a"); // a is now the most recently used
+    get("SELECT * FROM c"); // evicts b
+    Check(loads == 3 && cache.GetStats().evictions == 1 && cache.GetStats().size == 2, "one entry over the limit is evicted");
+    get("SELECT * FROM a");
+    Check(loads == 3, "the recently used entry stays");
+    get("SELECT * FROM b");
+    Check(loads == 4, "the least recently used entry was the one evicted");
+    std::cout << std::endl;
+
+    // Test 3: invalidation
+    std::cout << "Test 3: Invalidation" << std::endl;
+    STNL::QueryCache joins(16);
+    loads = 0;
+    joins.GetOrLoad("join", options, "SELECT * FROM a, b", load);
+    joins.InvalidateTable("B");
+    joins.GetOrLoad("join", options, "SELECT * FROM a, b", load);
+    Check(loads == 2, "a write to the second table of a comma join evicts the entry");
+    joins.GetOrLoad("one", options, "SELECT 1", load);
+    joins.InvalidateTable("unrelated");
+    joins.GetOrLoad("one", options, "SELECT 1", load);
+    Check(loads == 4, "entries without known tables are evicted by any write");
+    joins.GetOrLoad("c", options, "SELECT * FROM c", load);
+    joins.InvalidateTable("d");
+    joins.GetOrLoad("c", options, "SELECT * FROM c", load);
+    Check(loads == 5, "writes to other tables keep the entry");
+    std::cout << std::endl;
+
+    std::cout << (failures == 0 ? "All query cache tests passed" : "Query cache tests failed") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+// Test the hashed timer wheel behind the HTTP session timeouts
+#include "stnl/core/timer_wheel.hpp"
+#include "check.hpp"
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main() {
+    std::cout << "=== Testing TimerWheel ===" << std::endl << std::endl;
+    boost::asio::io_context ioc;
+    using std::chrono::milliseconds;
+
+    // Test 1: expiry after the timeout, within a tick, and across full turns of the wheel
+    std::cout << "Test 1: Expiry" << std::endl;
+    STNL::TimerWheel wheel(ioc.get_executor(), milliseconds(10), 8);
+    std::vector<int> fired;
+    STNL::TimerWheel::Entry shortEntry;
+    STNL::TimerWheel::Entry longEntry;
+    shortEntry.callback = [&](uint64_t) { fired.push_back(1); };
+    longEntry.callback = [&](uint64_t) { fired.push_back(2); };
+    wheel.Arm(shortEntry, milliseconds(25)); // 3 ticks, plus the partial one it was armed in
+    wheel.Arm(longEntry, milliseconds(200)); // 20 + 1 ticks, 2 turns of an 8 slot wheel
+    Check(wheel.Size() == 2, "two entries armed");
+    for (int i = 0; i < 3; ++i) { wheel.Tick(); }
+    Check(fired.empty(), "nothing due before the timeout, even if the first tick comes right after Arm");
+    wheel.Tick();
+    Check(fired == std::vector<int>{1}, "short entry fires on its tick");
+    for (int i = 4; i < 20; ++i) { wheel.Tick(); }
+    Check(fired.size() == 1, "long entry survives the turns before it is due");
+    wheel.Tick();
+    Check(fired == std::vector<int>{1, 2} && wheel.Size() == 0, "long entry fires after 21 ticks");
+    std::cout << std::endl;
+
+    // Test 2: re-arming replaces the pending expiry, cancelling removes it
+    std::cout << "Test 2: Re-arm and cancel" << std::endl;
+    uint64_t seen = 0;
+    shortEntry.callback = [&](uint64_t sequence) { seen = sequence; };
+    uint64_t const first = wheel.Arm(shortEntry, milliseconds(10));
+    uint64_t const second = wheel.Arm(shortEntry, milliseconds(30));
+    Check(first != second && wheel.Size() == 1, "re-arming keeps one entry with a new sequence");
+    wheel.Tick();
+    wheel.Tick();
+    Check(seen == 0, "the replaced expiry does not fire");
+    wheel.Tick();
+    wheel.Tick();
+    Check(seen == second, "the new expiry fires with its sequence");
+    wheel.Arm(shortEntry, milliseconds(10));
+    wheel.Cancel(shortEntry);
+    wheel.Cancel(shortEntry);
+    Check(wheel.Tick() == 0 && wheel.Size() == 0, "cancelled entries never fire, cancelling twice is harmless");
+    std::cout << std::endl;
+
+    // Test 3: many entries sharing slots
+    std::cout << "Test 3: Many entries" << std::endl;
+    std::vector<STNL::TimerWheel::Entry> entries(10000);
+    size_t count = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        entries[i].callback = [&](uint64_t) { ++count; };
+        wheel.Arm(entries[i], milliseconds(10 * ((i % 50) + 1)));
+    }
+    for (size_t i = 0; i < entries.size(); i += 2) { wheel.Cancel(entries[i]); }
+    size_t fires = 0;
+    for (int i = 0; i < 51; ++i) { fires += wheel.Tick(); }
+    Check(count == 5000 && fires == 5000 && wheel.Size() == 0, "every armed entry fired once");
+    std::cout << std::endl;
+
+    // Test 4: ticking on the executor
+    std::cout << "Test 4: Started wheel" << std::endl;
+    bool expired = false;
+    shortEntry.callback = [&](uint64_t) {
+        expired = true;
+        wheel.Stop();
+    };
+    wheel.Start();
+    auto const start = std::chrono::steady_clock::now();
+    wheel.Arm(shortEntry, milliseconds(50));
+    ioc.run_for(std::chrono::seconds(2));
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    Check(expired && elapsed >= milliseconds(50) && elapsed < std::chrono::seconds(2), "expires on the executor, not before the timeout");
+    std::cout << std::endl;
+
+    std::cout << (failures == 0 ? "All timer wheel tests passed" : "Timer wheel tests failed") << std::endl;
+    return failures == 0 ? 0 : 1;
+}